@@ -0,0 +1,240 @@
+/*
+ * minimal benchmark harness shared by the bench executables.
+ *
+ * benchmarks register with BENCH(name) and report one Result per
+ * measured case. results are printed as a table, or with --json as one
+ * JSON object per line, e.g.
+ *
+ *   {"suite":"book","name":"cancel","engine":"ladder","orders":100000,
+ *    "ops":50000,"ns_per_op":97.1,"ops_per_sec":10298661,
+ *    "p50_ns":81.2,"p99_ns":240.5,"p999_ns":1002.3}
+ *
+ * options:
+ *   --json             JSON lines instead of a table
+ *   --out FILE         write the results to FILE instead of stdout
+ *   --filter TEXT      only run benchmarks whose name contains TEXT
+ *   --max-orders N     largest book, sizes go 1k, 10k, ... up to N
+ *   --seed N           seed of the generated orders
+ *
+ * numbers are only meaningful with -DCMAKE_BUILD_TYPE=Release
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <book/latency.h>
+
+namespace bench {
+
+typedef std::chrono::steady_clock Clock;
+
+/* name and value of a parameter of a case, e.g. {"orders", 1000} */
+typedef std::vector<std::pair<std::string, std::string>> Params;
+
+struct Result {
+  std::string name;
+  Params params;
+  size_t ops;
+  double ns;
+  bool has_latency;
+  double p50_ns;
+  double p99_ns;
+  double p999_ns;
+};
+
+/* times single operations with read_tsc(), for percentiles */
+class Sampler {
+public:
+  explicit Sampler(double ticks_per_ns) : ticks_per_ns_(ticks_per_ns) {}
+
+  void start() { start_ = book::read_tsc(); }
+  void stop() { histogram_.record(book::read_tsc() - start_); }
+
+  double percentile_ns(double p) const {
+    return histogram_.percentile(p) / ticks_per_ns_;
+  }
+
+  size_t count() const { return histogram_.count(); }
+  const book::LatencyHistogram& histogram() const { return histogram_; }
+
+private:
+  double ticks_per_ns_;
+  uint64_t start_;
+  book::LatencyHistogram histogram_;
+};
+
+class Runner {
+public:
+  Runner(const char* suite, size_t max_orders, unsigned seed, double ticks_per_ns) :
+    suite_(suite), max_orders_(max_orders), seed_(seed), ticks_per_ns_(ticks_per_ns) {}
+
+  unsigned seed() const { return seed_; }
+
+  /* book sizes from 1k to --max-orders, by powers of ten */
+  std::vector<size_t> book_sizes() const {
+    std::vector<size_t> sizes;
+    for(size_t n = 1000; n <= max_orders_; n *= 10)
+      sizes.push_back(n);
+    return sizes;
+  }
+
+  /* for Sampler */
+  double ticks_per_ns() const { return ticks_per_ns_; }
+
+  /* throughput only */
+  void report(const std::string& name, const Params& params,
+    size_t ops, Clock::duration elapsed)
+  {
+    Result result = { name, params, ops, ns(elapsed), false, 0, 0, 0 };
+    results_.push_back(result);
+  }
+
+  /* throughput, and percentiles of the operations sampled */
+  void report(const std::string& name, const Params& params,
+    size_t ops, Clock::duration elapsed, const Sampler& sampler)
+  {
+    report(name, params, ops, ns(elapsed), sampler.histogram());
+  }
+
+  /* throughput, and percentiles of a histogram of read_tsc() ticks */
+  void report(const std::string& name, const Params& params,
+    size_t ops, double elapsed_ns, const book::LatencyHistogram& ticks)
+  {
+    Result result = { name, params, ops, elapsed_ns, ticks.count() > 0,
+      ticks.percentile(50) / ticks_per_ns_, ticks.percentile(99) / ticks_per_ns_,
+      ticks.percentile(99.9) / ticks_per_ns_ };
+    results_.push_back(result);
+  }
+
+  const char* suite() const { return suite_; }
+  std::vector<Result>& results() { return results_; }
+
+private:
+  static double ns(Clock::duration elapsed) {
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+  }
+
+  const char* suite_;
+  size_t max_orders_;
+  unsigned seed_;
+  double ticks_per_ns_;
+  std::vector<Result> results_;
+};
+
+typedef void (*BenchFn)(Runner&);
+
+inline std::vector<std::pair<const char*, BenchFn>>& registry() {
+  static std::vector<std::pair<const char*, BenchFn>> benches;
+  return benches;
+}
+
+struct Register {
+  Register(const char* name, BenchFn fn) { registry().push_back(std::make_pair(name, fn)); }
+};
+
+#define BENCH(NAME) \
+  static void NAME(bench::Runner&); \
+  static bench::Register NAME##_register(#NAME, NAME); \
+  static void NAME(bench::Runner& runner)
+
+template <class T>
+std::string str(const T& value) { return std::to_string(value); }
+
+inline std::string str(const char* value) { return value; }
+inline std::string str(const std::string& value) { return value; }
+
+inline bool is_number(const std::string& s) {
+  char* end = nullptr;
+  strtod(s.c_str(), &end);
+  return !s.empty() && *end == '\0';
+}
+
+inline void print_json(FILE* out, const char* suite, const Result& r) {
+  fprintf(out, "{\"suite\":\"%s\",\"name\":\"%s\"", suite, r.name.c_str());
+
+  for(auto it = r.params.begin(); it != r.params.end(); ++it) {
+    if(is_number(it->second))
+      fprintf(out, ",\"%s\":%s", it->first.c_str(), it->second.c_str());
+    else
+      fprintf(out, ",\"%s\":\"%s\"", it->first.c_str(), it->second.c_str());
+  }
+
+  fprintf(out, ",\"ops\":%zu,\"ns_per_op\":%.1f,\"ops_per_sec\":%.0f",
+    r.ops, r.ns / r.ops, r.ops / r.ns * 1e9);
+
+  if(r.has_latency)
+    fprintf(out, ",\"p50_ns\":%.1f,\"p99_ns\":%.1f,\"p999_ns\":%.1f",
+      r.p50_ns, r.p99_ns, r.p999_ns);
+
+  fprintf(out, "}\n");
+}
+
+inline void print_row(FILE* out, const Result& r) {
+  std::string params;
+  for(auto it = r.params.begin(); it != r.params.end(); ++it)
+    params += it->first + "=" + it->second + " ";
+
+  fprintf(out, "%-20s %-52s %10.1f ns/op", r.name.c_str(), params.c_str(), r.ns / r.ops);
+
+  if(r.has_latency)
+    fprintf(out, "   p50 %8.1f  p99 %8.1f  p99.9 %8.1f", r.p50_ns, r.p99_ns, r.p999_ns);
+
+  fprintf(out, "\n");
+}
+
+inline int main(int argc, char** argv, const char* suite) {
+  bool json = false;
+  const char* out_path = nullptr;
+  const char* filter = nullptr;
+  size_t max_orders = 100000;
+  unsigned seed = 42;
+
+  for(int i = 1; i < argc; ++i) {
+    if(!strcmp(argv[i], "--json")) json = true;
+    else if(!strcmp(argv[i], "--out") && i + 1 < argc) out_path = argv[++i];
+    else if(!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+    else if(!strcmp(argv[i], "--max-orders") && i + 1 < argc) max_orders = strtoul(argv[++i], nullptr, 10);
+    else if(!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 10);
+    else {
+      fprintf(stderr, "usage: %s [--json] [--out FILE] [--filter TEXT] "
+        "[--max-orders N] [--seed N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  FILE* out = stdout;
+  if(out_path && !(out = fopen(out_path, "w"))) {
+    perror(out_path);
+    return 1;
+  }
+
+  Runner runner(suite, max_orders, seed, book::tsc_ticks_per_ns());
+
+  for(auto it = registry().begin(); it != registry().end(); ++it) {
+    if(filter && !strstr(it->first, filter)) continue;
+
+    it->second(runner);
+
+    for(auto r = runner.results().begin(); r != runner.results().end(); ++r) {
+      if(json) print_json(out, suite, *r);
+      else print_row(out, *r);
+    }
+
+    fflush(out);
+    runner.results().clear();
+  }
+
+  if(out != stdout)
+    fclose(out);
+
+  return 0;
+}
+
+}
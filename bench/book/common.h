@@ -0,0 +1,65 @@
+/*
+ * orders, trackers and books shared by the book benchmarks.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/order.h>
+#include <book/tracker.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <utils/uint128.h>
+
+namespace book_bench {
+
+class Order :
+  public book::Order,
+  public book::plugins::SelfTradePolicyOrder,
+  public book::plugins::StopOrder {
+public:
+  Order(uint32_t user_id, bool is_bid, double price, double qty, double stop_price = 0) :
+    user_id_(user_id), is_bid_(is_bid), price_(price), qty_(qty), stop_price_(stop_price) {}
+
+  utils::uint128 order_id() const { return order_id_; }
+  void order_id(const utils::uint128& order_id) { order_id_ = order_id; }
+
+  uint32_t user_id() const { return user_id_; }
+  bool is_bid() const { return is_bid_; }
+  double qty() const { return qty_; }
+  double price() const { return price_; }
+  double funds() const { return 0; }
+  book::plugins::SelfTradePolicy stp() const { return book::plugins::stp_cancel_taker; }
+  double stop_price() const { return stop_price_; }
+
+private:
+  utils::uint128 order_id_;
+  uint32_t user_id_;
+  bool is_bid_;
+  double price_;
+  double qty_;
+  double stop_price_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+/* delivers callbacks nowhere, but counts them so they are not elided */
+template <class Storage, class Tracker, class... Plugins>
+class Book : public book::BasicOB<Storage, Tracker, Plugins...> {
+public:
+  typedef book::BasicOB<Storage, Tracker, Plugins...> Base;
+
+  explicit Book(size_t capacity = 0) : Base(1, book::TickScale(), capacity) {}
+
+  size_t callbacks_seen = 0;
+
+protected:
+  void on_callbacks(const typename Base::Callbacks& callbacks) {
+    callbacks_seen += callbacks.size();
+  }
+};
+
+}
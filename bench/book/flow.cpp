@@ -0,0 +1,59 @@
+/*
+ * replays of generated order flow, mostly cancels of orders resting near
+ * the mid, through both storage engines of OB. one stream per arrival
+ * process, as long as --max-orders.
+ */
+
+#include <flow/generator.h>
+#include <flow/replay.h>
+
+#include "../bench.h"
+#include "common.h"
+
+namespace book_bench {
+
+typedef book::BaseTracker<flow::OrderPtr> FlowTracker;
+
+template <class Storage>
+void run_flow(bench::Runner& runner, const char* engine,
+  const char* arrivals, const std::vector<flow::Event>& events)
+{
+  Book<Storage, FlowTracker> book(events.size());
+  flow::ReplayStats stats;
+  flow::replay(book, events, stats);
+
+  bench::Params params = {
+    { "engine", engine },
+    { "arrivals", arrivals },
+    { "events", bench::str(events.size()) }
+  };
+
+  /* whole stream, then each event type on its own */
+  runner.report("flow", params, stats.events,
+    bench::Clock::duration((bench::Clock::rep) stats.ns));
+
+  const char* names[] = { "flow_add", "flow_cancel", "flow_replace" };
+  for(int type = 0; type < 3; ++type) {
+    const book::LatencyHistogram& ticks = stats.latency[type];
+    double ns = ticks.mean() * ticks.count() / runner.ticks_per_ns();
+    runner.report(names[type], params, ticks.count(), ns, ticks);
+  }
+}
+
+BENCH(flow) {
+  std::vector<size_t> sizes = runner.book_sizes();
+  size_t n = sizes.empty() ? 1000 : sizes.back();
+
+  flow::Model model;
+  std::vector<flow::Event> poisson = flow::Generator(model, runner.seed()).generate(n);
+
+  model.arrivals = flow::Model::hawkes;
+  std::vector<flow::Event> hawkes = flow::Generator(model, runner.seed()).generate(n);
+
+  run_flow<book::MapStorage>(runner, "multimap", "poisson", poisson);
+  run_flow<book::LadderStorage>(runner, "ladder", "poisson", poisson);
+  run_flow<book::MapStorage>(runner, "multimap", "hawkes", hawkes);
+  run_flow<book::LadderStorage>(runner, "ladder", "hawkes", hawkes);
+}
+
+}
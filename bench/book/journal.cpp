@@ -0,0 +1,119 @@
+/*
+ * cost of journaling the inputs of a book, and of rebuilding a book from
+ * its journal, with and without delivering the callbacks, or from a
+ * snapshot.
+ */
+
+#include <cstdio>
+
+#include <book/journal.h>
+#include <book/snapshot.h>
+#include <flow/generator.h>
+#include <flow/replay.h>
+
+#include "../bench.h"
+#include "common.h"
+
+namespace book_bench {
+
+typedef book::BaseTracker<flow::OrderPtr> JournalTracker;
+typedef Book<book::Journaled<book::LadderStorage, flow::OrderCodec>, JournalTracker> JournaledBook;
+
+BENCH(journal) {
+  std::vector<size_t> sizes = runner.book_sizes();
+  size_t n = sizes.empty() ? 1000 : sizes.back();
+  std::vector<flow::Event> events = flow::Generator(flow::Model(), runner.seed()).generate(n);
+
+  const char* path = "bench.journal";
+  bench::Params params = { { "engine", "ladder" }, { "events", bench::str(n) } };
+
+  /* the same stream, without then with a journal */
+  {
+    JournaledBook book(n);
+    flow::ReplayStats stats;
+    flow::replay(book, events, stats);
+    runner.report("journal_off", params, stats.events, stats.ns, stats.latency[flow::event_add]);
+  }
+
+  {
+    JournaledBook book(n);
+    book::JournalWriter writer(path, 1);
+    book.journal().attach(&writer);
+
+    flow::ReplayStats stats;
+    flow::replay(book, events, stats);
+
+    bench::Clock::time_point start = bench::Clock::now();
+    writer.flush();
+    book.journal().detach();
+
+    runner.report("journal_on", params, stats.events, stats.ns, stats.latency[flow::event_add]);
+    runner.report("journal_flush", params, 1, bench::Clock::now() - start);
+  }
+
+  /* rebuilding the book */
+  {
+    book::JournalReader reader(path);
+    JournaledBook book(n);
+    book::JournalReplayer<JournaledBook> replayer(book);
+
+    bench::Clock::time_point start = bench::Clock::now();
+    uint64_t records = replayer.replay(reader);
+    runner.report("journal_replay", params, records, bench::Clock::now() - start);
+  }
+
+  {
+    book::JournalReader reader(path);
+    JournaledBook book(n);
+    book::JournalReplayer<JournaledBook> replayer(book);
+
+    bench::Clock::time_point start = bench::Clock::now();
+    uint64_t records = replayer.fast_forward(reader);
+    runner.report("journal_fast_forward", params, records, bench::Clock::now() - start);
+  }
+
+  std::remove(path);
+}
+
+/* books of resting orders only, saved then loaded. one op per order */
+BENCH(snapshot) {
+  std::vector<size_t> sizes = runner.book_sizes();
+  const char* path = "bench.snapshot";
+
+  for(auto n = sizes.begin(); n != sizes.end(); ++n) {
+    flow::Model model;
+    model.cancel_ratio = 0;
+    model.replace_ratio = 0;
+    model.market_share = 0;
+    model.stop_share = 0;
+    model.mean_distance = 100;
+
+    std::vector<flow::Event> events = flow::Generator(model, runner.seed()).generate(*n);
+
+    JournaledBook book(*n);
+    flow::ReplayStats stats;
+    flow::replay(book, events, stats);
+
+    bench::Params params = { { "engine", "ladder" }, { "orders", bench::str(book.order_count()) } };
+
+    {
+      bench::Clock::time_point start = bench::Clock::now();
+      book::SnapshotWriter<flow::OrderCodec> out;
+      book.save(out);
+      out.write(path, 1, 0);
+      runner.report("snapshot_save", params, book.order_count(), bench::Clock::now() - start);
+    }
+
+    {
+      bench::Clock::time_point start = bench::Clock::now();
+      book::SnapshotReader<flow::OrderCodec> in(path);
+      JournaledBook loaded(*n);
+      loaded.load(in);
+      runner.report("snapshot_load", params, loaded.order_count(), bench::Clock::now() - start);
+    }
+  }
+
+  std::remove(path);
+}
+
+}
@@ -0,0 +1,9 @@
+/*
+ * book_bench: benchmarks of OB and its plugins, see ../bench.h
+ */
+
+#include "../bench.h"
+
+int main(int argc, char** argv) {
+  return bench::main(argc, argv, "book");
+}
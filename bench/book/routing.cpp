@@ -0,0 +1,71 @@
+/*
+ * routing round trips: a market order hits a market maker of another
+ * exchange, is routed, and the venue answers right away.
+ */
+
+#include <book/plugins/routable.h>
+
+#include "../bench.h"
+#include "common.h"
+
+namespace book_bench {
+
+#define MM_USER 100
+#define MM_EXCHANGE 7
+
+struct RoutingTracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::RoutableTracker<OrderPtr>
+{
+  RoutingTracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::RoutableTracker<OrderPtr>(order) {}
+};
+
+/* the venue accepts every request as soon as it is sent */
+class RoutingBook : public Book<book::LadderStorage, RoutingTracker,
+  book::plugins::SelfTradePolicyPlugin<RoutingTracker>,
+  book::plugins::RoutablePlugin<RoutingTracker>> {
+public:
+  typedef book::plugins::RoutablePlugin<RoutingTracker>::RoutingRequest RoutingRequest;
+
+  RoutingBook() { register_market_maker(MM_USER, MM_EXCHANGE); }
+
+  size_t routed = 0;
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    ++routed;
+    on_routing_success(request.request_id);
+  }
+};
+
+BENCH(routing) {
+  const size_t round_trips = 2000;
+
+  RoutingBook book;
+  bench::Sampler sampler(runner.ticks_per_ns());
+  bench::Clock::duration elapsed(0);
+
+  for(size_t i = 0; i < round_trips; ++i) {
+    OrderPtr maker = std::make_shared<Order>(MM_USER, false, 1000.0, 1.0);
+    maker->order_id(utils::uint128(0, 2 * i));
+    book.add(maker);
+
+    OrderPtr taker = std::make_shared<Order>(1, true, 0, 1.0);
+    taker->order_id(utils::uint128(0, 2 * i + 1));
+
+    bench::Clock::time_point start = bench::Clock::now();
+    sampler.start();
+    book.add(taker);
+    sampler.stop();
+    elapsed += bench::Clock::now() - start;
+  }
+
+  bench::Params params = { { "engine", "ladder" } };
+  runner.report("routing_round_trip", params, book.routed, elapsed, sampler);
+}
+
+}
@@ -0,0 +1,52 @@
+/*
+ * stop-order cascades: every fill moves the market price onto the
+ * next stop, which triggers and fills in turn.
+ */
+
+#include "../bench.h"
+#include "common.h"
+
+namespace book_bench {
+
+typedef book::BaseTracker<OrderPtr> StopTracker;
+
+template <class Storage>
+void run_cascade(bench::Runner& runner, const char* engine, size_t stops, size_t rounds) {
+  typedef Book<Storage, StopTracker, book::plugins::StopOrdersPlugin<StopTracker>> StopBook;
+
+  bench::Sampler sampler(runner.ticks_per_ns());
+  bench::Clock::duration elapsed(0);
+
+  for(size_t r = 0; r < rounds; ++r) {
+    StopBook book(2 * stops);
+    book.set_market_price(1000.0);
+
+    /* one ask per tick above the market, and a stop buy on each of them */
+    for(size_t i = 1; i <= stops; ++i) {
+      book.add(std::make_shared<Order>(1, false, 1000.0 + i, 1.0));
+      book.add(std::make_shared<Order>(2, true, 0, 1.0, 1000.0 + i));
+    }
+
+    OrderPtr trigger = std::make_shared<Order>(3, true, 0, 1.0);
+
+    bench::Clock::time_point start = bench::Clock::now();
+    sampler.start();
+    book.add(trigger);
+    sampler.stop();
+    elapsed += bench::Clock::now() - start;
+  }
+
+  bench::Params params = { { "engine", engine }, { "stops", bench::str(stops) } };
+
+  /* one op per stop triggered */
+  runner.report("stop_cascade", params, stops * rounds, elapsed, sampler);
+}
+
+BENCH(stop_cascade) {
+  run_cascade<book::MapStorage>(runner, "multimap", 100, 100);
+  run_cascade<book::LadderStorage>(runner, "ladder", 100, 100);
+  run_cascade<book::MapStorage>(runner, "multimap", 1000, 10);
+  run_cascade<book::LadderStorage>(runner, "ladder", 1000, 10);
+}
+
+}
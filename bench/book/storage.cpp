@@ -0,0 +1,167 @@
+/*
+ * add, cancel and replace on books of 1k resting orders and up, and
+ * sweeps of deep books, for both storage engines of OB.
+ */
+
+#include <algorithm>
+#include <random>
+
+#include "../bench.h"
+#include "common.h"
+
+namespace book_bench {
+
+typedef book::BaseTracker<OrderPtr> Tracker;
+
+/* `n` orders on `levels` levels each side of 1000, bids and asks alternating */
+std::vector<OrderPtr> make_resting(size_t n, size_t levels, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> level(1, levels);
+
+  std::vector<OrderPtr> orders;
+  orders.reserve(n);
+
+  for(size_t i = 0; i < n; ++i) {
+    bool is_bid = i & 1;
+    double price = is_bid ? 1000.0 - level(rng) : 1000.0 + level(rng);
+    orders.push_back(std::make_shared<Order>(1, is_bid, price, 1.0));
+  }
+
+  return orders;
+}
+
+template <class Storage>
+void run_orders(bench::Runner& runner, const char* engine, size_t n) {
+  std::vector<OrderPtr> orders = make_resting(n, 1000, runner.seed());
+  bench::Params params = { { "engine", engine }, { "orders", bench::str(n) } };
+
+  Book<Storage, Tracker> book(n);
+
+  /* 1. build the book, nothing crosses */
+  {
+    bench::Sampler sampler(runner.ticks_per_ns());
+    bench::Clock::time_point start = bench::Clock::now();
+    for(size_t i = 0; i < n; ++i) {
+      sampler.start();
+      book.add(orders[i]);
+      sampler.stop();
+    }
+    runner.report("add", params, n, bench::Clock::now() - start, sampler);
+  }
+
+  std::vector<OrderPtr> shuffled(orders);
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(runner.seed()));
+  shuffled.resize(n / 2);
+
+  /* 2. grow a random half of the orders */
+  {
+    bench::Sampler sampler(runner.ticks_per_ns());
+    bench::Clock::time_point start = bench::Clock::now();
+    for(size_t i = 0; i < shuffled.size(); ++i) {
+      sampler.start();
+      book.replace(shuffled[i], 1.0);
+      sampler.stop();
+    }
+    runner.report("replace", params, shuffled.size(), bench::Clock::now() - start, sampler);
+  }
+
+  /* 3. cancel them */
+  {
+    bench::Sampler sampler(runner.ticks_per_ns());
+    bench::Clock::time_point start = bench::Clock::now();
+    for(size_t i = 0; i < shuffled.size(); ++i) {
+      sampler.start();
+      book.cancel(shuffled[i], book::user_cancel);
+      sampler.stop();
+    }
+    runner.report("cancel", params, shuffled.size(), bench::Clock::now() - start, sampler);
+  }
+}
+
+BENCH(orders) {
+  std::vector<size_t> sizes = runner.book_sizes();
+  for(auto n = sizes.begin(); n != sizes.end(); ++n) {
+    run_orders<book::MapStorage>(runner, "multimap", *n);
+    run_orders<book::LadderStorage>(runner, "ladder", *n);
+  }
+}
+
+/* asks on `levels` levels with `depth` orders each, swept by market
+  buys taking `per_sweep` levels at a time */
+template <class Storage>
+void run_sweep(bench::Runner& runner, const char* engine,
+  size_t levels, size_t depth, size_t per_sweep)
+{
+  Book<Storage, Tracker> book(levels * depth);
+
+  for(size_t d = 0; d < depth; ++d)
+    for(size_t l = 0; l < levels; ++l)
+      book.add(std::make_shared<Order>(1, false, 1000.0 + l, 1.0));
+
+  bench::Params params = {
+    { "engine", engine },
+    { "levels", bench::str(levels) },
+    { "depth", bench::str(depth) },
+    { "levels_per_sweep", bench::str(per_sweep) }
+  };
+
+  /* one op per maker filled */
+  bench::Sampler sampler(runner.ticks_per_ns());
+  bench::Clock::time_point start = bench::Clock::now();
+  while(book.asks().size() > 0) {
+    OrderPtr taker = std::make_shared<Order>(2, true, 0, (double) (per_sweep * depth));
+    sampler.start();
+    book.add(taker);
+    sampler.stop();
+  }
+
+  runner.report("sweep", params, levels * depth, bench::Clock::now() - start, sampler);
+}
+
+/* the same sweeps simulated, the book is left as it is */
+template <class Storage>
+void run_simulate_sweep(bench::Runner& runner, const char* engine,
+  size_t levels, size_t depth, size_t per_sweep)
+{
+  Book<Storage, Tracker> book(levels * depth);
+
+  for(size_t d = 0; d < depth; ++d)
+    for(size_t l = 0; l < levels; ++l)
+      book.add(std::make_shared<Order>(1, false, 1000.0 + l, 1.0));
+
+  bench::Params params = {
+    { "engine", engine },
+    { "levels", bench::str(levels) },
+    { "depth", bench::str(depth) },
+    { "levels_per_sweep", bench::str(per_sweep) }
+  };
+
+  const size_t n = 10000;
+  double qty = 0;
+
+  bench::Sampler sampler(runner.ticks_per_ns());
+  bench::Clock::time_point start = bench::Clock::now();
+  for(size_t i = 0; i < n; ++i) {
+    sampler.start();
+    qty += book.simulate_sweep(true, (double) (per_sweep * depth)).qty;
+    sampler.stop();
+  }
+
+  runner.report("simulate_sweep", params, n, bench::Clock::now() - start, sampler);
+
+  if(qty != (double) (n * per_sweep * depth))
+    fprintf(stderr, "simulate_sweep: unexpected qty %f\n", qty);
+}
+
+BENCH(sweep) {
+  run_sweep<book::MapStorage>(runner, "multimap", 1000, 10, 10);
+  run_sweep<book::LadderStorage>(runner, "ladder", 1000, 10, 10);
+  run_sweep<book::MapStorage>(runner, "multimap", 1000, 10, 1000);
+  run_sweep<book::LadderStorage>(runner, "ladder", 1000, 10, 1000);
+
+  run_simulate_sweep<book::MapStorage>(runner, "multimap", 1000, 10, 10);
+  run_simulate_sweep<book::LadderStorage>(runner, "ladder", 1000, 10, 10);
+  run_simulate_sweep<book::MapStorage>(runner, "multimap", 1000, 10, 1000);
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * depth_bench: updates of depth::Depth at several SIZE values, see
+ * ../bench.h for the options and the output format.
+ */
+
+#include <random>
+#include <vector>
+
+#include <depth/depth.h>
+
+#include "../bench.h"
+
+namespace depth_bench {
+
+struct Resting {
+  depth::Price price;
+  depth::Quantity qty;
+  bool is_bid;
+};
+
+/* adds and closes orders within `spread` ticks of the middle, so that
+  most updates land on the visible levels and some on hidden ones */
+template <int SIZE>
+void run_updates(bench::Runner& runner, int spread, size_t ops) {
+  depth::Depth<SIZE> depth;
+  std::vector<Resting> resting;
+
+  std::mt19937 rng(runner.seed());
+  std::uniform_int_distribution<int> distance(1, spread);
+  std::uniform_int_distribution<int> action(0, 9);
+
+  for(size_t i = 0; i < 1000; ++i) {
+    bool is_bid = rng() & 1;
+    Resting r = { 1000.0 + (is_bid ? -distance(rng) : distance(rng)), 1.0 + rng() % 10, is_bid };
+    depth.add_order(r.price, r.qty, r.is_bid);
+    resting.push_back(r);
+  }
+
+  bench::Sampler sampler(runner.ticks_per_ns());
+  bench::Clock::time_point start = bench::Clock::now();
+
+  for(size_t i = 0; i < ops; ++i) {
+    if(action(rng) < 5 || resting.empty()) {
+      bool is_bid = rng() & 1;
+      Resting r = { 1000.0 + (is_bid ? -distance(rng) : distance(rng)), 1.0 + rng() % 10, is_bid };
+      sampler.start();
+      depth.add_order(r.price, r.qty, r.is_bid);
+      sampler.stop();
+      resting.push_back(r);
+    }
+
+    else {
+      size_t pos = rng() % resting.size();
+      Resting r = resting[pos];
+      resting[pos] = resting.back();
+      resting.pop_back();
+
+      sampler.start();
+      depth.close_order(r.price, r.qty, r.is_bid);
+      sampler.stop();
+    }
+
+    if(depth.changed())
+      depth.published();
+  }
+
+  bench::Params params = { { "size", bench::str(SIZE) }, { "spread", bench::str(spread) } };
+  runner.report("depth_update", params, ops, bench::Clock::now() - start, sampler);
+}
+
+BENCH(depth_update) {
+  const size_t ops = 200000;
+
+  run_updates<5>(runner, 20, ops);
+  run_updates<10>(runner, 20, ops);
+  run_updates<30>(runner, 50, ops);
+  run_updates<100>(runner, 150, ops);
+}
+
+}
+
+int main(int argc, char** argv) {
+  return bench::main(argc, argv, "depth");
+}
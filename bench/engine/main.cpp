@@ -0,0 +1,9 @@
+/*
+ * engine_bench: throughput of the multi-symbol engine, see ../bench.h
+ */
+
+#include "../bench.h"
+
+int main(int argc, char** argv) {
+  return bench::main(argc, argv, "engine");
+}
@@ -0,0 +1,233 @@
+/*
+ * generated flow of many symbols through the engine, one case per shard
+ * count from 1 up to a shard per spare core, against the same books run
+ * on the calling thread without queues. --max-orders is the number of
+ * events, spread evenly over the symbols, or by a Zipf law with the
+ * symbols left where they are or moved by Engine::rebalance().
+ */
+
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/tracker.h>
+#include <engine/engine.h>
+#include <flow/generator.h>
+#include <flow/replay.h>
+
+#include "../bench.h"
+
+namespace engine_bench {
+
+typedef book::BaseTracker<flow::OrderPtr> Tracker;
+typedef book::LadderOB<Tracker> OB;
+typedef engine::Engine<OB> Engine;
+
+static const uint32_t SYMBOLS = 64;
+
+/* events between two rebalance() */
+static const size_t REBALANCE_EVERY = 1 << 14;
+
+/* the events of a symbol and the orders of its adds */
+struct Stream {
+  std::vector<flow::Event> events;
+  std::vector<flow::OrderPtr> orders;
+};
+
+/* symbols in the order their events arrive */
+typedef std::vector<uint32_t> Schedule;
+
+class DirectBook : public OB {
+public:
+  DirectBook(uint32_t symbol_id, size_t capacity) :
+    OB(symbol_id, book::TickScale(), capacity), callbacks(0) {}
+
+  size_t callbacks;
+
+protected:
+  void on_callbacks(const Callbacks& cbs) { callbacks += cbs.size(); }
+};
+
+/* one event per symbol in turn */
+Schedule round_robin(size_t n) {
+  Schedule schedule(n);
+  for(size_t i = 0; i < n; ++i)
+    schedule[i] = i % SYMBOLS;
+  return schedule;
+}
+
+/* symbol s drawn with a weight of 1 / (s + 1)^exponent */
+Schedule zipf(size_t n, double exponent, unsigned seed) {
+  std::vector<double> weights;
+  for(uint32_t s = 0; s < SYMBOLS; ++s)
+    weights.push_back(1.0 / std::pow(s + 1.0, exponent));
+
+  std::mt19937 rng(seed);
+  std::discrete_distribution<uint32_t> symbol(weights.begin(), weights.end());
+
+  Schedule schedule(n);
+  for(size_t i = 0; i < n; ++i)
+    schedule[i] = symbol(rng);
+  return schedule;
+}
+
+/* as many events for each symbol as `schedule` needs */
+std::vector<Stream> make_streams(const Schedule& schedule, unsigned seed) {
+  std::vector<size_t> counts(SYMBOLS, 0);
+  for(auto it = schedule.begin(); it != schedule.end(); ++it)
+    ++counts[*it];
+
+  flow::Model model;
+  std::vector<Stream> streams(SYMBOLS);
+
+  for(uint32_t s = 0; s < SYMBOLS; ++s) {
+    streams[s].events = flow::Generator(model, seed + s).generate(counts[s]);
+    for(auto it = streams[s].events.begin(); it != streams[s].events.end(); ++it)
+      if(it->type == flow::event_add)
+        streams[s].orders.push_back(std::make_shared<flow::Order>(*it));
+  }
+
+  return streams;
+}
+
+/* the events of the streams in the order of `schedule` */
+template <class Fn>
+void interleave(const std::vector<Stream>& streams, const Schedule& schedule, Fn&& fn) {
+  std::vector<size_t> next(streams.size(), 0);
+  std::vector<size_t> next_add(streams.size(), 0);
+
+  for(auto it = schedule.begin(); it != schedule.end(); ++it) {
+    uint32_t s = *it;
+    const flow::Event& event = streams[s].events[next[s]++];
+    const flow::OrderPtr& order = event.type == flow::event_add ?
+      streams[s].orders[next_add[s]++] : streams[s].orders[event.order_id];
+    fn(s, event, order);
+  }
+}
+
+void run_direct(bench::Runner& runner, const char* load,
+  const std::vector<Stream>& streams, const Schedule& schedule)
+{
+  std::vector<std::unique_ptr<DirectBook>> books;
+  for(uint32_t s = 0; s < SYMBOLS; ++s)
+    books.emplace_back(new DirectBook(s, streams[s].events.size()));
+
+  bench::Clock::time_point start = bench::Clock::now();
+
+  interleave(streams, schedule, [&](uint32_t s, const flow::Event& event, const flow::OrderPtr& order) {
+    switch(event.type) {
+      case flow::event_add: books[s]->add(order); break;
+      case flow::event_cancel: books[s]->cancel(order, book::user_cancel); break;
+      default: books[s]->replace(order, event.qty);
+    }
+  });
+
+  bench::Params params = {
+    { "load", load },
+    { "mode", "direct" },
+    { "shards", "0" },
+    { "symbols", bench::str(SYMBOLS) }
+  };
+
+  runner.report("engine", params, schedule.size(), bench::Clock::now() - start);
+}
+
+void run_engine(bench::Runner& runner, const char* load, const std::vector<Stream>& streams,
+  const Schedule& schedule, size_t shards, bool rebalance)
+{
+  /* shard i on core i + 1, core 0 is left to the gateway */
+  engine::EngineConfig config;
+  config.shards = shards;
+  for(size_t i = 0; i < shards; ++i)
+    config.cores.push_back((int) ((i + 1) % std::max(1u, std::thread::hardware_concurrency())));
+
+  Engine engine(config);
+  for(uint32_t s = 0; s < SYMBOLS; ++s)
+    engine.add_symbol(s, streams[s].events.size());
+
+  std::atomic<bool> done(false);
+  std::thread drain([&]() {
+    size_t n = 0;
+    for(;;) {
+      bool stopped = done.load();
+      size_t polled = 0;
+      for(size_t shard = 0; shard < engine.shard_count(); ++shard)
+        polled += engine.poll(shard, [&](const Engine::Output&) { ++n; });
+
+      if(stopped && polled == 0) break;
+      if(polled == 0) std::this_thread::yield();
+    }
+  });
+
+  engine.start();
+  bench::Clock::time_point start = bench::Clock::now();
+
+  size_t i = 0, migrations = 0;
+  interleave(streams, schedule, [&](uint32_t s, const flow::Event& event, const flow::OrderPtr& order) {
+    switch(event.type) {
+      case flow::event_add: engine.add(s, order); break;
+      case flow::event_cancel: engine.cancel(s, order); break;
+      default: engine.replace(s, order, event.qty);
+    }
+
+    if(rebalance && ++i % REBALANCE_EVERY == 0)
+      migrations += engine.rebalance();
+  });
+
+  /* until every command has run */
+  engine.stop();
+  bench::Clock::duration elapsed = bench::Clock::now() - start;
+
+  done = true;
+  drain.join();
+
+  bench::Params params = {
+    { "load", load },
+    { "mode", rebalance ? "rebalanced" : "static" },
+    { "shards", bench::str(shards) },
+    { "symbols", bench::str(SYMBOLS) },
+    { "migrations", bench::str(migrations) },
+    { "submit_stalls", bench::str(engine.submit_stalls()) }
+  };
+
+  runner.report("engine", params, schedule.size(), elapsed);
+}
+
+size_t max_shards() {
+  size_t cores = std::thread::hardware_concurrency();
+  return cores > 1 ? cores - 1 : 1;
+}
+
+size_t events_of(bench::Runner& runner) {
+  std::vector<size_t> sizes = runner.book_sizes();
+  return std::max<size_t>(sizes.empty() ? 1000 : sizes.back(), SYMBOLS);
+}
+
+BENCH(shards) {
+  Schedule schedule = round_robin(events_of(runner));
+  std::vector<Stream> streams = make_streams(schedule, runner.seed());
+
+  run_direct(runner, "uniform", streams, schedule);
+
+  for(size_t shards = 1; shards <= max_shards(); shards *= 2)
+    run_engine(runner, "uniform", streams, schedule, shards, false);
+}
+
+/* a few symbols take most of the flow */
+BENCH(zipf) {
+  Schedule schedule = zipf(events_of(runner), 1.1, runner.seed());
+  std::vector<Stream> streams = make_streams(schedule, runner.seed());
+
+  run_direct(runner, "zipf", streams, schedule);
+
+  for(size_t shards = 1; shards <= max_shards(); shards *= 2) {
+    run_engine(runner, "zipf", streams, schedule, shards, false);
+    if(shards > 1)
+      run_engine(runner, "zipf", streams, schedule, shards, true);
+  }
+}
+
+}
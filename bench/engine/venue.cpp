@@ -0,0 +1,171 @@
+/*
+ * routing end to end: each user order crosses a market maker of another
+ * exchange and is routed to a SimulatedVenue, which answers after its
+ * latency. time is simulated, one order per microsecond, so that the
+ * requests pending at once grow with the latency of the venue. reports
+ * routed orders per second of the calling thread, which runs the book
+ * and the venue, and the heap held per pending request at steady state,
+ * as it is released once every request is answered. requests are kept in
+ * pools that are not released, what is left is the orders they hold.
+ */
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <book/ob.h>
+#include <book/tracker.h>
+#include <book/plugins/routable.h>
+#include <engine/venue.h>
+#include <flow/order.h>
+
+#include "../bench.h"
+
+namespace engine_bench {
+
+#define MM_USER 100
+#define MM_EXCHANGE 7
+
+struct RoutingTracker :
+  public virtual book::BaseTracker<flow::OrderPtr>,
+  public book::plugins::RoutableTracker<flow::OrderPtr>
+{
+  RoutingTracker(const flow::OrderPtr& order) :
+    book::BaseTracker<flow::OrderPtr>(order),
+    book::plugins::RoutableTracker<flow::OrderPtr>(order) {}
+};
+
+typedef book::plugins::RoutablePlugin<RoutingTracker>::RoutingRequest RoutingRequest;
+typedef book::LadderOB<book::BaseTracker<flow::OrderPtr>> VenueOB;
+
+flow::OrderPtr make_order(uint32_t user_id, bool is_bid, double price, double qty, uint64_t id) {
+  flow::Event event = flow::Event();
+  event.user_id = user_id;
+  event.is_bid = is_bid;
+  event.price = price;
+  event.qty = qty;
+  event.order_id = id;
+  return std::make_shared<flow::Order>(event);
+}
+
+class Venue : public engine::SimulatedVenue<VenueOB, RoutingRequest, engine::SimulatedClock> {
+public:
+  explicit Venue(const engine::VenueConfig& config) : SimulatedVenue(config) {}
+
+protected:
+  flow::OrderPtr make_order(const RoutingRequest& request) {
+    return engine_bench::make_order(0, request.is_bid, request.price, request.qty, 0);
+  }
+};
+
+class RoutingBook : public book::LadderOB<RoutingTracker, book::plugins::RoutablePlugin<RoutingTracker>> {
+public:
+  typedef book::LadderOB<RoutingTracker, book::plugins::RoutablePlugin<RoutingTracker>> Base;
+
+  RoutingBook(Venue& venue, size_t capacity) : Base(1, book::TickScale(), capacity),
+    callbacks(0), venue_(venue) {
+    register_market_maker(MM_USER, MM_EXCHANGE);
+  }
+
+  size_t poll() {
+    return venue_.poll([this](const Venue::Response& response) {
+      if(response.succeeded()) on_routing_success(response.request_id);
+      else if(response.failed()) on_routing_failure(response.request_id);
+      else on_routing_partial_success(response.request_id, response.filled_qty);
+    });
+  }
+
+  size_t callbacks;
+
+protected:
+  void on_routing_request(const RoutingRequest& request) { venue_.submit(request); }
+  void on_callbacks(const Callbacks& cbs) { callbacks += cbs.size(); }
+
+private:
+  Venue& venue_;
+};
+
+/* bytes allocated from the heap, 0 where it cannot be told */
+size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return mallinfo2().uordblks;
+#else
+  return 0;
+#endif
+}
+
+void run_venue(bench::Runner& runner, uint64_t latency_ns, size_t n) {
+  const uint64_t interval = 1000;
+
+  engine::VenueConfig config;
+  config.latency = latency_ns;
+  config.jitter = latency_ns / 4;
+  config.reject_rate = 0.01;
+  config.seed = runner.seed();
+
+  Venue venue(config);
+  venue.book().add(make_order(0, false, 1000.0, (double) n, 0));
+
+  RoutingBook book(venue, 1024);
+
+  bench::Sampler sampler(runner.ticks_per_ns());
+  size_t peak_pending = 0;
+  size_t heap_pending = 0, pending_at = 0;
+  uint64_t now = 0;
+
+  bench::Clock::time_point start = bench::Clock::now();
+
+  for(size_t i = 0; i < n; ++i) {
+    book.add(make_order(MM_USER, false, 1000.0, 1.0, 2 * i));
+
+    flow::OrderPtr taker = make_order(1, true, 0, 1.0, 2 * i + 1);
+    sampler.start();
+    book.add(taker);
+    sampler.stop();
+
+    venue.run(now += interval);
+    book.poll();
+
+    peak_pending = std::max(peak_pending, book.pending_routing_requests());
+
+    /* steady state, half way */
+    if(i == n / 2) {
+      heap_pending = heap_in_use();
+      pending_at = book.pending_routing_requests();
+    }
+  }
+
+  while(book.pending_routing_requests() > 0) {
+    venue.run(now += interval);
+    book.poll();
+  }
+
+  bench::Clock::duration elapsed = bench::Clock::now() - start;
+
+  /* what the requests held, freed once they are answered */
+  size_t heap_drained = heap_in_use();
+  size_t heap_per_pending = pending_at && heap_pending > heap_drained ?
+    (heap_pending - heap_drained) / pending_at : 0;
+
+  bench::Params params = {
+    { "latency_us", bench::str(latency_ns / 1000) },
+    { "peak_pending", bench::str(peak_pending) },
+    { "heap_per_pending", bench::str(heap_per_pending) }
+  };
+
+  runner.report("routing_venue", params, n, elapsed, sampler);
+}
+
+BENCH(venue) {
+  const size_t n = 100000;
+
+  run_venue(runner, 10000, n);
+  run_venue(runner, 100000, n);
+  run_venue(runner, 1000000, n);
+}
+
+}
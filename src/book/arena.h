@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace book {
+
+/**
+ * \brief per-book slab allocator. small blocks are rounded up to a
+ *  size class and recycled through a free list per class, so that once
+ *  the book is warm resting, filling and cancelling orders never reach
+ *  the global allocator. slabs are only released with the arena.
+ */
+
+class BookArena {
+public:
+  static const size_t ALIGNMENT = 16;
+  static const size_t MAX_BLOCK_SIZE = 1024;
+  static const size_t MIN_SLAB_BLOCKS = 32;
+  static const size_t MAX_SLAB_BLOCKS = 4096;
+
+  struct Counters {
+    uint64_t allocations;          /* blocks handed out */
+    uint64_t deallocations;        /* blocks given back */
+    uint64_t slab_allocations;     /* global allocations to grow the arena */
+    uint64_t oversize_allocations; /* too large for a size class, forwarded */
+    size_t bytes_reserved;         /* total size of the slabs */
+
+    uint64_t in_use() const { return allocations - deallocations; }
+
+    /* calls to the global allocator made on behalf of the book */
+    uint64_t global_allocations() const {
+      return slab_allocations + oversize_allocations;
+    }
+  };
+
+  BookArena(size_t capacity = 0) : capacity_(capacity), counters_() {}
+
+  ~BookArena() {
+    for(auto it = slabs_.begin(); it != slabs_.end(); ++it)
+      ::operator delete(*it);
+  }
+
+  BookArena(const BookArena&) = delete;
+  BookArena& operator=(const BookArena&) = delete;
+
+  void* allocate(size_t size) {
+    if(size > MAX_BLOCK_SIZE) {
+      ++counters_.oversize_allocations;
+      return ::operator new(size);
+    }
+
+    SizeClass& sc = classes_[class_of(size)];
+
+    if(!sc.free_list)
+      grow(sc, class_of(size));
+
+    FreeBlock* block = sc.free_list;
+    sc.free_list = block->next;
+    --sc.free_count;
+
+    ++counters_.allocations;
+    return block;
+  }
+
+  void deallocate(void* p, size_t size) {
+    if(size > MAX_BLOCK_SIZE) {
+      ::operator delete(p);
+      return;
+    }
+
+    SizeClass& sc = classes_[class_of(size)];
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = sc.free_list;
+    sc.free_list = block;
+    ++sc.free_count;
+
+    ++counters_.deallocations;
+  }
+
+  /**
+   * \brief pre-reserves `blocks` free blocks in every size class in use,
+   *  and makes the first slab of the other classes at least that large
+   */
+  void reserve(size_t blocks) {
+    if(blocks > capacity_)
+      capacity_ = blocks;
+
+    for(size_t i = 0; i < NUM_CLASSES; ++i) {
+      SizeClass& sc = classes_[i];
+      if(sc.slab_blocks != 0 && sc.free_count < blocks)
+        carve(sc, i, blocks - sc.free_count);
+    }
+  }
+
+  size_t capacity() const { return capacity_; }
+  const Counters& counters() const { return counters_; }
+
+private:
+  static const size_t NUM_CLASSES = MAX_BLOCK_SIZE / ALIGNMENT;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SizeClass {
+    SizeClass() : free_list(nullptr), free_count(0), slab_blocks(0) {}
+
+    FreeBlock* free_list;
+    size_t free_count;
+    size_t slab_blocks; /* size of the next slab, 0 until first use */
+  };
+
+  static size_t class_of(size_t size) {
+    return size == 0 ? 0 : (size - 1) / ALIGNMENT;
+  }
+
+  static size_t block_size(size_t cls) {
+    return (cls + 1) * ALIGNMENT;
+  }
+
+  /* slabs double in size, starting from the reserved capacity */
+  void grow(SizeClass& sc, size_t cls) {
+    if(sc.slab_blocks == 0)
+      sc.slab_blocks = capacity_ > MIN_SLAB_BLOCKS ? capacity_ : MIN_SLAB_BLOCKS;
+
+    carve(sc, cls, sc.slab_blocks);
+
+    if(sc.slab_blocks < MAX_SLAB_BLOCKS)
+      sc.slab_blocks *= 2;
+  }
+
+  void carve(SizeClass& sc, size_t cls, size_t blocks) {
+    const size_t size = block_size(cls);
+    char* slab = static_cast<char*>(::operator new(size * blocks));
+
+    slabs_.push_back(slab);
+    ++counters_.slab_allocations;
+    counters_.bytes_reserved += size * blocks;
+
+    /* thread the free list through the new slab, lowest address first */
+    for(size_t i = blocks; i-- > 0;) {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * size);
+      block->next = sc.free_list;
+      sc.free_list = block;
+    }
+
+    sc.free_count += blocks;
+  }
+
+  size_t capacity_;
+  SizeClass classes_[NUM_CLASSES];
+  std::vector<void*> slabs_;
+  Counters counters_;
+};
+
+
+/**
+ * \brief STL allocator drawing from a BookArena. a default constructed
+ *  allocator has no arena and uses the global allocator, so containers
+ *  can still be used outside of a book
+ */
+
+template <class T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  ArenaAllocator(BookArena* arena = nullptr) : arena_(arena) {}
+
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+  T* allocate(size_t n) {
+    if(!arena_)
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if(!arena_)
+      return ::operator delete(p);
+    arena_->deallocate(p, n * sizeof(T));
+  }
+
+  BookArena* arena() const { return arena_; }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& rhs) const { return arena_ == rhs.arena(); }
+
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& rhs) const { return arena_ != rhs.arena(); }
+
+private:
+  BookArena* arena_;
+};
+
+
+/**
+ * \brief virtual base of OB and of the plugins. being a virtual base,
+ *  the arena is constructed before any plugin, and plugins can build
+ *  their containers on it in their constructors
+ */
+
+class ArenaOwner {
+public:
+  BookArena& arena() { return arena_; }
+  const BookArena& arena() const { return arena_; }
+
+private:
+  BookArena arena_;
+};
+
+}
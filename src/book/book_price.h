@@ -24,11 +24,17 @@
 
 namespace book {
 
-class BookPrice {
+/**
+ * \brief price of one side of the book. compares by priority:
+ *  a < b when a is matched before b. market (0) comes first
+ */
+
+template <class Price>
+class BasicBookPrice {
 public:
-  BookPrice(bool is_bid, double price) : is_bid_(is_bid), price_(price) {}
+  BasicBookPrice(bool is_bid, Price price) : is_bid_(is_bid), price_(price) {}
 
-  bool matches(double rhs) const {
+  bool matches(Price rhs) const {
     if(price_ == rhs)
       return true;
     if(is_bid_)
@@ -36,7 +42,7 @@ public:
     return price_ < rhs || rhs == 0;
   }
 
-  bool operator <(double rhs) const {
+  bool operator <(Price rhs) const {
     if(price_ == 0)
       return rhs != 0;
     else if(rhs == 0)
@@ -47,43 +53,43 @@ public:
       return price_ < rhs;
   }
 
-  bool operator ==(double rhs) const {
+  bool operator ==(Price rhs) const {
     return price_ == rhs;
   }
 
-  bool operator !=(double rhs) const {
+  bool operator !=(Price rhs) const {
     return !(price_ == rhs);
   }
 
-  bool operator > (double rhs) const {
+  bool operator > (Price rhs) const {
     return price_!= 0 && ((rhs == 0) || (is_bid_ ? (rhs > price_) : (price_ > rhs)));
   }
 
-  bool operator <=(double rhs) const {
+  bool operator <=(Price rhs) const {
     return *this < rhs || *this == rhs;
   }
 
-  bool operator >=(double rhs) const {
+  bool operator >=(Price rhs) const {
     return *this > rhs || *this == rhs;
   }
 
-  bool operator <(const BookPrice & rhs) const {
+  bool operator <(const BasicBookPrice & rhs) const {
     return *this < rhs.price_;
   }
 
-  bool operator ==(const BookPrice & rhs) const {
+  bool operator ==(const BasicBookPrice & rhs) const {
     return *this == rhs.price_;
   }
 
-  bool operator !=(const BookPrice & rhs) const {
+  bool operator !=(const BasicBookPrice & rhs) const {
     return *this != rhs.price_;
   }
 
-  bool operator >(const BookPrice & rhs) const {
+  bool operator >(const BasicBookPrice & rhs) const {
     return *this > rhs.price_;
   }
 
-  double price() const {
+  Price price() const {
     return price_;
   }
 
@@ -97,30 +103,38 @@ public:
 
 private:
   bool is_bid_;
-  double price_;
+  Price price_;
 };
 
-inline bool operator < (double price, const BookPrice & key) {
+typedef BasicBookPrice<double> BookPrice;
+
+template <class Price>
+inline bool operator < (Price price, const BasicBookPrice<Price> & key) {
   return key > price;
 }
 
-inline bool operator > (double price, const BookPrice & key) {
+template <class Price>
+inline bool operator > (Price price, const BasicBookPrice<Price> & key) {
   return key < price;
 }
 
-inline bool operator == (double price, const BookPrice & key) {
+template <class Price>
+inline bool operator == (Price price, const BasicBookPrice<Price> & key) {
   return key == price;
 }
 
-inline bool operator != (double price, const BookPrice & key) {
+template <class Price>
+inline bool operator != (Price price, const BasicBookPrice<Price> & key) {
   return key != price;
 }
 
-inline bool operator <= (double price, const BookPrice & key) {
+template <class Price>
+inline bool operator <= (Price price, const BasicBookPrice<Price> & key) {
   return key >= price;
 }
 
-inline bool operator >= (double price, const BookPrice & key) {
+template <class Price>
+inline bool operator >= (Price price, const BasicBookPrice<Price> & key) {
   return key <= price;
 }
 
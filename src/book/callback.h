@@ -52,9 +52,14 @@ static const std::vector<std::string> cbScopeStr = {
   "BROADCAST TO ALL",
 };
 
-template <typename OrderPtr, typename... Plugins> class OB;
+template <typename Storage, typename Tracker, typename... Plugins> class BasicOB;
 
-template <typename OrderPtr>
+/**
+ * \brief qty and price are in the Qty and Price types of the tracker,
+ *  avg prices are always double
+ */
+
+template <typename OrderPtr, typename Price = double, typename Qty = double>
 class Callback {
 public:
   enum CbType : uint8_t {
@@ -113,67 +118,67 @@ public:
     return os;
   }
 
-  static Callback<OrderPtr> accept(
+  static Callback accept(
     const OrderPtr& order);
 
-  static Callback<OrderPtr> reject(
+  static Callback reject(
     const OrderPtr& order,
     InsertRejectReasons reason);
 
-  static Callback<OrderPtr> fill(
+  static Callback fill(
     const OrderPtr& taker,
     const OrderPtr& maker,
-    double fill_qty,
-    double price,
+    Qty fill_qty,
+    Price price,
     double taker_avg_price,
     double maker_avg_price,
-    double taker_total_fill_qty,
-    double maker_total_fill_qty,
+    Qty taker_total_fill_qty,
+    Qty maker_total_fill_qty,
     uint8_t fill_flags);
 
-  static Callback<OrderPtr> cancel(
+  static Callback cancel(
     const OrderPtr& order,
-    double current_qty_on_book, /* used for depth */
-    double filled_qty,
+    Qty current_qty_on_book, /* used for depth */
+    Qty filled_qty,
     double avg_price,
     CancelReasons reason);
 
-  static Callback<OrderPtr> replace(
+  static Callback replace(
     const OrderPtr& order,
-    double effective_delta,
-    double current_qty_on_book,
-    double filled_qty,
+    Qty effective_delta,
+    Qty current_qty_on_book,
+    Qty filled_qty,
     double avg_price);
 
-  static Callback<OrderPtr> replace_reject(
+  static Callback replace_reject(
     const OrderPtr& order,
-    double filled_qty,
+    Qty filled_qty,
     double avg_price,
     ReplaceRejectReasons reason);
 
-  static Callback<OrderPtr> cancel_reject(
+  static Callback cancel_reject(
     const OrderPtr& order,
-    double filled_qty,
+    Qty filled_qty,
     double avg_price,
     CancelRejectReasons reason);
 
-  static Callback<OrderPtr> stop_trigger(
+  static Callback stop_trigger(
     const OrderPtr& order);
 
 
-  static Callback<OrderPtr> book_update();
+  static Callback book_update();
 
-  static Callback<OrderPtr> position_open(
+  static Callback position_open(
     uint32_t user_id,
-    double qty,
+    Qty qty,
     double base_price);
 
-  static Callback<OrderPtr> position_close(
+  static Callback position_close(
     uint32_t user_id);
 
-  static Callback<OrderPtr> position_update(
+  static Callback position_update(
     uint32_t user_id,
-    double qty,
+    Qty qty,
     double base_price);
 
   CbType type;
@@ -181,8 +186,8 @@ public:
   uint8_t reason;
   OrderPtr order;
   OrderPtr maker_order;
-  double qty;
-  double price;
+  Qty qty;
+  Price price;
   double avg_price;
   double generic_1;
   double generic_2;
@@ -191,8 +196,8 @@ public:
   CbScope scope;
 };
 
-template <class OrderPtr>
-Callback<OrderPtr>::Callback()
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>::Callback()
 : type(cb_unknown),
   flags(0),
   reason(0),
@@ -207,23 +212,23 @@ Callback<OrderPtr>::Callback()
   user_id(0),
   scope(broadcast_to_all) { }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::accept(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::accept(
   const OrderPtr& order)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_accept;
   cb.order = order;
   /* qty and avg_price updated in this cb if matched */
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::reject(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::reject(
   const OrderPtr& order,
   InsertRejectReasons reason)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_reject;
   cb.order = order;
   cb.qty = 0;
@@ -232,19 +237,19 @@ Callback<OrderPtr> Callback<OrderPtr>::reject(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::fill(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::fill(
   const OrderPtr& taker,
   const OrderPtr& maker,
-  double fill_qty,
-  double price,
+  Qty fill_qty,
+  Price price,
   double taker_avg_price,
   double maker_avg_price,
-  double taker_total_fill_qty,
-  double maker_total_fill_qty,
+  Qty taker_total_fill_qty,
+  Qty maker_total_fill_qty,
   uint8_t fill_flags)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_trade;
   cb.order = taker;
   cb.maker_order = maker;
@@ -258,15 +263,15 @@ Callback<OrderPtr> Callback<OrderPtr>::fill(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::cancel(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::cancel(
   const OrderPtr& order,
-  double current_qty_on_book,
-  double filled_qty,
+  Qty current_qty_on_book,
+  Qty filled_qty,
   double avg_price,
   CancelReasons reason)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_cancel;
   cb.order = order;
   cb.qty = filled_qty;
@@ -276,15 +281,15 @@ Callback<OrderPtr> Callback<OrderPtr>::cancel(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::replace(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::replace(
   const OrderPtr& order,
-  double effective_delta,
-  double current_qty_on_book,
-  double filled_qty,
+  Qty effective_delta,
+  Qty current_qty_on_book,
+  Qty filled_qty,
   double avg_price)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_replace;
   cb.order = order;
   cb.generic_1 = effective_delta;
@@ -295,14 +300,14 @@ Callback<OrderPtr> Callback<OrderPtr>::replace(
 }
 
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::cancel_reject(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::cancel_reject(
   const OrderPtr& order,
-  double filled_qty,
+  Qty filled_qty,
   double avg_price,
   CancelRejectReasons reason)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_cancel_reject;
   cb.order = order;
   cb.qty = filled_qty;
@@ -311,14 +316,14 @@ Callback<OrderPtr> Callback<OrderPtr>::cancel_reject(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr> Callback<OrderPtr>::replace_reject(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty> Callback<OrderPtr, Price, Qty>::replace_reject(
   const OrderPtr& order,
-  double filled_qty,
+  Qty filled_qty,
   double avg_price,
   ReplaceRejectReasons reason)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_replace_reject;
   cb.order = order;
   cb.qty = filled_qty;
@@ -327,34 +332,34 @@ Callback<OrderPtr> Callback<OrderPtr>::replace_reject(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr>
-Callback<OrderPtr>::stop_trigger(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>
+Callback<OrderPtr, Price, Qty>::stop_trigger(
 const OrderPtr& order) {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_order_stop_trigger;
   cb.order = order;
   return cb;
 }
 
 
-template <class OrderPtr>
-Callback<OrderPtr>
-Callback<OrderPtr>::book_update()
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>
+Callback<OrderPtr, Price, Qty>::book_update()
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_book_update;
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr>
-Callback<OrderPtr>::position_open(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>
+Callback<OrderPtr, Price, Qty>::position_open(
   uint32_t user_id,
-  double qty,
+  Qty qty,
   double base_price)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_position_open;
   cb.user_id = user_id;
   cb.qty = qty;
@@ -362,26 +367,26 @@ Callback<OrderPtr>::position_open(
   return cb;
 }
 
-template <class OrderPtr>
-Callback<OrderPtr>
-Callback<OrderPtr>::position_close(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>
+Callback<OrderPtr, Price, Qty>::position_close(
   uint32_t user_id)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_position_close;
   cb.user_id = user_id;
   return cb;
 }
 
 
-template <class OrderPtr>
-Callback<OrderPtr>
-Callback<OrderPtr>::position_update(
+template <class OrderPtr, class Price, class Qty>
+Callback<OrderPtr, Price, Qty>
+Callback<OrderPtr, Price, Qty>::position_update(
   uint32_t user_id,
-  double qty,
+  Qty qty,
   double base_price)
 {
-  Callback<OrderPtr> cb;
+  Callback cb;
   cb.type = cb_position_update;
   cb.user_id = user_id;
   cb.qty = qty;
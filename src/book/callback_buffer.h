@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <cassert>
+
+namespace book {
+
+/**
+ * \brief non-owning view of the callbacks of one batch. only valid
+ *  during the on_callbacks() call it is handed to; consumers copy the
+ *  callbacks they need to keep.
+ */
+
+template <class T>
+class CallbackSpan {
+public:
+  typedef T value_type;
+  typedef const T* iterator;
+  typedef const T* const_iterator;
+
+  CallbackSpan() : begin_(nullptr), end_(nullptr) {}
+  CallbackSpan(const T* begin, const T* end) : begin_(begin), end_(end) {}
+
+  const T* begin() const { return begin_; }
+  const T* end() const { return end_; }
+
+  size_t size() const { return end_ - begin_; }
+  bool empty() const { return begin_ == end_; }
+
+  const T& operator[](size_t i) const { return begin_[i]; }
+  const T& front() const { return *begin_; }
+  const T& back() const { return *(end_ - 1); }
+
+private:
+  const T* begin_;
+  const T* end_;
+};
+
+
+/**
+ * \brief callbacks of the batch being built by OB. storage is reserved
+ *  once and reused for every batch, so delivering callbacks neither
+ *  copies them nor reallocates. plugins may still edit callbacks of
+ *  the current batch in place before it is delivered.
+ *
+ *  if a batch exceeds the capacity, the buffer doubles and growths()
+ *  is incremented. a book sized for its largest sweeps never grows.
+ */
+
+template <class T>
+class CallbackBuffer {
+public:
+  typedef T value_type;
+  typedef typename std::vector<T>::iterator iterator;
+  typedef typename std::vector<T>::const_iterator const_iterator;
+
+  explicit CallbackBuffer(size_t capacity) : growths_(0) {
+    buffer_.reserve(capacity);
+  }
+
+  CallbackBuffer(const CallbackBuffer&) = delete;
+  CallbackBuffer& operator=(const CallbackBuffer&) = delete;
+
+  void push_back(const T& callback) {
+    count_growth();
+    buffer_.push_back(callback);
+  }
+
+  void push_back(T&& callback) {
+    count_growth();
+    buffer_.push_back(std::move(callback));
+  }
+
+  T& operator[](size_t i) { return buffer_[i]; }
+  const T& operator[](size_t i) const { return buffer_[i]; }
+
+  iterator begin() { return buffer_.begin(); }
+  iterator end() { return buffer_.end(); }
+  const_iterator begin() const { return buffer_.begin(); }
+  const_iterator end() const { return buffer_.end(); }
+
+  size_t size() const { return buffer_.size(); }
+  bool empty() const { return buffer_.empty(); }
+  size_t capacity() const { return buffer_.capacity(); }
+
+  /* times a batch did not fit in the reserved capacity */
+  size_t growths() const { return growths_; }
+
+  void reserve(size_t capacity) { buffer_.reserve(capacity); }
+
+  /* releases the callbacks, keeps the storage */
+  void clear() { buffer_.clear(); }
+
+  CallbackSpan<T> span() const {
+    return CallbackSpan<T>(buffer_.data(), buffer_.data() + buffer_.size());
+  }
+
+private:
+  void count_growth() {
+    if(buffer_.size() == buffer_.capacity())
+      ++growths_;
+  }
+
+  std::vector<T> buffer_;
+  size_t growths_;
+};
+
+}
@@ -43,4 +43,7 @@ const double MAKER_FEE_RATE = 0.005;
 
 const size_t DEFAULT_DEPTH_SIZE = 30;
 
+/* callbacks reserved per book. a sweep emits about three per maker */
+const size_t DEFAULT_CALLBACK_CAPACITY = 1024;
+
 }
\ No newline at end of file
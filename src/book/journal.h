@@ -0,0 +1,768 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include <utils/uint128.h>
+
+#include "types.h"
+#include "latency.h"
+
+namespace book {
+
+/**
+ * \brief write-ahead journal of the inputs of a book: add, cancel,
+ *  replace, set_market_price, routing responses and advance_time.
+ *  replaying a journal into an empty book of the same
+ *  configuration rebuilds it exactly, with the same callbacks.
+ *
+ *  a file is a JournalFileHeader then records, each a JournalRecordHeader
+ *  followed by `size` bytes of payload. orders are encoded by a Codec:
+ *
+ *    static void encode(const OrderPtr& order, JournalEncoder& out);
+ *    static OrderPtr decode(JournalDecoder& in);
+ *
+ *  cancels and replaces refer to orders by order_id(), which must be
+ *  unique among the orders of a journaled book. only calls made on the
+ *  book from outside are journaled; what plugins do in response is
+ *  replayed by the plugins.
+ *
+ *  the adds and cancels of add_batch() and cancel_batch() are between a
+ *  journal_add_batch or journal_cancel_batch record, which keeps whether
+ *  book updates were coalesced, and a journal_batch_end record. they are
+ *  replayed as one batch once its end is read, a batch without its end
+ *  is not replayed.
+ */
+
+class JournalException : public std::runtime_error {
+public:
+  explicit JournalException(const std::string& what) : std::runtime_error(what) {}
+};
+
+enum JournalRecordType : uint8_t {
+  journal_add = 1,
+  journal_cancel,
+  journal_replace,
+  journal_market_price,
+  journal_routing_success,
+  journal_routing_failure,
+  journal_time,
+  journal_routing_partial,
+  journal_add_batch,
+  journal_cancel_batch,
+  journal_batch_end
+};
+
+static const char JOURNAL_MAGIC[4] = { 'O', 'B', 'J', 'L' };
+static const uint32_t JOURNAL_VERSION = 1;
+static const size_t JOURNAL_MAX_RECORD = 256;
+
+struct JournalFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t symbol_id;
+  uint32_t reserved;
+};
+
+struct JournalRecordHeader {
+  uint64_t seq;       /* from 1, without gaps */
+  uint32_t size;      /* of the payload */
+  uint8_t type;
+  uint8_t reserved[3];
+};
+
+/* one record, built on the stack of the matching thread */
+class JournalEncoder {
+public:
+  explicit JournalEncoder(JournalRecordType type) : size_(sizeof(JournalRecordHeader)) {
+    JournalRecordHeader header = JournalRecordHeader();
+    header.type = type;
+    memcpy(data_, &header, sizeof(header));
+  }
+
+  template <class T>
+  void put(const T& value) {
+    if(size_ + sizeof(T) > JOURNAL_MAX_RECORD)
+      throw JournalException("journal record too large");
+
+    memcpy(data_ + size_, &value, sizeof(T));
+    size_ += sizeof(T);
+  }
+
+  /* called by the writer, which numbers the records */
+  void seal(uint64_t seq) {
+    JournalRecordHeader* header = reinterpret_cast<JournalRecordHeader*>(data_);
+    header->seq = seq;
+    header->size = (uint32_t) (size_ - sizeof(JournalRecordHeader));
+  }
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  alignas(8) char data_[JOURNAL_MAX_RECORD];
+  size_t size_;
+};
+
+class JournalDecoder {
+public:
+  JournalDecoder(const char* data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+  template <class T>
+  T get() {
+    T value;
+    if(pos_ + sizeof(T) > size_)
+      throw JournalException("journal record truncated");
+
+    memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+private:
+  const char* data_;
+  size_t size_;
+  size_t pos_;
+};
+
+/**
+ * \brief appends records to a journal file from the matching thread.
+ *  append() copies the record into a ring and returns; a writer thread
+ *  drains the ring to the file. the matching thread only waits when the
+ *  ring is full, or in flush()
+ *
+ *  a failed write is latched: records past it are dropped, and append()
+ *  and flush() throw from then on, so the book stops before taking an
+ *  input it cannot journal
+ */
+
+class JournalWriter {
+public:
+  /* creates `path`, or appends to it when continuing a journal from
+    `next_seq`, e.g. after a replay */
+  JournalWriter(const std::string& path, uint32_t symbol_id,
+    uint64_t next_seq = 1, size_t capacity = 1 << 22) :
+    ring_(round_up(capacity)),
+    mask_(ring_.size() - 1),
+    next_seq_(next_seq),
+    stalls_(0),
+    head_(0),
+    tail_(0),
+    flush_request_(0),
+    flushed_(0),
+    failed_(false),
+    stop_(false)
+  {
+    file_ = fopen(path.c_str(), next_seq == 1 ? "wb" : "ab");
+    if(!file_)
+      throw JournalException("cannot open journal " + path);
+
+    if(next_seq == 1) {
+      JournalFileHeader header = JournalFileHeader();
+      memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+      header.version = JOURNAL_VERSION;
+      header.symbol_id = symbol_id;
+      if(fwrite(&header, sizeof(header), 1, file_) != 1) {
+        fclose(file_);
+        throw JournalException("cannot write journal " + path);
+      }
+    }
+
+    thread_ = std::thread(&JournalWriter::run, this);
+  }
+
+  ~JournalWriter() {
+    stop_.store(true, std::memory_order_release);
+    thread_.join();
+    fclose(file_);
+  }
+
+  JournalWriter(const JournalWriter&) = delete;
+  JournalWriter& operator=(const JournalWriter&) = delete;
+
+  void append(JournalEncoder& record) {
+    check();
+    record.seal(next_seq_++);
+
+    size_t size = record.size();
+    uint64_t head = head_.load(std::memory_order_relaxed);
+
+    if(head + size - tail_.load(std::memory_order_acquire) > ring_.size()) {
+      ++stalls_;
+      while(head + size - tail_.load(std::memory_order_acquire) > ring_.size())
+        std::this_thread::yield();
+    }
+
+    size_t at = head & mask_;
+    size_t first = std::min(size, ring_.size() - at);
+    memcpy(&ring_[at], record.data(), first);
+    memcpy(&ring_[0], record.data() + first, size - first);
+
+    head_.store(head + size, std::memory_order_release);
+  }
+
+  /* waits until everything appended so far is handed to the OS */
+  void flush() {
+    uint64_t target = head_.load(std::memory_order_relaxed);
+    flush_request_.store(target, std::memory_order_release);
+
+    while(flushed_.load(std::memory_order_acquire) < target && !failed())
+      std::this_thread::yield();
+
+    check();
+  }
+
+  /* a write to the file failed, see above */
+  bool failed() const { return failed_.load(std::memory_order_acquire); }
+
+  /* sequence number of the next record */
+  uint64_t next_seq() const { return next_seq_; }
+
+  /* times append() found the ring full */
+  uint64_t stalls() const { return stalls_; }
+
+private:
+  static size_t round_up(size_t n) {
+    size_t size = JOURNAL_MAX_RECORD;
+    while(size < n) size <<= 1;
+    return size;
+  }
+
+  void check() const {
+    if(failed())
+      throw JournalException("journal write failed");
+  }
+
+  void fail() { failed_.store(true, std::memory_order_release); }
+
+  void run() {
+    unsigned idle = 0;
+
+    for(;;) {
+      uint64_t tail = tail_.load(std::memory_order_relaxed);
+      uint64_t head = head_.load(std::memory_order_acquire);
+
+      if(head != tail) {
+        size_t at = tail & mask_;
+        size_t size = head - tail;
+        size_t first = std::min(size, ring_.size() - at);
+
+        /* after a failure the ring is still drained, so that append()
+          never waits on a writer that has stopped writing */
+        if(!failed() && (fwrite(&ring_[at], 1, first, file_) != first ||
+          fwrite(&ring_[0], 1, size - first, file_) != size - first))
+          fail();
+
+        tail_.store(head, std::memory_order_release);
+        idle = 0;
+      }
+
+      uint64_t request = flush_request_.load(std::memory_order_acquire);
+      if(request > flushed_.load(std::memory_order_relaxed) && head >= request) {
+        if(!failed() && fflush(file_) != 0)
+          fail();
+        flushed_.store(head, std::memory_order_release);
+      }
+
+      if(head == tail) {
+        if(stop_.load(std::memory_order_acquire) &&
+          head_.load(std::memory_order_acquire) == head) break;
+
+        /* spin a little, then stop burning the core */
+        if(++idle < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    }
+
+    if(!failed() && fflush(file_) != 0)
+      fail();
+  }
+
+  FILE* file_;
+  std::vector<char> ring_;
+  size_t mask_;
+
+  /* matching thread only */
+  uint64_t next_seq_;
+  uint64_t stalls_;
+
+  /* bytes appended and bytes written, on their own cache lines. padded
+    rather than alignas(64), which plain new does not honour before C++17 */
+  static const size_t CACHE_LINE = 64;
+
+  char pad0_[CACHE_LINE];
+  std::atomic<uint64_t> head_;
+  char pad1_[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> tail_;
+  char pad2_[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+  std::atomic<uint64_t> flush_request_;
+  std::atomic<uint64_t> flushed_;
+  std::atomic<bool> failed_;
+  std::atomic<bool> stop_;
+
+  std::thread thread_;
+};
+
+/**
+ * \brief journal policies of OB. a policy provides a Recorder, called
+ *  by the book with each of its inputs
+ */
+
+/* the default, journals nothing and adds nothing to the book */
+struct NoJournal {
+  template <class OrderPtr, class Price, class Qty>
+  struct Recorder {
+    void add(const OrderPtr&) {}
+    void cancel(const OrderPtr&, CancelReasons) {}
+    void replace(const OrderPtr&, Qty) {}
+    void market_price(Price) {}
+    void routing_response(uint64_t, bool) {}
+    void routing_partial(uint64_t, Qty) {}
+    void time(uint64_t) {}
+    void add_batch(bool) {}
+    void cancel_batch(bool) {}
+    void batch_end() {}
+
+    bool muted() const { return false; }
+  };
+};
+
+/* journals orders encoded by Codec to the attached JournalWriter */
+template <class Codec_>
+struct CodecJournal {
+  typedef Codec_ Codec;
+
+  template <class OrderPtr, class Price, class Qty>
+  class Recorder {
+  public:
+    Recorder() : writer_(nullptr), muted_(false) {}
+
+    /* records nothing while detached */
+    void attach(JournalWriter* writer) { writer_ = writer; }
+    void detach() { writer_ = nullptr; }
+    JournalWriter* writer() const { return writer_; }
+
+    /* callbacks are not delivered while muted, see JournalReplayer */
+    void mute(bool muted) { muted_ = muted; }
+    bool muted() const { return muted_; }
+
+    void add(const OrderPtr& order) {
+      if(!writer_) return;
+      JournalEncoder record(journal_add);
+      Codec::encode(order, record);
+      writer_->append(record);
+    }
+
+    void cancel(const OrderPtr& order, CancelReasons reason) {
+      if(!writer_) return;
+      JournalEncoder record(journal_cancel);
+      record.put(order->order_id());
+      record.put(reason);
+      writer_->append(record);
+    }
+
+    void replace(const OrderPtr& order, Qty delta) {
+      if(!writer_) return;
+      JournalEncoder record(journal_replace);
+      record.put(order->order_id());
+      record.put(delta);
+      writer_->append(record);
+    }
+
+    void market_price(Price price) {
+      if(!writer_) return;
+      JournalEncoder record(journal_market_price);
+      record.put(price);
+      writer_->append(record);
+    }
+
+    void routing_response(uint64_t request_id, bool success) {
+      if(!writer_) return;
+      JournalEncoder record(success ? journal_routing_success : journal_routing_failure);
+      record.put(request_id);
+      writer_->append(record);
+    }
+
+    void routing_partial(uint64_t request_id, Qty filled_qty) {
+      if(!writer_) return;
+      JournalEncoder record(journal_routing_partial);
+      record.put(request_id);
+      record.put(filled_qty);
+      writer_->append(record);
+    }
+
+    void time(uint64_t now) {
+      if(!writer_) return;
+      JournalEncoder record(journal_time);
+      record.put(now);
+      writer_->append(record);
+    }
+
+    /* before the adds or cancels of a batch */
+    void add_batch(bool coalesce_book_updates) {
+      batch(journal_add_batch, coalesce_book_updates);
+    }
+
+    void cancel_batch(bool coalesce_book_updates) {
+      batch(journal_cancel_batch, coalesce_book_updates);
+    }
+
+    void batch_end() {
+      if(!writer_) return;
+      JournalEncoder record(journal_batch_end);
+      writer_->append(record);
+    }
+
+  private:
+    void batch(JournalRecordType type, bool coalesce_book_updates) {
+      if(!writer_) return;
+      JournalEncoder record(type);
+      record.put(coalesce_book_updates);
+      writer_->append(record);
+    }
+
+    JournalWriter* writer_;
+    bool muted_;
+  };
+};
+
+/**
+ * \brief storage engine whose books journal their inputs, e.g.
+ *  BasicOB<Journaled<LadderStorage, Codec>, Tracker, Plugins...>.
+ *  attach a JournalWriter with OB::journal().attach(). composes with
+ *  Instrumented either way round
+ */
+template <class Storage, class Codec>
+struct Journaled : public Storage {};
+
+template <class Storage>
+struct journal_policy {
+  typedef NoJournal type;
+};
+
+template <class Storage, class Codec>
+struct journal_policy<Journaled<Storage, Codec>> {
+  typedef CodecJournal<Codec> type;
+};
+
+template <class Storage, class Latency>
+struct journal_policy<Instrumented<Storage, Latency>> : journal_policy<Storage> {};
+
+template <class Storage, class Codec>
+struct latency_policy<Journaled<Storage, Codec>> : latency_policy<Storage> {};
+
+/**
+ * \brief reads the records of a journal file, all of it in memory
+ */
+
+class JournalReader {
+public:
+  explicit JournalReader(const std::string& path) : pos_(sizeof(JournalFileHeader)) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+      throw JournalException("cannot open journal " + path);
+
+    char buf[1 << 16];
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), file)) > 0)
+      data_.insert(data_.end(), buf, buf + n);
+    fclose(file);
+
+    if(data_.size() < sizeof(JournalFileHeader))
+      throw JournalException("journal too short " + path);
+
+    memcpy(&header_, data_.data(), sizeof(header_));
+
+    if(memcmp(header_.magic, JOURNAL_MAGIC, sizeof(header_.magic)))
+      throw JournalException("not a journal " + path);
+    if(header_.version != JOURNAL_VERSION)
+      throw JournalException("unsupported journal version " + path);
+  }
+
+  uint32_t symbol_id() const { return header_.symbol_id; }
+
+  /**
+   * \brief the next record. a record cut short at the end of the file,
+   *  as left by a crash, ends the journal
+   * \return false at the end
+   */
+  bool next(JournalRecordHeader& header, JournalDecoder& payload) {
+    if(pos_ + sizeof(JournalRecordHeader) > data_.size()) return false;
+
+    memcpy(&header, &data_[pos_], sizeof(header));
+    if(pos_ + sizeof(header) + header.size > data_.size()) return false;
+
+    payload = JournalDecoder(&data_[pos_ + sizeof(header)], header.size);
+    pos_ += sizeof(header) + header.size;
+    return true;
+  }
+
+private:
+  JournalFileHeader header_;
+  std::vector<char> data_;
+  size_t pos_;
+};
+
+/**
+ * \brief applies the records of a journal to a book. replay() delivers
+ *  the callbacks of the book as when the journal was written;
+ *  fast_forward() only rebuilds the state of the book. the book must be
+ *  in the state it was in when the first record replayed was written,
+ *  i.e. empty to replay a journal from the start.
+ *
+ *  a book answering routing requests must leave them pending while
+ *  replaying, the responses are in the journal.
+ */
+
+template <class Book>
+class JournalReplayer {
+public:
+  typedef typename Book::OrderPtr OrderPtr;
+  typedef typename Book::Price Price;
+  typedef typename Book::Qty Qty;
+  typedef typename Book::JournalPolicy::Codec Codec;
+
+  explicit JournalReplayer(Book& book) :
+    book_(book), last_seq_(0), resumed_(false), skipped_(0),
+    batch_type_(0), batch_coalesce_(false), batch_reason_(dont_cancel) {}
+
+  /* replays the records up to sequence number `until` included */
+  uint64_t replay(JournalReader& reader, uint64_t until = UINT64_MAX) {
+    return apply(reader, until);
+  }
+
+  uint64_t fast_forward(JournalReader& reader, uint64_t until = UINT64_MAX) {
+    book_.journal().mute(true);
+    try {
+      uint64_t n = apply(reader, until);
+      book_.journal().mute(false);
+      return n;
+    }
+    catch(...) {
+      book_.journal().mute(false);
+      throw;
+    }
+  }
+
+  /**
+   * \brief for a book loaded from a snapshot: `orders` are the orders of
+   *  the snapshot, `last_seq` the last record it includes. orders gone
+   *  before the snapshot are not in it, cancels and replaces of them
+   *  were rejected by the book, and are skipped
+   */
+  void resume(const std::vector<OrderPtr>& orders, uint64_t last_seq) {
+    for(auto it = orders.begin(); it != orders.end(); ++it)
+      orders_[(*it)->order_id()] = *it;
+    last_seq_ = last_seq;
+    resumed_ = true;
+  }
+
+  /* records skipped after resume() */
+  uint64_t skipped() const { return skipped_; }
+
+  /* of the last record applied, continue the journal from last_seq() + 1 */
+  uint64_t last_seq() const { return last_seq_; }
+
+  /* orders added by the journal, by id */
+  OrderPtr order(const utils::uint128& order_id) const {
+    auto it = orders_.find(order_id);
+    return it == orders_.end() ? OrderPtr() : it->second;
+  }
+
+private:
+  uint64_t apply(JournalReader& reader, uint64_t until) {
+    JournalRecordHeader header;
+    JournalDecoder payload(nullptr, 0);
+    uint64_t applied = 0;
+
+    /* the writer of a replaying book would journal the journal again */
+    JournalWriter* writer = book_.journal().writer();
+    book_.journal().detach();
+
+    try {
+      while(last_seq_ < until && reader.next(header, payload)) {
+        if(header.seq <= last_seq_) continue;
+        if(last_seq_ && header.seq != last_seq_ + 1)
+          throw JournalException("gap in journal after " + std::to_string(last_seq_));
+
+        apply(header, payload);
+        last_seq_ = header.seq;
+        ++applied;
+      }
+    }
+    catch(...) {
+      book_.journal().attach(writer);
+      throw;
+    }
+
+    book_.journal().attach(writer);
+    return applied;
+  }
+
+  void apply(const JournalRecordHeader& header, JournalDecoder& payload) {
+    if(batch_type_ && header.type != journal_add && header.type != journal_cancel &&
+      header.type != journal_batch_end)
+      throw JournalException("unfinished batch in journal");
+
+    switch(header.type) {
+      case journal_add: {
+        OrderPtr order = Codec::decode(payload);
+        orders_[order->order_id()] = order;
+
+        if(batch_type_ == journal_add_batch) batch_.push_back(order);
+        else if(!batch_type_) book_.add(order);
+        else throw JournalException("add in a batch of cancels");
+        break;
+      }
+
+      case journal_cancel: {
+        const OrderPtr* order = find(payload.get<utils::uint128>());
+        CancelReasons reason = payload.get<CancelReasons>();
+
+        if(batch_type_ == journal_cancel_batch) {
+          if(order) batch_.push_back(*order);
+          batch_reason_ = reason;
+        }
+        else if(!batch_type_) {
+          if(order) book_.cancel(*order, reason);
+        }
+        else throw JournalException("cancel in a batch of adds");
+        break;
+      }
+
+      case journal_add_batch:
+      case journal_cancel_batch:
+        if(batch_type_)
+          throw JournalException("batch in a batch");
+
+        batch_type_ = header.type;
+        batch_coalesce_ = payload.get<bool>();
+        batch_reason_ = dont_cancel;
+        break;
+
+      case journal_batch_end:
+        end_batch();
+        break;
+
+      case journal_replace: {
+        const OrderPtr* order = find(payload.get<utils::uint128>());
+        if(order) book_.replace(*order, payload.get<Qty>());
+        break;
+      }
+
+      case journal_market_price:
+        book_.set_market_price(payload.get<Price>());
+        break;
+
+      case journal_routing_success:
+      case journal_routing_failure:
+        route(book_, payload.get<uint64_t>(), header.type == journal_routing_success, 0);
+        break;
+
+      case journal_routing_partial: {
+        uint64_t request_id = payload.get<uint64_t>();
+        route_partial(book_, request_id, payload.get<Qty>(), 0);
+        break;
+      }
+
+      case journal_time:
+        book_.advance_time(payload.get<uint64_t>());
+        break;
+
+      default:
+        throw JournalException("unknown journal record " + std::to_string(header.type));
+    }
+  }
+
+  /* the batch as the book ran it, one delivery of callbacks */
+  void end_batch() {
+    if(!batch_type_)
+      throw JournalException("end of a batch that did not begin");
+
+    if(batch_type_ == journal_add_batch)
+      book_.add_batch(batch_.begin(), batch_.end(), batch_coalesce_);
+    else
+      book_.cancel_batch(batch_.begin(), batch_.end(), batch_reason_, batch_coalesce_);
+
+    batch_type_ = 0;
+    batch_.clear();
+  }
+
+  const OrderPtr* find(const utils::uint128& order_id) {
+    auto it = orders_.find(order_id);
+    if(it != orders_.end()) return &it->second;
+
+    if(!resumed_)
+      throw JournalException("journal refers to an unknown order");
+
+    ++skipped_;
+    return nullptr;
+  }
+
+  /* only books with RoutablePlugin take routing responses */
+  template <class B>
+  auto route(B& book, uint64_t request_id, bool success, int)
+    -> decltype(book.replay_routing_response(request_id, success)) {
+    return book.replay_routing_response(request_id, success);
+  }
+
+  template <class B>
+  void route(B&, uint64_t, bool, long) {
+    throw JournalException("routing response in the journal of a book without routing");
+  }
+
+  template <class B>
+  auto route_partial(B& book, uint64_t request_id, Qty filled_qty, int)
+    -> decltype(book.replay_routing_partial(request_id, filled_qty)) {
+    return book.replay_routing_partial(request_id, filled_qty);
+  }
+
+  template <class B>
+  void route_partial(B&, uint64_t, Qty, long) {
+    throw JournalException("routing response in the journal of a book without routing");
+  }
+
+  Book& book_;
+  uint64_t last_seq_;
+  bool resumed_;
+  uint64_t skipped_;
+  /* orders by id, for cancels and replaces */
+  std::unordered_map<utils::uint128, OrderPtr, utils::Uint128Hash> orders_;
+
+  /* the batch being read, until its end */
+  uint8_t batch_type_;
+  bool batch_coalesce_;
+  CancelReasons batch_reason_;
+  std::vector<OrderPtr> batch_;
+};
+
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstddef>
+#include <cmath>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace book {
+
+/* operations of OB timed by a latency policy */
+enum LatencyOp : uint8_t {
+  latency_add,
+  latency_add_batch,
+  latency_cancel,
+  latency_cancel_batch,
+  latency_replace,
+  latency_match,
+  LATENCY_OPS
+};
+
+/* plugin hooks, named after the hooks listed in plugin.h */
+enum LatencyHook : uint8_t {
+  hook_should_add,
+  hook_should_add_tracker,
+  hook_after_add_tracker,
+  hook_should_trade,
+  hook_after_trade,
+  hook_on_market_price_change,
+  hook_should_rest,
+  hook_after_rest,
+  hook_on_erase,
+  hook_on_time,
+  LATENCY_HOOKS
+};
+
+/* cycles of the time stamp counter, or nanoseconds where there is none */
+inline uint64_t read_tsc() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/* read_tsc() ticks per nanosecond, measured over `sample` */
+inline double tsc_ticks_per_ns(
+  std::chrono::microseconds sample = std::chrono::microseconds(10000))
+{
+  typedef std::chrono::steady_clock Clock;
+
+  Clock::time_point start = Clock::now();
+  uint64_t start_tsc = read_tsc();
+  std::this_thread::sleep_for(sample);
+  uint64_t end_tsc = read_tsc();
+
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  return (end_tsc - start_tsc) / ns;
+}
+
+/**
+ * \brief HDR-style histogram of latencies in read_tsc() ticks. values
+ *  below 32 get a bucket each, then every power of two is split in 16
+ *  buckets, so percentiles are within 1/16 of the recorded values.
+ *
+ *  written by the thread of the book only, and readable from any other
+ *  thread at any time: counters are relaxed atomics that the writer
+ *  updates without read-modify-write, so recording takes no lock and no
+ *  locked instruction. a reader may see a sample in count() before it
+ *  sees it in its bucket.
+ */
+
+class LatencyHistogram {
+public:
+  static const unsigned SUB_BUCKET_BITS = 4;
+  static const unsigned SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static const unsigned MAX_VALUE_BITS = 40;
+  static const unsigned BUCKETS =
+    2 * SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKET_BITS - 1) * SUB_BUCKETS;
+
+  LatencyHistogram() {
+    for(unsigned i = 0; i < BUCKETS; ++i)
+      buckets_[i].store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(uint64_t ticks) {
+    std::atomic<uint64_t>& bucket = buckets_[bucket_of(ticks)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum_.store(sum_.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+
+    if(ticks > max_.load(std::memory_order_relaxed))
+      max_.store(ticks, std::memory_order_relaxed);
+
+    count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_acquire); }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  double mean() const {
+    uint64_t n = count();
+    return n == 0 ? 0 : (double) sum_.load(std::memory_order_relaxed) / n;
+  }
+
+  /**
+   * \brief highest value equivalent to the p-th percentile, p in [0, 100].
+   *  never above max()
+   */
+  uint64_t percentile(double p) const {
+    uint64_t counts[BUCKETS];
+    uint64_t total = 0;
+
+    for(unsigned i = 0; i < BUCKETS; ++i)
+      total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+
+    if(total == 0)
+      return 0;
+
+    uint64_t rank = (uint64_t) std::ceil(p / 100 * total);
+    if(rank < 1) rank = 1;
+    if(rank > total) rank = total;
+
+    uint64_t seen = 0;
+    for(unsigned i = 0; i < BUCKETS; ++i) {
+      seen += counts[i];
+      if(seen >= rank) {
+        uint64_t highest = lowest_of(i) + width_of(i) - 1;
+        uint64_t max = this->max();
+        return highest < max ? highest : max;
+      }
+    }
+
+    return max();
+  }
+
+  static unsigned bucket_of(uint64_t ticks) {
+    if(ticks < 2 * SUB_BUCKETS)
+      return (unsigned) ticks;
+
+    if(ticks >> MAX_VALUE_BITS)
+      return BUCKETS - 1;
+
+    /* ticks in [16 << shift, 32 << shift) */
+    unsigned shift = 63 - __builtin_clzll(ticks) - SUB_BUCKET_BITS;
+    return 2 * SUB_BUCKETS + (shift - 1) * SUB_BUCKETS
+      + (unsigned) (ticks >> shift) - SUB_BUCKETS;
+  }
+
+  static uint64_t lowest_of(unsigned bucket) {
+    if(bucket < 2 * SUB_BUCKETS)
+      return bucket;
+
+    unsigned shift = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1;
+    uint64_t sub = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub) << shift;
+  }
+
+  static uint64_t width_of(unsigned bucket) {
+    if(bucket < 2 * SUB_BUCKETS)
+      return 1;
+
+    return (uint64_t) 1 << ((bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + 1);
+  }
+
+private:
+  std::atomic<uint64_t> buckets_[BUCKETS];
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+};
+
+/**
+ * \brief latency policies of OB. a policy provides a Recorder for a book
+ *  of PLUGINS plugins, with an OpTimer and a HookTimer that time their
+ *  own scope.
+ */
+
+/* the default, records nothing and adds nothing to the book */
+struct NoLatency {
+  template <size_t PLUGINS>
+  struct Recorder {
+    struct OpTimer {
+      OpTimer(Recorder&, LatencyOp) {}
+    };
+
+    struct HookTimer {
+      HookTimer(Recorder&, LatencyHook, size_t) {}
+    };
+  };
+};
+
+/* one histogram per operation of the book, and per hook of each plugin */
+struct TscLatency {
+  template <size_t PLUGINS>
+  class Recorder {
+  public:
+    static const size_t plugin_count = PLUGINS;
+
+    const LatencyHistogram& op(LatencyOp op) const { return ops_[op]; }
+
+    /* plugin is the position of the plugin in the Plugins of the book */
+    const LatencyHistogram& hook(size_t plugin, LatencyHook hook) const {
+      return hooks_[plugin][hook];
+    }
+
+    class OpTimer {
+    public:
+      OpTimer(Recorder& recorder, LatencyOp op) :
+        histogram_(recorder.ops_[op]), start_(read_tsc()) {}
+
+      ~OpTimer() { histogram_.record(read_tsc() - start_); }
+
+    private:
+      LatencyHistogram& histogram_;
+      uint64_t start_;
+    };
+
+    class HookTimer {
+    public:
+      HookTimer(Recorder& recorder, LatencyHook hook, size_t plugin) :
+        histogram_(recorder.hooks_[plugin][hook]), start_(read_tsc()) {}
+
+      ~HookTimer() { histogram_.record(read_tsc() - start_); }
+
+    private:
+      LatencyHistogram& histogram_;
+      uint64_t start_;
+    };
+
+  private:
+    LatencyHistogram ops_[LATENCY_OPS];
+    LatencyHistogram hooks_[PLUGINS ? PLUGINS : 1][LATENCY_HOOKS];
+  };
+};
+
+/**
+ * \brief storage engine whose books record latencies with Latency,
+ *  e.g. BasicOB<Instrumented<LadderStorage>, Tracker, Plugins...>.
+ *  read them with OB::latency()
+ */
+template <class Storage, class Latency = TscLatency>
+struct Instrumented : public Storage {};
+
+template <class Storage>
+struct latency_policy {
+  typedef NoLatency type;
+};
+
+template <class Storage, class Latency>
+struct latency_policy<Instrumented<Storage, Latency>> {
+  typedef Latency type;
+};
+
+/* position of T in Ts... */
+template <class T, class... Ts>
+struct index_of;
+
+template <class T, class... Ts>
+struct index_of<T, T, Ts...> {
+  static const size_t value = 0;
+};
+
+template <class T, class U, class... Ts>
+struct index_of<T, U, Ts...> {
+  static const size_t value = 1 + index_of<T, Ts...>::value;
+};
+
+}
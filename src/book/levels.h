@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include "arena.h"
+#include "book_price.h"
+
+namespace book {
+
+/* qty and number of orders resting at a price */
+template <class Qty>
+struct Level {
+  Qty qty;
+  uint32_t orders;
+};
+
+/* outcome of a sweep simulated on the levels of a side */
+template <class Units>
+struct Sweep {
+  typename Units::Qty qty;        /* filled */
+  typename Units::Cost cost;      /* sum of qty * price of the fills */
+  typename Units::Price worst_price;  /* of the last level reached, 0 if none */
+  size_t levels;                  /* levels reached */
+  bool filled;                    /* the whole qty or funds would trade */
+
+  double vwap() const { return qty == 0 ? 0 : (double) cost / qty; }
+};
+
+/**
+ * \brief aggregates of one side of the book, kept up to date by OB as
+ *  orders rest, trade, change qty and leave: the qty and order count of
+ *  every price level in priority order, and the totals of the side. qty
+ *  is in the units of the tracker and counts what is shown on the book
+ *  (Tracker::qty_on_book()).
+ *
+ *  levels are kept in a sorted vector with the best level at the back,
+ *  as in PriceLadder: the best level is read in O(1) and any other in
+ *  O(log levels), walking them touches contiguous memory, and only a
+ *  new price level or an emptied one away from the top moves entries
+ */
+
+template <class Price, class Qty>
+class SideLevels {
+public:
+  typedef book::Level<Qty> Level;
+  typedef BasicBookPrice<Price> Key;
+  typedef std::pair<Key, Level> Entry;
+  typedef std::vector<Entry, ArenaAllocator<Entry>> Entries;
+  typedef std::reverse_iterator<typename Entries::const_iterator> const_iterator;
+
+  SideLevels(bool is_bid, BookArena* arena) :
+    is_bid_(is_bid), levels_(arena), qty_(0), orders_(0) {}
+
+  /* levels in priority order, best first */
+  const_iterator begin() const { return levels_.rbegin(); }
+  const_iterator end() const { return levels_.rend(); }
+
+  /* 0 if the side is empty */
+  Price best_price() const { return levels_.empty() ? Price(0) : levels_.back().first.price(); }
+  Qty best_qty() const { return levels_.empty() ? Qty(0) : levels_.back().second.qty; }
+  uint32_t best_orders() const { return levels_.empty() ? 0 : levels_.back().second.orders; }
+
+  /* an empty level if nothing rests at `price` */
+  Level level(Price price) const {
+    auto pos = find(price);
+    return pos == levels_.end() ? Level{ Qty(0), 0 } : pos->second;
+  }
+
+  Qty qty() const { return qty_; }
+  size_t orders() const { return orders_; }
+  size_t level_count() const { return levels_.size(); }
+
+  /* an order rests with `qty` */
+  void add(Price price, Qty qty) {
+    auto pos = find(price);
+
+    if(pos == levels_.end()) {
+      Key key(is_bid_, price);
+      pos = levels_.insert(lower_bound(key), Entry(key, Level{ Qty(0), 0 }));
+    }
+
+    Level& level = entry(pos).second;
+    level.qty += qty;
+    ++level.orders;
+    qty_ += qty;
+    ++orders_;
+  }
+
+  /* the qty of a resting order changed by `delta` */
+  void change(Price price, Qty delta) {
+    entry(find(price)).second.qty += delta;
+    qty_ += delta;
+  }
+
+  /* an order leaves with `qty` left */
+  void remove(Price price, Qty qty) {
+    auto pos = find(price);
+    Level& level = entry(pos).second;
+
+    --orders_;
+    qty_ = orders_ == 0 ? Qty(0) : qty_ - qty;
+
+    if(--level.orders > 0) {
+      level.qty -= qty;
+      return;
+    }
+
+    /* sweeps empty the best level first */
+    if(pos + 1 == levels_.end()) levels_.pop_back();
+    else levels_.erase(pos);
+  }
+
+  /**
+   * \brief what a taker on the other side would fill, walking the levels
+   *  from the best one without touching them. `qty` and `funds` limit
+   *  the taker like those of a tracker, either can be 0 but not both.
+   *  `limit` is the price of the taker, 0 for a market order. O(levels
+   *  reached)
+   */
+  template <class Units>
+  Sweep<Units> sweep(Qty qty, typename Units::Cost funds, Price limit) const {
+    typedef typename Units::Cost Cost;
+
+    Sweep<Units> result = { Qty(0), Cost(0), Price(0), 0, false };
+
+    for(auto it = begin(); it != end(); ++it) {
+      if(is_filled<Units>(qty, funds, result)) break;
+
+      Price price = it->first.price();
+      if(!it->first.matches(limit)) break;
+
+      /* makers left with nothing to trade are skipped, as by OB::match() */
+      if(it->second.qty <= 0) continue;
+
+      Qty fill = std::min(tradable_qty<Units>(qty, funds, result, price), it->second.qty);
+      if(fill <= 0) break;
+
+      result.qty += fill;
+      result.cost += fill * price;
+      result.worst_price = price;
+      ++result.levels;
+    }
+
+    result.filled = is_filled<Units>(qty, funds, result);
+    return result;
+  }
+
+private:
+  /* first level that is not worse than `key` */
+  typename Entries::const_iterator lower_bound(const Key& key) const {
+    return std::lower_bound(levels_.begin(), levels_.end(), key,
+      [](const Entry& level, const Key& k) { return k < level.first; });
+  }
+
+  /* the level at `price`, end() if none */
+  typename Entries::const_iterator find(Price price) const {
+    /* most of the activity happens at the top of the book */
+    if(!levels_.empty() && levels_.back().first == price)
+      return levels_.end() - 1;
+
+    auto pos = lower_bound(Key(is_bid_, price));
+    return pos != levels_.end() && pos->first == price ? pos : levels_.end();
+  }
+
+  Entry& entry(typename Entries::const_iterator pos) {
+    return levels_[pos - levels_.cbegin()];
+  }
+
+  /* as BaseTracker::tradable_qty(), done when either limit is reached */
+  template <class Units, class Cost>
+  static bool is_filled(Qty qty, Cost funds, const Sweep<Units>& done) {
+    return (funds != 0 && Units::funds_exhausted(funds - done.cost)) ||
+      (qty != 0 && qty - done.qty < Units::min_qty());
+  }
+
+  template <class Units, class Cost>
+  static Qty tradable_qty(Qty qty, Cost funds, const Sweep<Units>& done, Price price) {
+    if(funds == 0)
+      return qty - done.qty;
+
+    if(qty == 0)
+      return Units::affordable_qty(funds - done.cost, price);
+
+    return std::min(qty - done.qty, Units::affordable_qty(funds - done.cost, price));
+  }
+
+  bool is_bid_;
+  Entries levels_;
+  Qty qty_;
+  size_t orders_;
+};
+
+}
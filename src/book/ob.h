@@ -23,119 +23,466 @@
 #pragma once
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <cassert>
 #include <stdint.h>
 #include <memory>
 #include <iostream>
+#include <type_traits>
+#include <utility>
+#include <initializer_list>
 
 #include "types.h"
 #include "book_price.h"
 #include "tracker.h"
 #include "callback.h"
-
-#define INVOKE_PLUGIN_HOOKS(FN) \
-  (void) std::initializer_list<int>{ (Plugins::FN, 0)... };
-
-#define TRUE_FOR_ALL_PLUGINS(FN) \
-    ([=]() -> bool { \
+#include "callback_buffer.h"
+#include "storage.h"
+#include "levels.h"
+#include "units.h"
+#include "arena.h"
+#include "latency.h"
+#include "journal.h"
+#include "snapshot.h"
+
+/* calls FN on every plugin implementing it, in the order of Plugins */
+#define INVOKE_PLUGIN_HOOKS(FN, ...) \
+  (void) std::initializer_list<int>{ (FN##_hook<BoundPlugin<Plugins>>(0, __VA_ARGS__), 0)... };
+
+#define TRUE_FOR_ALL_PLUGINS(FN, ...) \
+    ([&]() -> bool { \
       bool result = true; \
-      (void) std::initializer_list<int>{ (result &= Plugins::FN, 0)... }; \
+      (void) std::initializer_list<int>{ (result &= FN##_hook<BoundPlugin<Plugins>>(0, __VA_ARGS__), 0)... }; \
       return result; \
     })()
 
+/* FN_hook<P>(0, args...) calls P::FN(args...) if the plugin P implements
+ * FN, and is a no-op returning DEFAULT otherwise. both overloads are
+ * viable when P has FN, the exact match on 0 picks the first one.
+ * implemented hooks are timed by the latency policy of the book */
+#define PLUGIN_HOOK(FN, RESULT, DEFAULT) \
+  template <class P, class... Args> \
+  auto FN##_hook(int, Args&&... args) \
+    -> decltype(P::FN(std::forward<Args>(args)...)) { \
+    typename LatencyRecorder::HookTimer timer(latency_, hook_##FN, \
+      index_of<P, BoundPlugin<Plugins>...>::value); \
+    return P::FN(std::forward<Args>(args)...); \
+  } \
+  template <class P, class... Args> \
+  RESULT FN##_hook(long, Args&&...) { return DEFAULT; }
+
 namespace book {
 
-template <class Tracker, class... Plugins>
-class OB : public Plugins... {
+/**
+ * \brief order book of a single symbol.
+ * \param Storage storage engine of the resting orders (see storage.h)
+ * \param Tracker per-order state
+ * \param Plugins mixins hooking into add/match/trade. see plugin.h
+ *  for the hooks, which are resolved at compile time
+ *
+ * the sides, the order index and the plugin containers all allocate
+ * from the arena of the book (see arena.h). with an Instrumented storage,
+ * operations and plugin hooks are timed (see latency.h), with a Journaled
+ * storage, inputs are journaled (see journal.h)
+ */
+
+template <class Storage, class Tracker, class... Plugins>
+class BasicOB : public virtual ArenaOwner,
+  public bind_book<Plugins, BasicOB<Storage, Tracker, Plugins...>>::type... {
+
+  template <class Plugin>
+  using BoundPlugin = typename bind_book<Plugin, BasicOB>::type;
+
+  /* plugins call back into the book statically */
+  template <class, class, class> friend class Plugin;
 
 public:
-  typedef typename Tracker::OrderPtr OrderPtr;
-  typedef Callback<OrderPtr> TypedCallback;
-  typedef std::vector<TypedCallback> Callbacks;
-  typedef std::multimap<BookPrice, Tracker> TrackerMap;
+  typedef typename latency_policy<Storage>::type::template
+    Recorder<sizeof...(Plugins)> LatencyRecorder;
 
-  OB(uint32_t symbol_id);
+private:
+
+  PLUGIN_HOOK(should_add, void, )
+  PLUGIN_HOOK(should_add_tracker, bool, true)
+  PLUGIN_HOOK(after_add_tracker, void, )
+  PLUGIN_HOOK(should_trade, void, )
+  PLUGIN_HOOK(after_trade, void, )
+  PLUGIN_HOOK(on_market_price_change, void, )
+  PLUGIN_HOOK(should_rest, void, )
+  PLUGIN_HOOK(after_rest, void, )
+  PLUGIN_HOOK(on_erase, void, )
+  PLUGIN_HOOK(on_time, void, )
+
+  /* snapshots of the plugins, not timed */
+  template <class P, class Writer>
+  auto save_state_hook(int, Writer& out) const -> decltype(P::save_state(out)) {
+    return P::save_state(out);
+  }
+  template <class P, class Writer>
+  void save_state_hook(long, Writer&) const {}
+
+  template <class P, class Reader>
+  auto load_state_hook(int, Reader& in) -> decltype(P::load_state(in)) {
+    return P::load_state(in);
+  }
+  template <class P, class Reader>
+  void load_state_hook(long, Reader&) {}
+
+  /* one section per plugin, empty for plugins without state */
+  template <class P, class Writer>
+  void save_section(Writer& out) const {
+    size_t at = out.begin_section();
+    save_state_hook<P>(0, out);
+    out.end_section(at);
+  }
+
+  template <class P, class Reader>
+  void load_section(Reader& in) {
+    size_t end = in.begin_section();
+    load_state_hook<P>(0, in);
+    in.end_section(end);
+  }
+
+public:
+  typedef typename Tracker::OrderPtr OrderPtr;
+  typedef typename Tracker::Price Price;
+  typedef typename Tracker::Qty Qty;
+  typedef Callback<OrderPtr, Price, Qty> TypedCallback;
+  typedef CallbackBuffer<TypedCallback> CallbackBuf;
+  typedef typename journal_policy<Storage>::type JournalPolicy;
+  typedef typename JournalPolicy::template Recorder<OrderPtr, Price, Qty> JournalRecorder;
+
+  /* handed to on_callbacks(). valid until it returns */
+  typedef CallbackSpan<TypedCallback> Callbacks;
+  typedef typename Storage::template Side<Tracker> TrackerMap;
+  typedef SideLevels<Price, Qty> Levels;
+
+  /* resting orders by identity of the order they track */
+  typedef std::unordered_map<const void*, typename TrackerMap::iterator,
+    std::hash<const void*>, std::equal_to<const void*>,
+    ArenaAllocator<std::pair<const void* const, typename TrackerMap::iterator>>> OrderIndex;
+
+  /* `capacity` is the number of resting orders to reserve room for */
+  BasicOB(uint32_t symbol_id, const TickScale& scale = TickScale(), size_t capacity = 0);
 
   bool add(const OrderPtr& order);
   bool add_tracker(Tracker& taker);
 
   void cancel(const OrderPtr& order, CancelReasons reason);
-  void replace(const OrderPtr& order, double delta);
-  void set_market_price(double price);
+
+  /**
+   * \brief adds or cancels a range of orders in sequence and delivers a
+   *  single batch of callbacks. with `coalesce_book_updates`, one
+   *  cb_book_update ends the batch instead of one per order. if an
+   *  order throws, e.g. a JournalException, the callbacks of the orders
+   *  before it are delivered and the rest of the range is not run
+   * \return for add_batch, the number of orders that matched
+   */
+  template <class Iterator>
+  size_t add_batch(Iterator first, Iterator last, bool coalesce_book_updates = true);
+
+  template <class Iterator>
+  void cancel_batch(Iterator first, Iterator last,
+    CancelReasons reason, bool coalesce_book_updates = true);
+
+  void replace(const OrderPtr& order, Qty delta);
+  void set_market_price(Price price);
+
+  /* moves the time of the book to `now`, for the plugins that act on
+    time. the book has no clock, its time is an input and is journaled
+    like the others. earlier times are ignored */
+  void advance_time(uint64_t now);
 
   uint32_t symbol_id() const { return symbol_id_; }
-  double market_price() const { return market_price_; }
+  uint64_t now() const { return now_; }
+  Price market_price() const { return market_price_; }
+
+  /* used by fixed-point trackers to convert orders to ticks and lots */
+  const TickScale& scale() const { return scale_; }
 
   const TrackerMap& bids() const { return bids_; }
   const TrackerMap& asks() const { return asks_; }
 
+  /* number of resting orders, both sides */
+  size_t order_count() const { return index_.size(); }
+
+  /* top of book, qty per level and per side, in the units of the
+    tracker. kept up to date by every change of the book, O(1) */
+  Price best_bid() const { return bid_levels_.best_price(); }
+  Price best_ask() const { return ask_levels_.best_price(); }
+  Qty best_bid_qty() const { return bid_levels_.best_qty(); }
+  Qty best_ask_qty() const { return ask_levels_.best_qty(); }
+
+  Level<Qty> level(bool is_bid, Price price) const { return levels(is_bid).level(price); }
+  Qty side_qty(bool is_bid) const { return levels(is_bid).qty(); }
+
+  const Levels& levels(bool is_bid) const { return is_bid ? bid_levels_ : ask_levels_; }
+
+  typedef book::Sweep<typename Tracker::Units> Sweep;
+
+  /**
+   * \brief what an order on side `is_bid` with `qty` and/or `funds` and
+   *  a `limit` price (0 for a market order) would fill if added now, from
+   *  the level aggregates. nothing is matched nor emitted, and plugins
+   *  are not consulted: self-trade prevention or routing may fill less,
+   *  and so may makers resting with funds, which show their open qty
+   */
+  Sweep simulate_sweep(bool is_bid, Qty qty, typename Tracker::Cost funds = 0, Price limit = 0) const {
+    return levels(!is_bid).template sweep<typename Tracker::Units>(qty, funds, limit);
+  }
+
+  /* the largest batch of callbacks expected, e.g. from a deep sweep */
+  void reserve_callbacks(size_t capacity) { callbacks_.reserve(capacity); }
+  const CallbackBuf& callback_buffer() const { return callbacks_; }
+
+  /* latency histograms, safe to read from other threads */
+  const LatencyRecorder& latency() const { return latency_; }
+
+  /* journal of the inputs, attach a JournalWriter to it to record them */
+  JournalRecorder& journal() { return journal_; }
+
+  /* snapshots, see snapshot.h. load() expects an empty book */
+  template <class Codec>
+  void save(SnapshotWriter<Codec>& out) const;
+
+  template <class Codec>
+  void load(SnapshotReader<Codec>& in);
+
 protected:
   /* for callbacks to be accessed from plugins */
-  Callbacks& callbacks() { return callbacks_; };
+  CallbackBuf& callbacks() { return callbacks_; };
 
   bool match(
     Tracker& taker,
     TrackerMap& makers);
 
-  double trade(
+  Qty trade(
     Tracker& taker,
     Tracker& maker);
 
+  Tracker make_tracker(const OrderPtr& order) const {
+    return make_tracker(order, std::integral_constant<bool, Tracker::Units::scaled>());
+  }
+
   bool find(
     const OrderPtr& order,
     typename TrackerMap::iterator& it);
 
+  typename TrackerMap::iterator rest(Tracker& tracker);
+
+  void erase(
+    TrackerMap& trackers,
+    typename TrackerMap::iterator it);
+
   void emit_callback(const TypedCallback& callback);
+  void emit_callback(TypedCallback&& callback);
   void emit_cancel_callback(
     const Tracker& tracker, CancelReasons reason);
 
   void process_callbacks();
 
+  /* after a trade, set_market_price() is for prices from outside */
+  void update_market_price(Price price);
+
+  /* returns false if the order was rejected */
+  bool do_add(const OrderPtr& order, bool& matched, bool emit_book_update);
+
   void do_cancel(const OrderPtr& order, CancelReasons reason);
-  void do_replace(const OrderPtr& order, double delta);
-  void replace_to_qty(const OrderPtr& order, double new_open_qty);
+  void do_replace(const OrderPtr& order, Qty delta);
+  void replace_to_qty(const OrderPtr& order, Qty new_open_qty);
 
   virtual void on_callbacks(const Callbacks& callbacks) = 0;
 
+  /* plugins ask for advance_time() to be called at `deadline` or later.
+    a book on its own is never woken, the timer service of an engine
+    shard wakes its books (see engine/timer_service.h) */
+  virtual void wake_at(uint64_t deadline) { (void) deadline; }
+
 private:
+  Levels& levels_of(bool is_bid) { return is_bid ? bid_levels_ : ask_levels_; }
+
+  Tracker make_tracker(const OrderPtr& order, std::false_type) const {
+    return Tracker(order);
+  }
+
+  Tracker make_tracker(const OrderPtr& order, std::true_type) const {
+    return Tracker(order, scale_);
+  }
+
+  bool on_grid(const OrderPtr&, std::false_type) const { return true; }
+
+  bool on_grid(const OrderPtr& order, std::true_type) const {
+    return scale_.on_ticks(order->price()) && scale_.on_lots(order->qty());
+  }
+
   uint32_t symbol_id_;
-  double market_price_;
+  TickScale scale_;
+  Price market_price_;
+  uint64_t now_;
   TrackerMap bids_;
   TrackerMap asks_;
-  Callbacks callbacks_;
+  OrderIndex index_;
+  Levels bid_levels_;
+  Levels ask_levels_;
+  CallbackBuf callbacks_;
   bool is_taker_cancelled_;
+  /* empty unless instrumented, it then fits after is_taker_cancelled_ */
+  LatencyRecorder latency_;
+  JournalRecorder journal_;
 };
 
+template <class Tracker, class... Plugins>
+using OB = BasicOB<MapStorage, Tracker, Plugins...>;
 
 template <class Tracker, class... Plugins>
-OB<Tracker, Plugins...>::OB(uint32_t symbol_id) :
+using LadderOB = BasicOB<LadderStorage, Tracker, Plugins...>;
+
+
+template <class Storage, class Tracker, class... Plugins>
+BasicOB<Storage, Tracker, Plugins...>::BasicOB(
+  uint32_t symbol_id, const TickScale& scale, size_t capacity) :
   symbol_id_(symbol_id),
+  scale_(scale),
   market_price_(0),
+  now_(0),
+  bids_(&arena()),
+  asks_(&arena()),
+  index_(&arena()),
+  bid_levels_(true, &arena()),
+  ask_levels_(false, &arena()),
+  callbacks_(DEFAULT_CALLBACK_CAPACITY),
   is_taker_cancelled_(false)
 {
-  callbacks_.reserve(20);
+  arena().reserve(capacity);
+  index_.reserve(capacity);
 }
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::set_market_price(double price) {
-  double prev_market_price = market_price_;
+template <class Storage, class Tracker, class... Plugins>
+template <class Codec>
+void BasicOB<Storage, Tracker, Plugins...>::save(SnapshotWriter<Codec>& out) const {
+  out.put(market_price_);
+  out.put(now_);
+
+  out.put((uint64_t) bids_.size());
+  for(auto it = bids_.begin(); it != bids_.end(); ++it)
+    out.put_tracker(it->second);
+
+  out.put((uint64_t) asks_.size());
+  for(auto it = asks_.begin(); it != asks_.end(); ++it)
+    out.put_tracker(it->second);
+
+  (void) std::initializer_list<int>{ (save_section<BoundPlugin<Plugins>>(out), 0)... };
+}
+
+template <class Storage, class Tracker, class... Plugins>
+template <class Codec>
+void BasicOB<Storage, Tracker, Plugins...>::load(SnapshotReader<Codec>& in) {
+  if(order_count() != 0)
+    throw SnapshotException("snapshot loaded into a book that is not empty");
+
+  if(in.sections() != sizeof...(Plugins))
+    throw SnapshotException("snapshot of a book with other plugins");
+
+  market_price_ = in.template get<Price>();
+  now_ = in.template get<uint64_t>();
+
+  /* saved in priority order, each rests behind the previous one */
+  for(int side = 0; side < 2; ++side) {
+    uint64_t count = in.template get<uint64_t>();
+    index_.reserve(index_.size() + count);
+
+    for(uint64_t i = 0; i < count; ++i) {
+      Tracker tracker = make_tracker(in.get_order());
+      in.restore_tracker(tracker);
+      rest(tracker);
+    }
+  }
+
+  (void) std::initializer_list<int>{ (load_section<BoundPlugin<Plugins>>(in), 0)... };
+}
+
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::set_market_price(Price price) {
+  journal_.market_price(price);
+  update_market_price(price);
+}
+
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::update_market_price(Price price) {
+  Price prev_market_price = market_price_;
   market_price_ = price;
-  INVOKE_PLUGIN_HOOKS(on_market_price_change(prev_market_price, price))
+  INVOKE_PLUGIN_HOOKS(on_market_price_change, prev_market_price, price)
 }
 
-template <class Tracker, class... Plugins>
-bool OB<Tracker, Plugins...>::add(const OrderPtr& order) {
+template <class Storage, class Tracker, class... Plugins>
+bool BasicOB<Storage, Tracker, Plugins...>::add(const OrderPtr& order) {
+  journal_.add(order);
+
+  bool matched = false;
+  {
+    typename LatencyRecorder::OpTimer timer(latency_, latency_add);
+    do_add(order, matched, true);
+  }
+  process_callbacks();
+
+  return matched;
+}
+
+template <class Storage, class Tracker, class... Plugins>
+template <class Iterator>
+size_t BasicOB<Storage, Tracker, Plugins...>::add_batch(
+  Iterator first, Iterator last, bool coalesce_book_updates)
+{
+  journal_.add_batch(coalesce_book_updates);
+
+  size_t matched_count = 0;
+  bool accepted_any = false;
+  try {
+    typename LatencyRecorder::OpTimer timer(latency_, latency_add_batch);
+
+    for(; first != last; ++first) {
+      journal_.add(*first);
+
+      bool matched = false;
+      accepted_any |= do_add(*first, matched, !coalesce_book_updates);
+      matched_count += matched;
+    }
+
+    journal_.batch_end();
+
+    if(coalesce_book_updates && accepted_any)
+      emit_callback(TypedCallback::book_update());
+  }
+  catch(...) {
+    /* what the orders before the throw did is delivered, not left for
+      the next call */
+    process_callbacks();
+    throw;
+  }
+
+  process_callbacks();
+  return matched_count;
+}
+
+template <class Storage, class Tracker, class... Plugins>
+bool BasicOB<Storage, Tracker, Plugins...>::do_add(
+  const OrderPtr& order, bool& matched, bool emit_book_update)
+{
   assert(order->qty() != 0 || order->funds() != 0);
 
-  Tracker taker(order);
+  if(!on_grid(order, std::integral_constant<bool, Tracker::Units::scaled>())) {
+    emit_callback(TypedCallback::reject(order, off_grid));
+    return false;
+  }
+
+  Tracker taker = make_tracker(order);
 
   InsertRejectReasons reject_reason = dont_reject;
-  INVOKE_PLUGIN_HOOKS(should_add(taker, reject_reason));
+  INVOKE_PLUGIN_HOOKS(should_add, taker, reject_reason)
 
   if(reject_reason != dont_reject) {
     emit_callback(TypedCallback::reject(order, reject_reason));
-    process_callbacks();
     return false;
   }
 
@@ -143,25 +490,24 @@ bool OB<Tracker, Plugins...>::add(const OrderPtr& order) {
   size_t accept_cb_index = callbacks_.size();
   emit_callback(TypedCallback::accept(order));
   
-  bool should_add_tracker_value = TRUE_FOR_ALL_PLUGINS(should_add_tracker(taker));
+  bool should_add_tracker_value = TRUE_FOR_ALL_PLUGINS(should_add_tracker, taker);
 
-  bool matched = should_add_tracker_value && add_tracker(taker);
+  matched = should_add_tracker_value && add_tracker(taker);
 
   callbacks_[accept_cb_index].qty = taker.filled_qty();
   callbacks_[accept_cb_index].avg_price = taker.avg_price();
 
-  emit_callback(TypedCallback::book_update());
-  process_callbacks();
+  if(emit_book_update)
+    emit_callback(TypedCallback::book_update());
 
-  return matched;
+  return true;
 }
 
 
-template <class Tracker, class... Plugins>
-bool OB<Tracker, Plugins...>::add_tracker(Tracker& taker) {
+template <class Storage, class Tracker, class... Plugins>
+bool BasicOB<Storage, Tracker, Plugins...>::add_tracker(Tracker& taker) {
   bool matched = false;
 
-  TrackerMap& takers = taker.is_bid() ? bids_ : asks_;
   TrackerMap& makers = taker.is_bid() ? asks_ : bids_;
 
   matched = match(taker, makers);
@@ -171,17 +517,27 @@ bool OB<Tracker, Plugins...>::add_tracker(Tracker& taker) {
       emit_callback(TypedCallback::cancel(
         taker.ptr(), 0, taker.filled_qty(), taker.avg_price(), no_liquidity));
     
-      INVOKE_PLUGIN_HOOKS(after_add_tracker(taker))  
+      INVOKE_PLUGIN_HOOKS(after_add_tracker, taker)  
     }
 
     else {
-      auto it = takers.emplace(std::make_pair(
-        BookPrice(taker.is_bid(), taker.price()), std::move(taker)));
-
-      INVOKE_PLUGIN_HOOKS(after_add_tracker(it->second))
+      /* what is left of the taker rests, unless a plugin cancels it */
+      CancelReasons rest_reason = dont_cancel;
+      INVOKE_PLUGIN_HOOKS(should_rest, taker, rest_reason)
+
+      if(rest_reason != dont_cancel) {
+        emit_cancel_callback(taker, rest_reason);
+        INVOKE_PLUGIN_HOOKS(after_add_tracker, taker)
+      }
+
+      else {
+        auto it = rest(taker);
+        INVOKE_PLUGIN_HOOKS(after_rest, it->second)
+        INVOKE_PLUGIN_HOOKS(after_add_tracker, it->second)
+      }
     }
   } else {
-    INVOKE_PLUGIN_HOOKS(after_add_tracker(taker))  
+    INVOKE_PLUGIN_HOOKS(after_add_tracker, taker)  
   }
 
   is_taker_cancelled_ = false;
@@ -192,21 +548,23 @@ bool OB<Tracker, Plugins...>::add_tracker(Tracker& taker) {
 /**
  * \brief creates trades given on taker and a sorted map of makers
  * \param taker the taker order
- * \param makers sorted map of makers, can be bids_ or asks_
+ * \param makers sorted side of makers, can be bids_ or asks_
  */
 
-template <class Tracker, class... Plugins>
-bool OB<Tracker, Plugins...>::match(
+template <class Storage, class Tracker, class... Plugins>
+bool BasicOB<Storage, Tracker, Plugins...>::match(
   Tracker& taker,
   TrackerMap& makers)
 {
+  typename LatencyRecorder::OpTimer timer(latency_, latency_match);
+
   bool matched = false;
   auto pos = makers.begin(); 
   
   while(pos != makers.end() && !taker.filled()) {
     auto entry = pos++;
 
-    const BookPrice& maker_book_price = entry->first;
+    const typename TrackerMap::key_type& maker_book_price = entry->first;
     if(!maker_book_price.matches(taker.price())) break;
 
     Tracker& maker = entry->second;
@@ -214,12 +572,12 @@ bool OB<Tracker, Plugins...>::match(
     CancelReasons taker_reason = dont_cancel,
                   maker_reason = dont_cancel;
     
-    INVOKE_PLUGIN_HOOKS(should_trade(
-      taker, maker, taker_reason, maker_reason))
+    INVOKE_PLUGIN_HOOKS(should_trade,
+      taker, maker, taker_reason, maker_reason)
 
     if(maker_reason != dont_cancel) {
       emit_cancel_callback(maker, maker_reason);
-      makers.erase(entry);
+      erase(makers, entry);
     }
 
     if(taker_reason != dont_cancel) {
@@ -231,13 +589,13 @@ bool OB<Tracker, Plugins...>::match(
     if(maker_reason != dont_cancel)
       continue;
     
-    double traded = trade(taker, maker);
+    Qty traded = trade(taker, maker);
 
     if(traded > 0) {
       matched = true;
 
       if(maker.filled())
-        makers.erase(entry);
+        erase(makers, entry);
     }
   }
 
@@ -250,23 +608,25 @@ bool OB<Tracker, Plugins...>::match(
  *  orders. generates fill callbacks & updates trackers accordingly 
 */
 
-template <class Tracker, class... Plugins>
-double OB<Tracker, Plugins...>::trade(
+template <class Storage, class Tracker, class... Plugins>
+typename BasicOB<Storage, Tracker, Plugins...>::Qty
+BasicOB<Storage, Tracker, Plugins...>::trade(
   Tracker& taker,
   Tracker& maker)
 {
-  double xprice = maker.price();
+  Price xprice = maker.price();
   assert(xprice > 0);
 
-  const double taker_qty = taker.tradable_qty(xprice);
-  const double maker_qty = maker.tradable_qty(xprice);
+  const Qty taker_qty = taker.tradable_qty(xprice);
+  const Qty maker_qty = maker.tradable_qty(xprice);
 
-  const double fill_qty = std::min(taker_qty, maker_qty);
-  const double fill_cost = fill_qty * xprice;
+  const Qty fill_qty = std::min(taker_qty, maker_qty);
+  const typename Tracker::Cost fill_cost = fill_qty * xprice;
 
   if(fill_qty > 0) {
     taker.fill(fill_qty, fill_cost);
     maker.fill(fill_qty, fill_cost);
+    levels_of(maker.is_bid()).change(xprice, -fill_qty);
 
     typename TypedCallback::FillFlags fill_flags = 
       TypedCallback::neither_filled;
@@ -285,31 +645,51 @@ double OB<Tracker, Plugins...>::trade(
       taker.ptr(), maker.ptr(), fill_qty, xprice,
       taker.avg_price(), maker.avg_price(), taker.filled_qty(), maker.filled_qty(), fill_flags));
 
-    set_market_price(xprice);
+    update_market_price(xprice);
 
-    INVOKE_PLUGIN_HOOKS(after_trade(
-      taker, maker, maker.is_bid(), fill_qty, xprice));
+    INVOKE_PLUGIN_HOOKS(after_trade,
+      taker, maker, maker.is_bid(), fill_qty, xprice)
   }
 
   return fill_qty;
 }
 
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::process_callbacks() {
-  on_callbacks(callbacks_);
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::advance_time(uint64_t now) {
+  if(now <= now_) return;
+
+  journal_.time(now);
+  now_ = now;
+  INVOKE_PLUGIN_HOOKS(on_time, now)
+
+  if(callbacks_.size() > 0)
+    process_callbacks();
+}
+
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::process_callbacks() {
+  /* muted while a journal is fast-forwarded */
+  if(!journal_.muted())
+    on_callbacks(callbacks_.span());
   callbacks_.clear();
 }
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::emit_callback(const TypedCallback& callback)
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::emit_callback(const TypedCallback& callback)
 {
   callbacks_.push_back(callback);
 }
 
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::emit_callback(TypedCallback&& callback)
+{
+  callbacks_.push_back(std::move(callback));
+}
+
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::emit_cancel_callback(
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::emit_cancel_callback(
   const Tracker& tracker, CancelReasons reason)
 {
   callbacks_.push_back(TypedCallback::cancel(
@@ -321,17 +701,53 @@ void OB<Tracker, Plugins...>::emit_cancel_callback(
 }
 
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::cancel(
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::cancel(
   const OrderPtr& order, CancelReasons reason)
 {
-  do_cancel(order, reason);
-  emit_callback(TypedCallback::book_update());
+  journal_.cancel(order, reason);
+  {
+    typename LatencyRecorder::OpTimer timer(latency_, latency_cancel);
+    do_cancel(order, reason);
+    emit_callback(TypedCallback::book_update());
+  }
   process_callbacks();
 }
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::do_cancel(
+template <class Storage, class Tracker, class... Plugins>
+template <class Iterator>
+void BasicOB<Storage, Tracker, Plugins...>::cancel_batch(
+  Iterator first, Iterator last, CancelReasons reason, bool coalesce_book_updates)
+{
+  journal_.cancel_batch(coalesce_book_updates);
+
+  try {
+    typename LatencyRecorder::OpTimer timer(latency_, latency_cancel_batch);
+
+    for(; first != last; ++first) {
+      journal_.cancel(*first, reason);
+      do_cancel(*first, reason);
+
+      if(!coalesce_book_updates)
+        emit_callback(TypedCallback::book_update());
+    }
+
+    journal_.batch_end();
+
+    if(coalesce_book_updates)
+      emit_callback(TypedCallback::book_update());
+  }
+  catch(...) {
+    /* see add_batch() */
+    process_callbacks();
+    throw;
+  }
+
+  process_callbacks();
+}
+
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::do_cancel(
   const OrderPtr& order, CancelReasons reason)
 {
   typename TrackerMap::iterator it;
@@ -347,7 +763,7 @@ void OB<Tracker, Plugins...>::do_cancel(
     if(tracker.filled()) return;
 
     emit_cancel_callback(tracker, reason);
-    trackers.erase(it);
+    erase(trackers, it);
   }
 
   else if(reason == user_cancel) {
@@ -357,17 +773,21 @@ void OB<Tracker, Plugins...>::do_cancel(
 }
 
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::replace(
-  const OrderPtr& order, double delta)
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::replace(
+  const OrderPtr& order, Qty delta)
 {
-  do_replace(order, delta);
+  journal_.replace(order, delta);
+  {
+    typename LatencyRecorder::OpTimer timer(latency_, latency_replace);
+    do_replace(order, delta);
+  }
   process_callbacks();
 }
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::do_replace(
-  const OrderPtr& order, double delta)
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::do_replace(
+  const OrderPtr& order, Qty delta)
 {
   typename TrackerMap::iterator it;
 
@@ -377,7 +797,7 @@ void OB<Tracker, Plugins...>::do_replace(
 
   Tracker& tracker = it->second;
 
-  double open_qty = tracker.qty_on_book();
+  Qty open_qty = tracker.qty_on_book();
 
   if(open_qty == 0)
     return emit_callback(TypedCallback::replace_reject(
@@ -388,22 +808,23 @@ void OB<Tracker, Plugins...>::do_replace(
   }
 
   tracker.change_open_qty(delta);
+  levels_of(tracker.is_bid()).change(tracker.price(), delta);
 
   emit_callback(TypedCallback::replace(
     tracker.ptr(), delta, open_qty, tracker.filled_qty(), tracker.avg_price()));
 
-  if(tracker.qty_on_book() < MIN_ORDER_QTY) {
+  if(tracker.qty_on_book() < Tracker::min_qty()) {
     TrackerMap& trackers = tracker.is_bid() ? bids_ : asks_;
     emit_cancel_callback(tracker, replaced_all_qty);
-    trackers.erase(it);
+    erase(trackers, it);
   }
 
   emit_callback(TypedCallback::book_update());
 }
 
-template <class Tracker, class... Plugins>
-void OB<Tracker, Plugins...>::replace_to_qty(
-  const OrderPtr& order, double new_open_qty)
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::replace_to_qty(
+  const OrderPtr& order, Qty new_open_qty)
 {
   typename TrackerMap::iterator it;
 
@@ -413,23 +834,24 @@ void OB<Tracker, Plugins...>::replace_to_qty(
 
   Tracker& tracker = it->second;
 
-  double open_qty = tracker.qty_on_book();
+  Qty open_qty = tracker.qty_on_book();
 
   if(open_qty == 0)
     return emit_callback(TypedCallback::replace_reject(
       order, tracker.filled_qty(), tracker.avg_price(), replace_reject_no_qty));
 
-  double delta = new_open_qty - open_qty;
+  Qty delta = new_open_qty - open_qty;
 
   tracker.change_open_qty(delta);
+  levels_of(tracker.is_bid()).change(tracker.price(), delta);
 
   emit_callback(TypedCallback::replace(
     tracker.ptr(), delta, open_qty, tracker.filled_qty(), tracker.avg_price()));
 
-  if(tracker.qty_on_book() < MIN_ORDER_QTY) {
+  if(tracker.qty_on_book() < Tracker::min_qty()) {
     TrackerMap& trackers = tracker.is_bid() ? bids_ : asks_;
     emit_cancel_callback(tracker, replaced_all_qty);
-    trackers.erase(it);
+    erase(trackers, it);
   }
 
   emit_callback(TypedCallback::book_update());
@@ -437,24 +859,54 @@ void OB<Tracker, Plugins...>::replace_to_qty(
 }
 
 
-template <class Tracker, class... Plugins>
-bool OB<Tracker, Plugins...>::find(
+template <class Storage, class Tracker, class... Plugins>
+bool BasicOB<Storage, Tracker, Plugins...>::find(
   const OrderPtr& order,
   typename TrackerMap::iterator& it)
 {
-  const BookPrice key(order->is_bid(), order->price());
-  TrackerMap& trackers = order->is_bid() ? bids_ : asks_;
+  auto pos = index_.find(&*order);
 
-  for(it = trackers.find(key); it != trackers.end(); ++it) {
-    if(it->second.ptr() == order) return true;
-    
-    else if(key < it->first) {
-      it = trackers.end();
-      return false;
-    }
-  }
-  
-  return false;
+  if(pos == index_.end())
+    return false;
+
+  it = pos->second;
+  return true;
+}
+
+/**
+ * \brief moves the tracker to its side of the book and indexes it
+ */
+
+template <class Storage, class Tracker, class... Plugins>
+typename BasicOB<Storage, Tracker, Plugins...>::TrackerMap::iterator
+BasicOB<Storage, Tracker, Plugins...>::rest(Tracker& tracker)
+{
+  TrackerMap& trackers = tracker.is_bid() ? bids_ : asks_;
+
+  auto it = trackers.emplace(
+    typename TrackerMap::key_type(tracker.is_bid(), tracker.price()), std::move(tracker));
+
+  auto indexed = index_.emplace(&*it->second.ptr(), it);
+  levels_of(it->second.is_bid()).add(it->second.price(), it->second.qty_on_book());
+
+  /* an order can only rest once */
+  assert(indexed.second);
+  (void) indexed;
+
+  return it;
+}
+
+template <class Storage, class Tracker, class... Plugins>
+void BasicOB<Storage, Tracker, Plugins...>::erase(
+  TrackerMap& trackers,
+  typename TrackerMap::iterator it)
+{
+  const Tracker& tracker = it->second;
+  INVOKE_PLUGIN_HOOKS(on_erase, tracker)
+  levels_of(tracker.is_bid()).remove(tracker.price(), tracker.qty_on_book());
+
+  index_.erase(&*tracker.ptr());
+  trackers.erase(it);
 }
 
 }
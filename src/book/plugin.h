@@ -25,64 +25,111 @@
 #include <vector>
 #include <map>
 #include <book/callback.h>
+#include <book/callback_buffer.h>
 #include <book/tracker.h>
 #include <book/book_price.h>
+#include <book/storage.h>
+#include <book/arena.h>
 
 namespace book {
 
-template <class Tracker>
-class Plugin {
+/* Book of a plugin that is not mixed into an OB yet, e.g. when naming
+ * RoutablePlugin<Tracker>::RoutingRequest */
+struct UnboundBook {};
+
+template <class Book>
+struct book_traits {
+  typedef MapStorage Storage;
+};
+
+template <class Storage_, class Tracker, class... Plugins>
+struct book_traits<BasicOB<Storage_, Tracker, Plugins...>> {
+  typedef Storage_ Storage;
+};
+
+/**
+ * \brief base of the plugins. plugins are declared as P<Tracker> and OB
+ *  rebinds them to P<Tracker, OB> (see bind_book), so that calls into the
+ *  book are static. Self is the plugin itself, through which the book is
+ *  reached without ambiguity when several plugins are mixed in.
+ *
+ *  hooks are not declared here. a plugin implements the hooks it needs,
+ *  with the signatures below, and OB detects at compile time which ones
+ *  each plugin has. hooks a plugin lacks cost nothing.
+ *
+ *    void should_add(const Tracker& taker, InsertRejectReasons& reason);
+ *    bool should_add_tracker(const Tracker& taker);
+ *    void after_add_tracker(const Tracker& taker);
+ *    void should_trade(Tracker& taker, Tracker& maker,
+ *      CancelReasons& taker_reason, CancelReasons& maker_reason);
+ *    void after_trade(Tracker& taker, Tracker& maker,
+ *      bool maker_is_bid, Qty qty, Price price);
+ *    void on_market_price_change(Price prev_price, Price new_price);
+ *    void should_rest(const Tracker& taker, CancelReasons& reason);
+ *    void after_rest(const Tracker& tracker);
+ *    void on_erase(const Tracker& tracker);
+ *    void on_time(uint64_t now);
+ *
+ *  after_rest is called once the remainder of a taker rests, on_erase
+ *  when a resting order leaves the book (filled, cancelled or replaced to
+ *  nothing), before it is removed. orders loaded from a snapshot rest
+ *  without after_rest, plugins rebuild what they need in load_state.
+ *  on_time runs when the time of the book moves, see OB::advance_time().
+ *  plugins ask with wake_at() to be called back at a time of their
+ *  choosing, which only an engine does (see engine/timer_service.h).
+ */
+
+template <class Tracker, class Book, class Self>
+class Plugin : public virtual ArenaOwner {
 protected:
   using OrderPtr = typename Tracker::OrderPtr;
-  typedef std::multimap<BookPrice, Tracker> TrackerMap;
-  typedef std::vector<Tracker> TrackerVec;
-  typedef Callback<OrderPtr> TypedCallback;
-
-  virtual std::vector<TypedCallback>& callbacks() = 0;
-  virtual void emit_callback(const TypedCallback& callback) = 0;
-  virtual void emit_cancel_callback(
-    const Tracker& tracker, CancelReasons reason) = 0;
-
-  virtual void cancel(const OrderPtr& order, CancelReasons reason) = 0;
-  virtual void do_cancel(const OrderPtr& order, CancelReasons reason) = 0;
-  virtual void do_replace(const OrderPtr& order, double delta) = 0;
-  virtual bool add_tracker(Tracker& taker) = 0;
-  virtual bool add(const OrderPtr& order) = 0;
-  virtual double market_price() const = 0;
-
-  virtual void process_callbacks() = 0;
-  virtual uint32_t symbol_id() const = 0;
-
-  virtual const TrackerMap& bids() const = 0;
-  virtual const TrackerMap& asks() const = 0;
-
-  virtual void should_add(
-    const Tracker& taker,
-    InsertRejectReasons& reason) { }
-
-  virtual bool should_add_tracker(
-    const Tracker& taker) { return true; }
-
-  virtual void after_add_tracker(
-    const Tracker& taker) {}
-
-  virtual void should_trade(
-    Tracker& taker,
-    Tracker& maker,
-    CancelReasons& taker_reason,
-    CancelReasons& maker_reason) { }
-
-  virtual void after_trade(
-    Tracker& taker,
-    Tracker& maker,
-    bool maker_is_bid,
-    double qty,
-    double price) {}
-
-  virtual void on_market_price_change(
-    double prev_price,
-    double new_price) {}
-
+  typedef typename Tracker::Price Price;
+  typedef typename Tracker::Qty Qty;
+  typedef typename book_traits<Book>::Storage Storage;
+  typedef typename Storage::template Side<Tracker> TrackerMap;
+  typedef std::vector<Tracker, ArenaAllocator<Tracker>> TrackerVec;
+  typedef Callback<OrderPtr, Price, Qty> TypedCallback;
+
+  Book& book() { return static_cast<Book&>(static_cast<Self&>(*this)); }
+  const Book& book() const { return static_cast<const Book&>(static_cast<const Self&>(*this)); }
+
+  CallbackBuffer<TypedCallback>& callbacks() { return book().callbacks(); }
+
+  void emit_callback(const TypedCallback& callback) { book().emit_callback(callback); }
+  void emit_callback(TypedCallback&& callback) { book().emit_callback(std::move(callback)); }
+
+  void emit_cancel_callback(const Tracker& tracker, CancelReasons reason) {
+    book().emit_cancel_callback(tracker, reason);
+  }
+
+  void cancel(const OrderPtr& order, CancelReasons reason) { book().cancel(order, reason); }
+  void do_cancel(const OrderPtr& order, CancelReasons reason) { book().do_cancel(order, reason); }
+  void do_replace(const OrderPtr& order, Qty delta) { book().do_replace(order, delta); }
+  bool add_tracker(Tracker& taker) { return book().add_tracker(taker); }
+  bool add(const OrderPtr& order) { return book().add(order); }
+  Price market_price() const { return book().market_price(); }
+
+  void process_callbacks() { book().process_callbacks(); }
+  /* a tracker saved with SnapshotWriter::put_tracker() */
+  template <class Reader>
+  Tracker load_tracker(Reader& in) {
+    Tracker tracker = book().make_tracker(in.get_order());
+    in.restore_tracker(tracker);
+    return tracker;
+  }
+
+  void journal_routing_response(uint64_t request_id, bool success) {
+    book().journal_.routing_response(request_id, success);
+  }
+  void journal_routing_partial(uint64_t request_id, Qty filled_qty) {
+    book().journal_.routing_partial(request_id, filled_qty);
+  }
+  uint64_t now() const { return book().now(); }
+  void wake_at(uint64_t deadline) { book().wake_at(deadline); }
+  uint32_t symbol_id() const { return book().symbol_id(); }
+
+  const TrackerMap& bids() const { return book().bids(); }
+  const TrackerMap& asks() const { return book().asks(); }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#include <book/plugin.h>
+#include <book/timer_wheel.h>
+#include <book/types.h>
+
+namespace book {
+namespace plugins {
+
+template <class OrderPtr>
+struct ExpiryTracker {
+  ExpiryTracker(const OrderPtr& order) : expire_time_(order->expire_time()) {}
+
+  uint64_t expire_time() const { return expire_time_; }
+
+private:
+  uint64_t expire_time_;
+};
+
+template <class OrderPtr>
+struct ExpiryState {
+  explicit ExpiryState(const OrderPtr& order) : expire_time_(order->expire_time()) {}
+
+  uint64_t expire_time_;
+
+  template <class Tracker>
+  struct Accessors {
+    uint64_t expire_time() const {
+      return static_cast<const Tracker*>(this)->template state<ExpiryState>().expire_time_;
+    }
+  };
+};
+
+struct ExpiryOrder {
+  /* good-till-date, in the time of OB::advance_time(). 0 for
+    an order that does not expire */
+  virtual uint64_t expire_time() const = 0;
+};
+
+/**
+ * \brief good-till-date orders, cancelled with `expired` once their
+ *  expire time is reached.
+ *
+ *  orders expire as the time of the book moves with OB::advance_time(),
+ *  which is journaled so that a replay expires the same orders at the
+ *  same point. in an engine, the timer service of the shard advances it
+ *  when the earliest expire time is reached. orders expiring while they
+ *  rest are kept in a TimerWheel, inserted when they rest and erased when
+ *  they leave the book, both O(1). the orders due are cancelled in one
+ *  batch, earliest first. an order arriving at or after its expire time may
+ *  still match, what is left is cancelled instead of resting.
+ */
+
+template <class Tracker, class Book = UnboundBook>
+class ExpiryPlugin :
+public Plugin<Tracker, Book, ExpiryPlugin<Tracker, Book>>
+{
+public:
+  typedef typename Tracker::OrderPtr OrderPtr;
+  typedef typename Plugin<Tracker, Book, ExpiryPlugin<Tracker, Book>>::TypedCallback TypedCallback;
+  typedef TimerWheel<OrderPtr> Timers;
+
+  ExpiryPlugin() : timers_(&this->arena()), index_(&this->arena()),
+    expired_(&this->arena()) {}
+
+  /* resting orders waiting to expire */
+  size_t expiring_orders() const { return timers_.size(); }
+
+protected:
+  void should_rest(const Tracker& taker, CancelReasons& reason) {
+    uint64_t expire_time = taker.expire_time();
+    if(reason == dont_cancel && expire_time != 0 && expire_time <= this->now())
+      reason = expired;
+  }
+
+  void after_rest(const Tracker& tracker) {
+    uint64_t expire_time = tracker.expire_time();
+    if(expire_time == 0) return;
+
+    index_.emplace(&*tracker.ptr(), timers_.insert(expire_time, tracker.ptr()));
+    this->wake_at(expire_time);
+  }
+
+  /* cancels the resting orders whose expire time is `now` or earlier,
+    earliest first */
+  void on_time(uint64_t now) {
+    timers_.advance(now, [this](OrderPtr& order, uint64_t) {
+      expired_.push_back(order);
+    });
+
+    if(!timers_.empty())
+      this->wake_at(timers_.next_tick());
+
+    if(expired_.empty())
+      return;
+
+    for(auto it = expired_.begin(); it != expired_.end(); ++it) {
+      index_.erase(&*(*it));
+      this->do_cancel(*it, expired);
+    }
+
+    expired_.clear();
+    this->emit_callback(TypedCallback::book_update());
+  }
+
+  void on_erase(const Tracker& tracker) {
+    if(tracker.expire_time() == 0) return;
+
+    /* not found when it is being cancelled by on_time() */
+    auto it = index_.find(&*tracker.ptr());
+    if(it == index_.end()) return;
+
+    timers_.erase(it->second);
+    index_.erase(it);
+  }
+
+  /* nothing is saved, the timers are those of the resting orders and the
+    time is that of the book */
+  template <class Reader>
+  void load_state(Reader&) {
+    timers_.clear(this->now());
+    index_.clear();
+
+    load_timers(this->bids());
+    load_timers(this->asks());
+  }
+
+private:
+  typedef typename Timers::Handle Handle;
+
+  template <class Side>
+  void load_timers(const Side& side) {
+    for(auto it = side.begin(); it != side.end(); ++it)
+      after_rest(it->second);
+  }
+
+  Timers timers_;
+
+  /* timer of each resting order that expires, by identity of the order */
+  std::unordered_map<const void*, Handle, std::hash<const void*>, std::equal_to<const void*>,
+    ArenaAllocator<std::pair<const void* const, Handle>>> index_;
+
+  /* due orders of an on_time(), cancelled once the wheel is done */
+  std::vector<OrderPtr, ArenaAllocator<OrderPtr>> expired_;
+};
+
+}
+}
@@ -57,19 +57,24 @@ public:
   virtual void on_position_close(uint64_t user_id) { };
 };
 
-template <class Tracker>
+template <class Tracker, class Book = UnboundBook>
 class PositionsPlugin : public virtual PositionsInterface,
-public Plugin<Tracker> {
+public Plugin<Tracker, Book, PositionsPlugin<Tracker, Book>> {
+public:
+  PositionsPlugin() : positions_(&this->arena()) {}
+
 protected:
   typedef typename Tracker::OrderPtr OrderPtr;
-  typedef Callback<OrderPtr> TypedCallback;
+  typedef typename Tracker::Price Price;
+  typedef typename Tracker::Qty Qty;
+  typedef typename Plugin<Tracker, Book, PositionsPlugin<Tracker, Book>>::TypedCallback TypedCallback;
 
   void after_trade(
     Tracker& taker,
     Tracker& maker,
     bool maker_is_bid,
-    double qty,
-    double price);
+    Qty qty,
+    Price price);
 
   void update_position(
     Position& pos,
@@ -81,18 +86,38 @@ protected:
   bool get_position(
     uint64_t user_id, Position& position);
 
+  template <class Writer>
+  void save_state(Writer& out) const {
+    out.put((uint64_t) positions_.size());
+    for(auto it = positions_.begin(); it != positions_.end(); ++it) {
+      out.put(it->first);
+      out.put(it->second);
+    }
+  }
+
+  template <class Reader>
+  void load_state(Reader& in) {
+    uint64_t count = in.template get<uint64_t>();
+    positions_.reserve(count);
+    for(uint64_t i = 0; i < count; ++i) {
+      uint64_t user_id = in.template get<uint64_t>();
+      positions_[user_id] = in.template get<Position>();
+    }
+  }
+
 private:
-  std::unordered_map<uint64_t, Position> positions_;
+  std::unordered_map<uint64_t, Position, std::hash<uint64_t>,
+    std::equal_to<uint64_t>, ArenaAllocator<std::pair<const uint64_t, Position>>> positions_;
 };
 
 
-template <class Tracker>
-void PositionsPlugin<Tracker>::after_trade(
+template <class Tracker, class Book>
+void PositionsPlugin<Tracker, Book>::after_trade(
   Tracker& taker,
   Tracker& maker,
   bool maker_is_bid,
-  double qty,
-  double price)
+  Qty qty,
+  Price price)
 {
   uint64_t taker_user_id = taker.user_id();
   uint64_t maker_user_id = maker.user_id();
@@ -104,8 +129,8 @@ void PositionsPlugin<Tracker>::after_trade(
   update_position(taker_pos, taker_user_id, !maker_is_bid, qty, price);
 }
 
-template <class Tracker>
-void PositionsPlugin<Tracker>::update_position(
+template <class Tracker, class Book>
+void PositionsPlugin<Tracker, Book>::update_position(
   Position& pos,
   uint64_t user_id,
   bool is_bid,
@@ -154,8 +179,8 @@ void PositionsPlugin<Tracker>::update_position(
   pos.qty = new_qty;
 }
 
-template <class Tracker>
-bool PositionsPlugin<Tracker>::get_position(
+template <class Tracker, class Book>
+bool PositionsPlugin<Tracker, Book>::get_position(
   uint64_t user_id, Position& position)
 {
   auto it = positions_.find(user_id);
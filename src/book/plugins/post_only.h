@@ -40,13 +40,27 @@ struct PostOnlyTracker {
     bool post_only_;
 };
 
+template <class OrderPtr>
+struct PostOnlyState {
+  explicit PostOnlyState(const OrderPtr& order) : post_only_(order->post_only()) {}
+
+  bool post_only_;
+
+  template <class Tracker>
+  struct Accessors {
+    bool post_only() const {
+      return static_cast<const Tracker*>(this)->template state<PostOnlyState>().post_only_;
+    }
+  };
+};
+
 struct PostOnlyOrder {
   virtual bool post_only() const = 0;
 };
 
-template <class Tracker>
+template <class Tracker, class Book = UnboundBook>
 class PostOnlyPlugin :
-public Plugin<Tracker>
+public Plugin<Tracker, Book, PostOnlyPlugin<Tracker, Book>>
 {
 protected:
   typedef typename Tracker::OrderPtr OrderPtr;
@@ -52,17 +52,34 @@ public virtual BaseTracker<OrderPtr> {
     const bool is_bid_;
 };
 
+template <class OrderPtr>
+struct ReduceOnlyState {
+  explicit ReduceOnlyState(const OrderPtr& order) : reduce_only_(order->reduce_only()) {}
+
+  bool reduce_only_;
+
+  template <class Tracker>
+  struct Accessors {
+    bool reduce_only() const {
+      return static_cast<const Tracker*>(this)->template state<ReduceOnlyState>().reduce_only_;
+    }
+  };
+};
+
 struct ReduceOnlyOrder {
   virtual bool reduce_only() const = 0;
 };
 
 
-template <class Tracker>
+template <class Tracker, class Book = UnboundBook>
 class ReduceOnlyPlugin : public virtual PositionsInterface,
-public Plugin<Tracker> {
+public Plugin<Tracker, Book, ReduceOnlyPlugin<Tracker, Book>> {
+public:
+  ReduceOnlyPlugin() : reduce_only_orders_(&this->arena()) {}
+
 protected:
   typedef typename Tracker::OrderPtr OrderPtr;
-  typedef Callback<OrderPtr> TypedCallback;
+  typedef typename Plugin<Tracker, Book, ReduceOnlyPlugin<Tracker, Book>>::TypedCallback TypedCallback;
 
   void should_trade(
     Tracker& taker,
@@ -120,8 +137,27 @@ protected:
     reduce_only_orders_.erase(user_id);
   }
 
+  template <class Writer>
+  void save_state(Writer& out) const {
+    out.put((uint64_t) reduce_only_orders_.size());
+    for(auto it = reduce_only_orders_.begin(); it != reduce_only_orders_.end(); ++it) {
+      out.put(it->first);
+      out.put_order(it->second);
+    }
+  }
+
+  template <class Reader>
+  void load_state(Reader& in) {
+    uint64_t count = in.template get<uint64_t>();
+    for(uint64_t i = 0; i < count; ++i) {
+      uint64_t user_id = in.template get<uint64_t>();
+      reduce_only_orders_.emplace_hint(reduce_only_orders_.end(), user_id, in.get_order());
+    }
+  }
+
 private:
-  std::multimap<uint64_t, OrderPtr> reduce_only_orders_;
+  std::multimap<uint64_t, OrderPtr, std::less<uint64_t>,
+    ArenaAllocator<std::pair<const uint64_t, OrderPtr>>> reduce_only_orders_;
 
 };
 
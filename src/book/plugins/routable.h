@@ -27,16 +27,44 @@
   - HOOK after_trade: if a trade involves a MM order,
     create a routing request for routing the order
 
-  - HOOK should_trade: temporary cancels the taker order pending routing response
+  - HOOK should_trade: temporary cancels the taker order pending routing response,
+    or once its request to a venue holds MaxFills fills
 
-  - HOOK after_add_tracker: silently cancel the remaining qty of the user order,
-    submit a routing request, and erase the callbacks related to the user order
+  - HOOK after_trade: keep the fill with a MM order in the request to its
+    venue, to be issued once the venue answers
+
+  - HOOK should_rest: a taker being routed never rests, what is left of
+    it is temporary cancelled
+
+  - HOOK after_add_tracker: keep the taker in its sweep, submit a routing
+    request, and erase the callbacks related to the user order
   
   - on_routing_success: issue a fill callback (and possibly a cancel callback too
     if there is qty remaining), and add_tracker() the tracker with the remaining qty if any.
 
   - on_routing_failure: issue a cancel callback
 
+  - on_routing_partial_success: issue the fill callbacks up to the qty the
+    venue filled, and a cancel callback for the rest of the user order
+
+  - HOOK on_time: requests to a venue with a timeout (set_routing_timeout)
+    that get no response by their deadline fail with routing_timeout.
+    a response arriving later is ignored
+
+  - MaxFills, the last template parameter (8 by default), is a limit of the
+    book: a taker that makes as many fills with the MM orders of a venue
+    stops there, and is routed before matching any further. a request holds
+    its fills inline, MaxFills times the size of BasicRoutingRequest::Fill,
+    so that it is copied and pooled without allocating
+
+  - set_parallel_routing: a taker crossing MM orders of several venues
+    makes one request per venue, all sent at once. each response replays
+    the fills of its venue as it arrives. the taker is added again, or
+    what the venues did not fill cancelled, once the last one is in, so
+    that a sweep waits for the slowest venue rather than for each in turn.
+    off by default, the taker then stops at the first venue and goes on
+    to the next once routed
+
 
   ASSUMPTIONS
   ===========
@@ -65,9 +93,8 @@
 
 #include <iostream>
 #include <vector>
-#include <list>
 #include <unordered_map>
-#include <set>
+#include <unordered_set>
 #include <memory>
 
 #include <book/types.h>
@@ -77,9 +104,10 @@
 #include <book/exceptions.h>
 #include <book/types.h>
 #include <book/callback.h>
+#include <book/pool.h>
+#include <book/timer_wheel.h>
 
 #include <utils/uint128.h>
-#include <utils/ts.h>
 
 #include <book/plugins/trackers/user_id_tracker.h>
 
@@ -103,29 +131,66 @@ public:
   }
 };
 
-template <class Tracker>
-class RoutablePlugin :
-public Plugin<Tracker> {
-public:
+/* depends on the tracker only, so that RoutablePlugin<Tracker>::RoutingRequest
+  names the same type as the one of the plugin bound to a book */
+template <class Tracker, size_t MaxFills = 8>
+struct BasicRoutingRequest {
   typedef typename Tracker::OrderPtr OrderPtr;
-  typedef std::shared_ptr<Tracker> TrackerPtr;
-  typedef Callback<OrderPtr> TypedCallback;
-
-  struct RoutingRequest {
-    uint64_t request_id;
-    uint32_t exchange_id;
-    uint32_t symbol_id;
-    double qty;
-    double price;
-    bool is_bid;
-    CancelReasons cancel_reason;
-    TrackerPtr maker;
-    TrackerPtr taker;
-    std::list<TypedCallback> callbacks;
+  typedef typename Tracker::Price Price;
+  typedef typename Tracker::Qty Qty;
+
+  /* fills a request holds at most. a taker that has made as many with the
+    market makers of a venue stops there, and goes on once routed */
+  static const size_t MAX_FILLS = MaxFills;
+
+  /* a fill with a market maker, what its trade callback is built from
+    once the venue answers (see Callback::fill), the taker aside */
+  struct Fill {
+    OrderPtr maker_order;
+    Qty qty;
+    Price price;
+    double taker_avg_price;
+    double maker_avg_price;
+    Qty taker_filled_qty;
+    Qty maker_filled_qty;
+    uint8_t flags;
   };
 
-  RoutablePlugin() {
-    next_routing_request_.request_id = 0;
+  uint64_t request_id;
+  uint32_t exchange_id;
+  uint32_t symbol_id;
+  Qty qty;
+  Price price;
+  bool is_bid;
+  CancelReasons cancel_reason;
+  /* time of the book at which the request times out, 0 for never */
+  uint64_t deadline;
+  /* request id of the first request of the taker sweep it is part of,
+    its own unless routed in parallel */
+  uint64_t sweep_id;
+  /* the fills with the market makers of the venue, replayed once it
+    answers. inline, so that a request is copied without allocating */
+  FixedBuffer<Fill, MaxFills> fills;
+};
+
+template <class Tracker, size_t MaxFills>
+const size_t BasicRoutingRequest<Tracker, MaxFills>::MAX_FILLS;
+
+template <class Tracker, class Book = UnboundBook, size_t MaxFills = 8>
+class RoutablePlugin :
+public Plugin<Tracker, Book, RoutablePlugin<Tracker, Book, MaxFills>> {
+public:
+  typedef typename Tracker::OrderPtr OrderPtr;
+  typedef typename Tracker::Price Price;
+  typedef typename Tracker::Qty Qty;
+  typedef typename Plugin<Tracker, Book, RoutablePlugin<Tracker, Book, MaxFills>>::TypedCallback TypedCallback;
+  typedef BasicRoutingRequest<Tracker, MaxFills> RoutingRequest;
+  typedef typename RoutingRequest::Fill Fill;
+
+  RoutablePlugin() : next_routing_requests_(&this->arena()),
+    requests_(&this->arena()), sweeps_(&this->arena()), last_request_id_(0),
+    pending_requests_(&this->arena()), pending_maker_order_ids_(&this->arena()),
+    timers_(&this->arena()), timed_out_(&this->arena()), parallel_routing_(false) {
     reset_request();
   }
 
@@ -134,12 +199,104 @@ public:
     X2MMU_.emplace(external_exchange_id, user_id);
   }
 
+  /* requests to `external_exchange_id` fail with routing_timeout if no
+    response comes within `timeout`, in the time of the book. 0 waits
+    forever, the default. applies to the requests made from now on */
+  void set_routing_timeout(uint32_t external_exchange_id, uint64_t timeout) {
+    timeouts_[external_exchange_id] = timeout;
+  }
+
+  /* route a taker to every venue it crosses at once rather than one venue
+    after the other, see the notes at the top */
+  void set_parallel_routing(bool parallel) { parallel_routing_ = parallel; }
+
+  /* room for `count` requests pending at once, and their sweeps, without
+    growing the pools */
+  void reserve_routing_requests(size_t count) {
+    requests_.reserve(count);
+    sweeps_.reserve(count);
+    pending_requests_.reserve(count);
+    pending_maker_order_ids_.reserve(count);
+    timers_.reserve(count);
+  }
+
+  /* requests waiting for a response */
+  size_t pending_routing_requests() const { return pending_requests_.size(); }
+
+  /* applies a journaled response, see JournalReplayer */
+  void replay_routing_response(uint64_t request_id, bool success) {
+    if(success) on_routing_success(request_id);
+    else on_routing_failure(request_id);
+  }
+
+  void replay_routing_partial(uint64_t request_id, Qty filled_qty) {
+    on_routing_partial_success(request_id, filled_qty);
+  }
+
 private:
-  RoutingRequest next_routing_request_;
-  std::unordered_map<uint64_t, RoutingRequest> pending_requests_;
-  std::set<uint128> pending_maker_order_ids_;
+  typedef TimerWheel<uint64_t> Timers;
+  typedef typename Timers::Handle Handle;
+
+  /* the requests of a sweep, answered in any order. the taker is added
+    again or cancelled when the last is. `reason` is that of the first
+    request not filled in full, dont_cancel while there is none */
+  struct PendingSweep {
+    explicit PendingSweep(Tracker taker_) : taker(std::move(taker_)), sweep_id(0),
+      outstanding(0), unfilled_qty(), reason(dont_cancel) {}
+
+    Tracker taker;
+    uint64_t sweep_id;
+    uint32_t outstanding;
+    Qty unfilled_qty;
+    CancelReasons reason;
+  };
+
+  typedef Pool<PendingSweep> Sweeps;
+  typedef typename Sweeps::Handle SweepHandle;
+
+  /* a request, its timeout, npos if it has none, and its sweep */
+  struct Pending {
+    Pending(RoutingRequest request_, SweepHandle sweep_) :
+      request(std::move(request_)), timer(Timers::npos), sweep(sweep_) {}
+
+    RoutingRequest request;
+    Handle timer;
+    SweepHandle sweep;
+  };
+
+  typedef Pool<Pending> Requests;
+  typedef typename Requests::Handle RequestHandle;
+  typedef std::unordered_map<uint64_t, RequestHandle, std::hash<uint64_t>, std::equal_to<uint64_t>,
+    ArenaAllocator<std::pair<const uint64_t, RequestHandle>>> RequestIndex;
+
+  /* a request being made, and the fills with its venue so far */
+  struct Staged {
+    RoutingRequest request;
+    size_t fills;
+  };
+
+  /* one request per venue the taker crosses, a single one unless routed
+    in parallel */
+  std::vector<Staged, ArenaAllocator<Staged>> next_routing_requests_;
+
+  /* pending requests and sweeps live in pools, their slots recycled */
+  Requests requests_;
+  Sweeps sweeps_;
+
+  /* request ids are a sequence of the book, so that replays route alike */
+  uint64_t last_request_id_;
+  RequestIndex pending_requests_;
+  std::unordered_set<uint128, Uint128Hash, std::equal_to<uint128>,
+    ArenaAllocator<uint128>> pending_maker_order_ids_;
   bool market_price_changed_;
+
+  /* timeout by external exchange id, and the deadlines of the pending
+    requests, by request id */
+  std::unordered_map<uint32_t, uint64_t> timeouts_;
+  Timers timers_;
+  std::vector<uint64_t, ArenaAllocator<uint64_t>> timed_out_;
   bool should_route_;
+  bool parallel_routing_;
 
   /* translate MM user id on this exchange <-> external exchange id to route to */
   std::unordered_map<uint32_t, uint32_t> MMU2X_;
@@ -148,67 +305,218 @@ private:
 protected:
   virtual void on_routing_request(const RoutingRequest& request) = 0;
 
+  /* pending requests and their sweeps. registered market makers are
+    configuration, the book registers them again */
+  template <class Writer>
+  void save_state(Writer& out) const {
+    out.put(last_request_id_);
+
+    /* before the requests, which share their taker */
+    out.put((uint64_t) sweeps_.size());
+    sweeps_.for_each([&out](SweepHandle, const PendingSweep& sweep) {
+      out.put(sweep.sweep_id);
+      out.put(sweep.outstanding);
+      out.put(sweep.unfilled_qty);
+      out.put(sweep.reason);
+      out.put_tracker(sweep.taker);
+    });
+
+    out.put((uint64_t) requests_.size());
+    requests_.for_each([&out](RequestHandle, const Pending& pending) {
+      const RoutingRequest& request = pending.request;
+      out.put(request.request_id);
+      out.put(request.exchange_id);
+      out.put(request.symbol_id);
+      out.put(request.qty);
+      out.put(request.price);
+      out.put(request.is_bid);
+      out.put(request.cancel_reason);
+      out.put(request.deadline);
+      out.put(request.sweep_id);
+
+      out.put((uint64_t) request.fills.size());
+      for(auto fill = request.fills.begin(); fill != request.fills.end(); ++fill) {
+        out.put_order(fill->maker_order);
+        out.put(fill->qty);
+        out.put(fill->price);
+        out.put(fill->taker_avg_price);
+        out.put(fill->maker_avg_price);
+        out.put(fill->taker_filled_qty);
+        out.put(fill->maker_filled_qty);
+        out.put(fill->flags);
+      }
+    });
+
+    out.put((uint64_t) pending_maker_order_ids_.size());
+    for(auto it = pending_maker_order_ids_.begin(); it != pending_maker_order_ids_.end(); ++it)
+      out.put(*it);
+  }
+
+  template <class Reader>
+  void load_state(Reader& in) {
+    last_request_id_ = in.template get<uint64_t>();
+    timers_.clear(this->now());
+
+    uint64_t count = in.template get<uint64_t>();
+    std::unordered_map<uint64_t, SweepHandle> sweeps;
+
+    for(uint64_t i = 0; i < count; ++i) {
+      uint64_t sweep_id = in.template get<uint64_t>();
+      uint32_t outstanding = in.template get<uint32_t>();
+      Qty unfilled_qty = in.template get<Qty>();
+      CancelReasons reason = in.template get<CancelReasons>();
+
+      SweepHandle handle = sweeps_.make(this->load_tracker(in));
+      PendingSweep& sweep = sweeps_[handle];
+      sweep.sweep_id = sweep_id;
+      sweep.outstanding = outstanding;
+      sweep.unfilled_qty = unfilled_qty;
+      sweep.reason = reason;
+      sweeps.emplace(sweep_id, handle);
+    }
+
+    count = in.template get<uint64_t>();
+    pending_requests_.reserve(count);
+
+    for(uint64_t i = 0; i < count; ++i) {
+      RoutingRequest request;
+      request.request_id = in.template get<uint64_t>();
+      request.exchange_id = in.template get<uint32_t>();
+      request.symbol_id = in.template get<uint32_t>();
+      request.qty = in.template get<Qty>();
+      request.price = in.template get<Price>();
+      request.is_bid = in.template get<bool>();
+      request.cancel_reason = in.template get<CancelReasons>();
+      request.deadline = in.template get<uint64_t>();
+      request.sweep_id = in.template get<uint64_t>();
+
+      uint64_t fills = in.template get<uint64_t>();
+      for(uint64_t f = 0; f < fills; ++f) {
+        Fill fill;
+        fill.maker_order = in.get_order();
+        fill.qty = in.template get<Qty>();
+        fill.price = in.template get<Price>();
+        fill.taker_avg_price = in.template get<double>();
+        fill.maker_avg_price = in.template get<double>();
+        fill.taker_filled_qty = in.template get<Qty>();
+        fill.maker_filled_qty = in.template get<Qty>();
+        fill.flags = in.template get<uint8_t>();
+        request.fills.push_back(fill);
+      }
+
+      SweepHandle sweep = sweeps.at(request.sweep_id);
+      submit(std::move(request), sweep);
+    }
+
+    count = in.template get<uint64_t>();
+    for(uint64_t i = 0; i < count; ++i)
+      pending_maker_order_ids_.insert(pending_maker_order_ids_.end(), in.template get<uint128>());
+  }
+
   void reset_request() {
-    next_routing_request_.callbacks.clear();
-    next_routing_request_.qty = 0;
-    next_routing_request_.cancel_reason = dont_cancel;
+    next_routing_requests_.clear();
     market_price_changed_ = false;
     should_route_ = false;
   }
 
+  /* wins over the reason of any other plugin, whatever their order: the
+    taker is routed, and rests or not once it is added again */
+  void should_rest(const Tracker&, CancelReasons& reason) {
+    if(should_route_)
+      reason = temporary_cancel;
+  }
+
   void after_add_tracker(Tracker& taker) {
     if(!should_route_) return;
 
-    /* cancel taker order.
-      XXX: `taker` will become dangling, do not use in the rest of
-      this function. use next_routing_request_.taker instead  */
-    this->do_cancel(taker.ptr(), CancelReasons::temporary_cancel);
+    /* the taker is not in the book, see should_rest. its sweep keeps a
+      copy, the hooks of the other plugins still get this one */
+    SweepHandle handle = sweeps_.make(taker);
+    PendingSweep& sweep = sweeps_[handle];
 
-    /* remove fill callbacks related to MM matching */
-    std::vector<Callback<OrderPtr>>& callbacks = this->callbacks();
+    /* keep the fill callbacks related to MM matching off the publisher,
+      after_trade kept what they are issued from once routed */
+    CallbackBuffer<TypedCallback>& callbacks = this->callbacks();
 
     assert(callbacks.size() > 0);
     size_t start = callbacks.size() - 1;
 
     /* find the latest accept cb */
     while(start > 0)
-      if(callbacks[start--].type == Callback<OrderPtr>::cb_order_accept)
+      if(callbacks[start--].type == TypedCallback::cb_order_accept)
         break;
 
     for(auto it = callbacks.begin() + start; it != callbacks.end(); ++it) {
-      Callback<OrderPtr>& cb = *it;
+      TypedCallback& cb = *it;
 
       /* ignore if callback type is irrelevant */
-      if(cb.type != Callback<OrderPtr>::cb_trade &&
-        cb.type != Callback<OrderPtr>::cb_order_cancel) continue;
+      if(cb.type != TypedCallback::cb_trade &&
+        cb.type != TypedCallback::cb_order_cancel) continue;
 
       /* ignore if order id is irrelevant */
-      if(cb.order->order_id() !=
-          next_routing_request_.taker->ptr()->order_id()) continue;
+      if(cb.order->order_id() != sweep.taker.ptr()->order_id()) continue;
 
       /* ignore irrelevant trade with non-MM maker*/
-      if(cb.type == Callback<OrderPtr>::cb_trade &&
+      if(cb.type == TypedCallback::cb_trade &&
         MMU2X_.find(cb.maker_order->user_id()) == MMU2X_.end()) continue;
 
-      if(cb.type == Callback<OrderPtr>::cb_trade) {
-        cb.scope = Callback<OrderPtr>::CbScope::internal_only;
-        next_routing_request_.callbacks.push_back(cb);
+      if(cb.type == TypedCallback::cb_trade) {
+        cb.scope = TypedCallback::CbScope::internal_only;
       }
-      
+
       /* save the fact that it was cancelled afterwards, if it was */
-      else if(cb.type == Callback<OrderPtr>::cb_order_cancel) {
-        cb.scope = Callback<OrderPtr>::CbScope::suppress_callback;
+      else if(cb.type == TypedCallback::cb_order_cancel) {
+        cb.scope = TypedCallback::CbScope::suppress_callback;
       }
     }
 
-    /* submit the request */
+    /* submit the requests, all of them before any is sent: a response
+      may come back from on_routing_request() */
+    uint64_t sweep_id = last_request_id_ + 1;
+    sweep.sweep_id = sweep_id;
+    sweep.outstanding = (uint32_t) next_routing_requests_.size();
+
+    for(auto it = next_routing_requests_.begin(); it != next_routing_requests_.end(); ++it) {
+      RoutingRequest& request = it->request;
+      request.request_id = ++last_request_id_;
+      request.sweep_id = sweep_id;
+      request.deadline = deadline_of(request.exchange_id);
+      submit(std::move(request), handle);
+    }
 
-    next_routing_request_.request_id = ts();
-    auto emplaced = pending_requests_.emplace(
-      next_routing_request_.request_id, next_routing_request_);
-    
+    uint64_t last_id = last_request_id_;
     reset_request();
-    on_routing_request(emplaced.first->second);
+
+    /* a synchronous response settles its request, and may route the taker
+      again under later ids */
+    for(uint64_t id = sweep_id; id <= last_id; ++id) {
+      auto pending = pending_requests_.find(id);
+      if(pending != pending_requests_.end())
+        on_routing_request(requests_[pending->second].request);
+    }
+  }
+
+  /* fails the requests whose deadline has passed. not journaled, the
+    time is */
+  void on_time(uint64_t now) {
+    /* the timers are gone once fired, before the requests are settled */
+    timers_.advance(now, [this](uint64_t& request_id, uint64_t) {
+      requests_[pending_requests_.at(request_id)].timer = Timers::npos;
+      timed_out_.push_back(request_id);
+    });
+
+    for(auto it = timed_out_.begin(); it != timed_out_.end(); ++it) {
+      /* answered since, while settling an earlier one */
+      auto pending = pending_requests_.find(*it);
+      if(pending == pending_requests_.end()) continue;
+
+      settle(take(pending), Qty(), routing_timeout);
+    }
+
+    timed_out_.clear();
+
+    if(!timers_.empty())
+      this->wake_at(timers_.next_tick());
   }
 
   void should_trade(
@@ -230,20 +538,29 @@ protected:
       maker_reason = mm_routed;
     }
 
-    /* we've hit a different exchange -- cancel taker.
-     * will be added again once it has been routed to first exchange */
-    if(should_route_ && 
-      next_routing_request_.exchange_id != exchange_id_it->second) {
+    if(!should_route_) return;
+
+    /* we've hit a different exchange -- cancel taker, unless routing in
+     * parallel. will be added again once it has been routed to first exchange */
+    if(!parallel_routing_ &&
+      next_routing_requests_.front().request.exchange_id != exchange_id_it->second) {
       taker_reason = temporary_cancel;
     }
+
+    /* the request to this exchange is full -- cancel taker.
+     * will be added again once it has been routed. this is what keeps
+     * the fills of a request within MaxFills */
+    const Staged* staged = find_request(exchange_id_it->second);
+    if(staged && staged->fills == RoutingRequest::MAX_FILLS)
+      taker_reason = temporary_cancel;
   }
 
   void after_trade(
     Tracker& taker,
     Tracker& maker,
     bool maker_is_bid,
-    double qty,
-    double price
+    Qty qty,
+    Price price
   ) {
     auto exchange_id_it = MMU2X_.find(maker.user_id());
     /* skipping non-MM orders */
@@ -255,90 +572,203 @@ protected:
     market_price_changed_ = false;
     pending_maker_order_ids_.insert(maker.ptr()->order_id());
 
-    /* this calls copy ctor */
-    next_routing_request_.taker = std::make_shared<Tracker>(taker);
-    next_routing_request_.maker = std::make_shared<Tracker>(maker);
+    Staged& staged = next_request(exchange_id_it->second);
+    ++staged.fills;
+    staged.request.qty += qty;
+
+    /* as OB::trade() issued its callback */
+    uint8_t flags = TypedCallback::neither_filled;
+    if(taker.filled()) flags |= TypedCallback::taker_filled;
+    if(maker.filled()) flags |= TypedCallback::maker_filled;
 
-    next_routing_request_.exchange_id = exchange_id_it->second;
-    next_routing_request_.symbol_id = this->symbol_id();
-    next_routing_request_.qty += qty;
+    Fill fill = { maker.ptr(), qty, price, taker.avg_price(), maker.avg_price(),
+      taker.filled_qty(), maker.filled_qty(), flags };
+    staged.request.fills.push_back(fill);
 
     /* after each trade, the price gets worse. so we're expected 
       to send the worst price on the request. */
-    next_routing_request_.price = price;
-    next_routing_request_.is_bid = !maker_is_bid;
+    staged.request.price = price;
+    staged.request.is_bid = !maker_is_bid;
     should_route_ = true;
   }
 
+  /* responses to requests no longer pending, e.g. timed out, are
+    ignored */
   void on_routing_success(uint64_t request_id) {
-    RoutingRequest& request = pending_requests_.at(request_id);
+    this->journal_routing_response(request_id, true);
+
+    auto pending = pending_requests_.find(request_id);
+    if(pending == pending_requests_.end()) return;
+
+    /* out of the pending requests first, add_tracker() may make more */
+    RequestHandle handle = take(pending);
+    settle(handle, requests_[handle].request.qty, routing_failure);
+  }
+
+  void on_routing_failure(uint64_t request_id) {
+    this->journal_routing_response(request_id, false);
+
+    auto pending = pending_requests_.find(request_id);
+    if(pending == pending_requests_.end()) return;
+
+    settle(take(pending), Qty(), routing_failure);
+  }
+
+  /* the venue filled `filled_qty` of the request, less than its qty. the
+    fills are replayed up to it, the rest of the taker is cancelled with
+    routing_failure once its sweep is settled */
+  void on_routing_partial_success(uint64_t request_id, Qty filled_qty) {
+    this->journal_routing_partial(request_id, filled_qty);
+
+    auto pending = pending_requests_.find(request_id);
+    if(pending == pending_requests_.end()) return;
+
+    settle(take(pending), filled_qty, routing_failure);
+  }
+
+private:
+  const Staged* find_request(uint32_t exchange_id) const {
+    for(auto it = next_routing_requests_.begin(); it != next_routing_requests_.end(); ++it)
+      if(it->request.exchange_id == exchange_id) return &*it;
+    return nullptr;
+  }
+
+  /* the request of the sweep being matched to `exchange_id` */
+  Staged& next_request(uint32_t exchange_id) {
+    const Staged* found = find_request(exchange_id);
+    if(found) return const_cast<Staged&>(*found);
+
+    next_routing_requests_.emplace_back();
+    Staged& staged = next_routing_requests_.back();
+    staged.fills = 0;
+
+    RoutingRequest& request = staged.request;
+    request.request_id = 0;
+    request.exchange_id = exchange_id;
+    request.symbol_id = this->symbol_id();
+    request.qty = 0;
+    request.cancel_reason = dont_cancel;
+    request.deadline = 0;
+    request.sweep_id = 0;
+    return staged;
+  }
+
+  uint64_t deadline_of(uint32_t exchange_id) const {
+    auto it = timeouts_.find(exchange_id);
+    if(it == timeouts_.end() || it->second == 0) return 0;
+    return this->now() + it->second;
+  }
+
+  /* pends `request`, with a timer if it has a deadline */
+  void submit(RoutingRequest&& request, SweepHandle sweep) {
+    RequestHandle handle = requests_.make(std::move(request), sweep);
+    Pending& pending = requests_[handle];
+    pending_requests_.emplace(pending.request.request_id, handle);
+
+    if(pending.request.deadline != 0) {
+      pending.timer = timers_.insert(pending.request.deadline, pending.request.request_id);
+      this->wake_at(pending.request.deadline);
+    }
+  }
+
+  /* the request is no longer pending. its slot is released once settled */
+  RequestHandle take(typename RequestIndex::iterator pending) {
+    RequestHandle handle = pending->second;
+    pending_requests_.erase(pending);
+
+    Handle timer = requests_[handle].timer;
+    if(timer != Timers::npos)
+      timers_.erase(timer);
+
+    return handle;
+  }
+
+  /* replays the fills of the request up to `filled_qty`, what the venue
+    filled, all of them if it filled the request. the rest counts against
+    the sweep with `reason`. once the last request of the sweep is in, the
+    taker is added again if every venue filled it in full, else what they
+    did not fill is cancelled */
+  void settle(RequestHandle handle, Qty filled_qty, CancelReasons reason) {
+    /* slots do not move, add_tracker() below may make more */
+    Pending& pending = requests_[handle];
+    RoutingRequest& request = pending.request;
 
-    const TrackerPtr& maker = request.maker, taker = request.taker;
+    PendingSweep& sweep = sweeps_[pending.sweep];
+
+    bool filled = !(filled_qty < request.qty);
+    Qty unfilled_qty = filled ? Qty() : request.qty - filled_qty;
+
+    /* the trade callbacks of the fills */
+    for(auto it = request.fills.begin(); it != request.fills.end(); ++it) {
+      Qty qty = it->qty;
+
+      /* dont replay the fills with this MM beyond what the venue filled */
+      if(!filled) {
+        if(!(filled_qty > Qty())) continue;
+
+        if(qty > filled_qty) qty = filled_qty;
+        filled_qty -= qty;
+      }
+
+      TypedCallback cb = TypedCallback::fill(sweep.taker.ptr(), it->maker_order, qty,
+        it->price, it->taker_avg_price, it->maker_avg_price,
+        it->taker_filled_qty, it->maker_filled_qty, it->flags);
+      cb.scope = TypedCallback::CbScope::external_only;
+      this->emit_callback(std::move(cb));
+    }
 
-    /* replay callbacks */
-    for(auto it = request.callbacks.begin(); it != request.callbacks.end(); ++it) {
-      it->scope = Callback<OrderPtr>::CbScope::external_only;
-      this->emit_callback(*it);
+    if(!filled) {
+      sweep.unfilled_qty += unfilled_qty;
+      if(sweep.reason == dont_cancel)
+        sweep.reason = reason;
     }
 
-    /* if there's qty remaining */
-    if(request.cancel_reason == dont_cancel) {
-      if(!taker->filled()) {
+    if(--sweep.outstanding == 0) {
+      if(sweep.reason != dont_cancel) cancel(sweep);
+      else if(request.cancel_reason == dont_cancel && !sweep.taker.filled()) {
         /* add the tracker again */
 
         /* before adding the tracker again, we must first process the 
           callbacks related to this routing request, so as not to save 
           them on any subsequent request resulting from add_tracker */
         this->process_callbacks();
-    
-        this->add_tracker(*taker);
+
+        this->add_tracker(sweep.taker);
         size_t accept_cb_index = this->callbacks().size();
-        this->emit_callback(TypedCallback::accept(taker->ptr()));
+        this->emit_callback(TypedCallback::accept(sweep.taker.ptr()));
 
         /* only need this to have the order in directory and order list*/
         this->callbacks()[accept_cb_index].scope =
-          Callback<OrderPtr>::CbScope::suppress_callback;
+          TypedCallback::CbScope::suppress_callback;
         this->process_callbacks();
       }
+
+      sweeps_.release(pending.sweep);
     }
 
-    pending_maker_order_ids_.erase(maker->ptr()->order_id());
+    for(auto it = request.fills.begin(); it != request.fills.end(); ++it)
+      pending_maker_order_ids_.erase(it->maker_order->order_id());
+
+    requests_.release(handle);
     this->process_callbacks();
   }
 
-  void on_routing_failure(uint64_t request_id) {
-    RoutingRequest& request = pending_requests_.at(request_id);
-
-    const TrackerPtr& maker = request.maker, taker = request.taker;
-
-    /* replay callbacks */
-    for(auto it = request.callbacks.begin(); it != request.callbacks.end(); ++it) {
-      /* dont replay the fill with this MM */
-      if(it->type == Callback<OrderPtr>::cb_trade &&
-        it->maker_order->user_id() == X2MMU_.at(request.exchange_id)) continue;
-
-      it->scope = Callback<OrderPtr>::CbScope::external_only;
-      this->emit_callback(*it);
-    }
-
+  /* cancels what the venues of the sweep did not fill */
+  void cancel(PendingSweep& sweep) {
     size_t cancel_cb_index = this->callbacks().size();
-    this->emit_cancel_callback(*taker, routing_failure);
+    this->emit_cancel_callback(sweep.taker, sweep.reason);
 
     /* do not change depth again */
     this->callbacks()[cancel_cb_index].scope =
-      Callback<OrderPtr>::CbScope::external_only;
+      TypedCallback::CbScope::external_only;
     
-    this->callbacks()[cancel_cb_index].qty -= request.qty;
+    this->callbacks()[cancel_cb_index].qty -= sweep.unfilled_qty;
 
     /* used to free the hold */
-    this->callbacks()[cancel_cb_index].generic_1 = request.qty + taker->qty_on_book();
-
-    pending_maker_order_ids_.erase(maker->ptr()->order_id());
-
-    this->process_callbacks();
+    this->callbacks()[cancel_cb_index].generic_1 = sweep.unfilled_qty + sweep.taker.qty_on_book();
   }
 
 };
 
 }
-}
\ No newline at end of file
+}
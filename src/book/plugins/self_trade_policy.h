@@ -52,15 +52,29 @@ private:
   SelfTradePolicy stp_;
 };
 
+template <class OrderPtr>
+struct SelfTradePolicyState {
+  explicit SelfTradePolicyState(const OrderPtr& order) : stp_(order->stp()) {}
+
+  SelfTradePolicy stp_;
+
+  template <class Tracker>
+  struct Accessors {
+    SelfTradePolicy stp() const {
+      return static_cast<const Tracker*>(this)->template state<SelfTradePolicyState>().stp_;
+    }
+  };
+};
+
 
 struct SelfTradePolicyOrder {
   virtual uint32_t user_id() const = 0;
   virtual SelfTradePolicy stp() const = 0;
 };
 
-template <class Tracker>
+template <class Tracker, class Book = UnboundBook>
 class SelfTradePolicyPlugin :
-public Plugin<Tracker>
+public Plugin<Tracker, Book, SelfTradePolicyPlugin<Tracker, Book>>
 {
 protected:
   typedef typename Tracker::OrderPtr OrderPtr;
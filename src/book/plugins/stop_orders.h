@@ -3,6 +3,7 @@
 #include <book/plugin.h>
 #include <book/book_price.h>
 #include <functional>
+#include <type_traits>
 
 namespace book {
 namespace plugins {
@@ -12,43 +13,100 @@ struct StopOrder {
   virtual double stop_price() const = 0;
 };
 
-template <class Tracker>
-class StopOrdersPlugin : public Plugin<Tracker> {
+template <class Tracker, class Book = UnboundBook>
+class StopOrdersPlugin : public Plugin<Tracker, Book, StopOrdersPlugin<Tracker, Book>> {
 public:
-	using OrderPtr = typename Plugin<Tracker>::OrderPtr;
-	using TrackerVec = typename Plugin<Tracker>::TrackerVec;
-	using TypedCallback = typename Plugin<Tracker>::TypedCallback;
+	using OrderPtr = typename Plugin<Tracker, Book, StopOrdersPlugin<Tracker, Book>>::OrderPtr;
+	using TrackerVec = typename Plugin<Tracker, Book, StopOrdersPlugin<Tracker, Book>>::TrackerVec;
+	using TypedCallback = typename Plugin<Tracker, Book, StopOrdersPlugin<Tracker, Book>>::TypedCallback;
 
 	/* Sorted the opposite of limit prices */
-	using StopTrackerMap = std::multimap<BookPrice, Tracker, std::greater<BookPrice>>;
+	using StopTrackerMap = std::multimap<BookPrice, Tracker, std::greater<BookPrice>,
+		ArenaAllocator<std::pair<const BookPrice, Tracker>>>;
+
+	StopOrdersPlugin() :
+		stop_bids_(&this->arena()),
+		stop_asks_(&this->arena()),
+		pending_orders_(&this->arena()) {}
 
 protected:
-	bool should_add_tracker(const Tracker& taker) override {
+	/* stop prices are on the tick grid of the book, as limit prices */
+	void should_add(const Tracker& taker, InsertRejectReasons& reason) {
+		double stop_price = taker.ptr()->stop_price();
+		if(stop_price != 0 && !on_ticks(stop_price, Scaled()))
+			reason = off_grid;
+	}
+
+	bool should_add_tracker(const Tracker& taker) {
 		double stop_price = taker.ptr()->stop_price();
 		return stop_price == 0 || !add_stop_order(taker, stop_price);
 	}
 
-	void on_market_price_change(double prev_price, double new_price) override {
+	void on_market_price_change(double prev_price, double new_price) {
 		if(prev_price == new_price) return;
 		auto& trackers = new_price > prev_price ? stop_bids_ : stop_asks_;
 		BookPrice until(new_price > prev_price, new_price);
 		check_stop_orders(trackers, until);
 	}
 
-  void after_add_tracker(const Tracker& taker) override {
+  void after_add_tracker(const Tracker& taker) {
   	while(!pending_orders_.empty())
       submit_pending_orders();
   }
 
+	/* pending orders only live during a call of the book */
+	template <class Writer>
+	void save_state(Writer& out) const {
+		assert(pending_orders_.empty());
+		save_stops(out, stop_bids_);
+		save_stops(out, stop_asks_);
+	}
+
+	template <class Reader>
+	void load_state(Reader& in) {
+		load_stops(in, stop_bids_);
+		load_stops(in, stop_asks_);
+	}
+
 
 private:
+	typedef std::integral_constant<bool, Tracker::Units::scaled> Scaled;
+
+	/* a stop price of the order in the units of market_price(), ticks for
+	  a fixed-point book */
+	double to_price(double price, std::false_type) const { return price; }
+	double to_price(double price, std::true_type) const {
+		return (double) this->book().scale().to_ticks(price);
+	}
+
+	bool on_ticks(double, std::false_type) const { return true; }
+	bool on_ticks(double price, std::true_type) const { return this->book().scale().on_ticks(price); }
+
 	StopTrackerMap stop_bids_;
 	StopTrackerMap stop_asks_;
 	TrackerVec pending_orders_;
 
+	template <class Writer>
+	static void save_stops(Writer& out, const StopTrackerMap& stops) {
+		out.put((uint64_t) stops.size());
+		for(auto it = stops.begin(); it != stops.end(); ++it)
+			out.put_tracker(it->second);
+	}
+
+	/* saved in trigger order, each goes after the previous one */
+	template <class Reader>
+	void load_stops(Reader& in, StopTrackerMap& stops) {
+		uint64_t count = in.template get<uint64_t>();
+		for(uint64_t i = 0; i < count; ++i) {
+			Tracker tracker = this->load_tracker(in);
+			BookPrice key(tracker.is_bid(), to_price(tracker.ptr()->stop_price(), Scaled()));
+			stops.emplace_hint(stops.end(), key, std::move(tracker));
+		}
+	}
+
 	bool add_stop_order(const Tracker& tracker, double stop_price) {
 	  bool is_bid = tracker.is_bid();
-	  BookPrice key(is_bid, stop_price);
+	  BookPrice key(is_bid, to_price(stop_price, Scaled()));
 
 	  /* triggered */
 	  if(key >= this->market_price()) return false;
@@ -76,7 +134,7 @@ private:
 	}
 
   void submit_pending_orders() {
-	  TrackerVec pending;
+	  TrackerVec pending(pending_orders_.get_allocator());
 	  pending.swap(pending_orders_);
 	  for(auto pos = pending.begin(); pos != pending.end(); ++pos) {
 	    Tracker& tracker = *pos;
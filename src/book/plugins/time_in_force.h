@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <type_traits>
+
+#include <book/plugin.h>
+#include <book/types.h>
+
+namespace book {
+namespace plugins {
+
+enum TimeInForce : uint8_t {
+  tif_gtc = 0,    /* what is left rests */
+  tif_ioc = 1,    /* what is left is cancelled */
+  tif_fok = 2     /* fills entirely or not at all */
+};
+
+template <class OrderPtr>
+struct TimeInForceTracker {
+  TimeInForceTracker(const OrderPtr& order) :
+    tif_(order->tif()), min_fill_qty_(order->min_fill_qty()) {}
+
+  TimeInForce tif() const { return tif_; }
+  double min_fill_qty() const { return min_fill_qty_; }
+
+private:
+  TimeInForce tif_;
+  double min_fill_qty_;
+};
+
+template <class OrderPtr>
+struct TimeInForceState {
+  explicit TimeInForceState(const OrderPtr& order) :
+    tif_(order->tif()), min_fill_qty_(order->min_fill_qty()) {}
+
+  TimeInForce tif_;
+  double min_fill_qty_;
+
+  template <class Tracker>
+  struct Accessors {
+    TimeInForce tif() const {
+      return static_cast<const Tracker*>(this)->template state<TimeInForceState>().tif_;
+    }
+
+    double min_fill_qty() const {
+      return static_cast<const Tracker*>(this)->template state<TimeInForceState>().min_fill_qty_;
+    }
+  };
+};
+
+struct TimeInForceOrder {
+  virtual TimeInForce tif() const = 0;
+
+  /* qty that must fill on arrival for the order to trade at all, in
+    the units of the order. 0 for none */
+  virtual double min_fill_qty() const = 0;
+};
+
+/**
+ * \brief immediate-or-cancel, fill-or-kill and minimum quantity orders.
+ *
+ *  FOK and minimum quantity orders are checked before they match, on the
+ *  level aggregates of the book (see OB::simulate_sweep()): an order that
+ *  cannot fill as asked is rejected without matching anything, with
+ *  fill_or_kill_unfilled or min_qty_unfilled. the check stops at the
+ *  first level that does not cross, or as soon as enough is found, and
+ *  an order larger than the whole side is turned down in O(1).
+ *
+ *  after matching, what is left of IOC and FOK orders is cancelled with
+ *  immediate_or_cancel instead of resting. the check does not see other
+ *  plugins, so if one of them stops a FOK short (e.g. self-trade
+ *  prevention) the FOK fills in part, like an IOC.
+ */
+
+template <class Tracker, class Book = UnboundBook>
+class TimeInForcePlugin :
+public Plugin<Tracker, Book, TimeInForcePlugin<Tracker, Book>>
+{
+protected:
+  typedef typename Tracker::Qty Qty;
+
+  void should_add(const Tracker& taker, InsertRejectReasons& reject_reason) {
+    TimeInForce tif = taker.tif();
+    double min_fill_qty = taker.min_fill_qty();
+
+    if(tif != tif_fok && min_fill_qty == 0) return;
+
+    const Book& book = this->book();
+    bool is_bid = taker.is_bid();
+
+    if(tif == tif_fok) {
+      Qty qty = taker.qty();
+
+      if(taker.funds() == 0 && book.side_qty(!is_bid) < qty)
+        reject_reason = fill_or_kill_unfilled;
+
+      else if(!book.simulate_sweep(is_bid, qty, taker.funds(), taker.price()).filled)
+        reject_reason = fill_or_kill_unfilled;
+    }
+
+    else {
+      Qty min_qty = to_qty(min_fill_qty, std::integral_constant<bool, Tracker::Units::scaled>());
+
+      if(taker.qty() != 0 && min_qty > taker.qty())
+        min_qty = taker.qty();
+
+      if(book.side_qty(!is_bid) < min_qty ||
+        book.simulate_sweep(is_bid, min_qty, taker.funds(), taker.price()).qty < min_qty)
+        reject_reason = min_qty_unfilled;
+    }
+  }
+
+  /* leaves the reason of another plugin, e.g. the temporary cancel of a
+    taker being routed, which comes back here once routed */
+  void should_rest(const Tracker& taker, CancelReasons& reason) {
+    if(reason == dont_cancel && taker.tif() != tif_gtc)
+      reason = immediate_or_cancel;
+  }
+
+private:
+  Qty to_qty(double qty, std::false_type) const { return qty; }
+  Qty to_qty(double qty, std::true_type) const { return this->book().scale().to_min_lots(qty); }
+};
+
+}
+}
@@ -23,6 +23,7 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
 
 namespace book {
 namespace plugins {
@@ -31,11 +32,11 @@ template <class OrderPtr>
 struct UserIDTracker {
   UserIDTracker() : user_id_(0) {}
 
-  virtual void set_user_id(uint64_t user_id) {
+  void set_user_id(uint64_t user_id) {
     user_id_ = user_id;
   }
 
-  virtual uint64_t user_id() const {
+  uint64_t user_id() const {
     return user_id_;
   };
 
@@ -43,5 +44,19 @@ struct UserIDTracker {
     uint64_t user_id_;
 };
 
+template <class OrderPtr>
+struct UserIDState {
+  explicit UserIDState(const OrderPtr& order) : user_id_(order->user_id()) {}
+
+  uint64_t user_id_;
+
+  template <class Tracker>
+  struct Accessors {
+    uint64_t user_id() const {
+      return static_cast<const Tracker*>(this)->template state<UserIDState>().user_id_;
+    }
+  };
+};
+
 }
 }
\ No newline at end of file
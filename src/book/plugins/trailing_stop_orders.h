@@ -7,6 +7,7 @@
 #include <memory>
 #include <algorithm>
 #include <functional>
+#include <type_traits>
 
 namespace book {
 namespace plugins {
@@ -35,16 +36,29 @@ struct TrailingStopOrdersTracker {
 };
 
 
-template <class Tracker>
-class TrailingStopOrdersPlugin : public Plugin<Tracker> {
+template <class Tracker, class Book = UnboundBook>
+class TrailingStopOrdersPlugin : public Plugin<Tracker, Book, TrailingStopOrdersPlugin<Tracker, Book>> {
 public:
-  using OrderPtr = typename Plugin<Tracker>::OrderPtr;
-  using TrackerVec = typename Plugin<Tracker>::TrackerVec;
-  using TypedCallback = typename Plugin<Tracker>::TypedCallback;
-  using TrailingMap = std::multimap<double, Tracker>;
+  using OrderPtr = typename Plugin<Tracker, Book, TrailingStopOrdersPlugin<Tracker, Book>>::OrderPtr;
+  using TrackerVec = typename Plugin<Tracker, Book, TrailingStopOrdersPlugin<Tracker, Book>>::TrackerVec;
+  using TypedCallback = typename Plugin<Tracker, Book, TrailingStopOrdersPlugin<Tracker, Book>>::TypedCallback;
+  using TrailingMap = std::multimap<double, Tracker, std::less<double>,
+    ArenaAllocator<std::pair<const double, Tracker>>>;
+
+  TrailingStopOrdersPlugin() :
+    trailStopBids_(&this->arena()),
+    trailStopAsks_(&this->arena()),
+    pending_orders_(&this->arena()) {}
 
 protected:
-  bool should_add_tracker(const Tracker& taker) override {
+  /* trailing amounts are on the tick grid of the book, as prices */
+  void should_add(const Tracker& taker, InsertRejectReasons& reason) {
+    double trailing_amount = taker.ptr()->trailing_amount();
+    if(trailing_amount != 0 && !on_ticks(trailing_amount, Scaled()))
+      reason = off_grid;
+  }
+
+  bool should_add_tracker(const Tracker& taker) {
     double trailing_amount = taker.ptr()->trailing_amount();
     if(trailing_amount != 0) {
       add_trailing_stop(taker);
@@ -54,14 +68,14 @@ protected:
     return true;
   }
 
-  void on_market_price_change(double prev_price, double new_price) override {
+  void on_market_price_change(double prev_price, double new_price) {
     const double dP = std::abs(new_price - prev_price);
 
     if(new_price > prev_price) {
       if(!trailStopAsks_.empty()) {
         const double smallestAskTrail =
           trailStopAsks_.begin()->first
-            - trailStopAsks_.begin()->second.ptr()->trailing_amount();
+            - trailing_amount(trailStopAsks_.begin()->second.ptr());
         if(ask_cursor_ > smallestAskTrail + dP)
           ask_cursor_ -= dP;
         else
@@ -78,7 +92,7 @@ protected:
       if(!trailStopBids_.empty()) {
         const double smallestBidTrail = 
           trailStopBids_.begin()->first
-            - trailStopBids_.begin()->second.ptr()->trailing_amount();
+            - trailing_amount(trailStopBids_.begin()->second.ptr());
 
 
         if(bid_cursor_ > smallestBidTrail + dP)
@@ -95,12 +109,29 @@ protected:
   }
 
 
-  void after_add_tracker(const Tracker& taker) override {
+  void after_add_tracker(const Tracker& taker) {
     while(!pending_orders_.empty())
       submit_pending_orders();
   }
 
-  void cancel(const OrderPtr& order, CancelReasons reason) override {
+  template <class Writer>
+  void save_state(Writer& out) const {
+    assert(pending_orders_.empty());
+    out.put(bid_cursor_);
+    out.put(ask_cursor_);
+    save_trailing_stops(out, trailStopBids_);
+    save_trailing_stops(out, trailStopAsks_);
+  }
+
+  template <class Reader>
+  void load_state(Reader& in) {
+    bid_cursor_ = in.template get<double>();
+    ask_cursor_ = in.template get<double>();
+    load_trailing_stops(in, trailStopBids_);
+    load_trailing_stops(in, trailStopAsks_);
+  }
+
+  void cancel(const OrderPtr& order, CancelReasons reason) {
     /* TODO
       find in the trailStopBids_ and trailStopAsks_ using order->trailing_amount() as a hint
       then remove the order from those containers. 
@@ -109,24 +140,60 @@ protected:
 
 
 private:
+  typedef std::integral_constant<bool, Tracker::Units::scaled> Scaled;
+
+  /* the trailing amount of the order in the units of market_price(),
+    ticks for a fixed-point book */
+  double trailing_amount(const OrderPtr& order) const {
+    return to_price(order->trailing_amount(), Scaled());
+  }
+
+  double to_price(double price, std::false_type) const { return price; }
+  double to_price(double price, std::true_type) const {
+    return (double) this->book().scale().to_ticks(price);
+  }
+
+  bool on_ticks(double, std::false_type) const { return true; }
+  bool on_ticks(double price, std::true_type) const { return this->book().scale().on_ticks(price); }
+
   double bid_cursor_ = 0;
   double ask_cursor_ = 0;
   TrailingMap trailStopBids_;
   TrailingMap trailStopAsks_;
   TrackerVec pending_orders_;
 
+  template <class Writer>
+  static void save_trailing_stops(Writer& out, const TrailingMap& stops) {
+    out.put((uint64_t) stops.size());
+    for(auto it = stops.begin(); it != stops.end(); ++it) {
+      out.put(it->first);
+      out.put_tracker(it->second);
+    }
+  }
+
+  template <class Reader>
+  void load_trailing_stops(Reader& in, TrailingMap& stops) {
+    uint64_t count = in.template get<uint64_t>();
+    for(uint64_t i = 0; i < count; ++i) {
+      double key = in.template get<double>();
+      Tracker tracker = this->load_tracker(in);
+      tracker.ptr()->trailing_stop_key(key);
+      stops.emplace_hint(stops.end(), key, std::move(tracker));
+    }
+  }
+
   void add_trailing_stop(const Tracker& taker) {
     const OrderPtr& order = taker.ptr();
     bool isBuy = taker.is_bid();
     typename TrailingMap::iterator pos;
 
     if(isBuy) {
-      double key = order->trailing_amount() + bid_cursor_;
+      double key = trailing_amount(order) + bid_cursor_;
       order->trailing_stop_key(key);
       pos = trailStopBids_.emplace(key, std::move(taker));
     }
     else {
-      double key = order->trailing_amount() + ask_cursor_;
+      double key = trailing_amount(order) + ask_cursor_;
       order->trailing_stop_key(key);
       pos = trailStopAsks_.emplace(key, std::move(taker));
     }
@@ -149,7 +216,7 @@ private:
 
 
   void submit_pending_orders() {
-    TrackerVec pending;
+    TrackerVec pending(pending_orders_.get_allocator());
     pending.swap(pending_orders_);
     for(auto pos = pending.begin(); pos != pending.end(); ++pos) {
       Tracker& tracker = *pos;
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <cassert>
+#include <stdint.h>
+#include <type_traits>
+
+#include <book/arena.h>
+
+namespace book {
+
+/**
+ * \brief objects of type T in slots recycled through a free list. once
+ *  the pool has as many slots as are ever live at once, making and
+ *  releasing objects no longer allocates.
+ *
+ *  slots never move: a reference stays valid until its slot is released,
+ *  however much the pool grows in between. T needs neither a default
+ *  constructor nor an assignment, objects are built in place.
+ */
+
+template <class T>
+class Pool {
+public:
+  typedef uint32_t Handle;
+  static const Handle npos = UINT32_MAX;
+
+  explicit Pool(BookArena* arena = nullptr) :
+    slots_(ArenaAllocator<Slot>(arena)), free_(npos), size_(0) {}
+
+  ~Pool() { clear(); }
+
+  Pool(const Pool&) = delete;
+  Pool& operator=(const Pool&) = delete;
+
+  /* live objects */
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /* slots, live or free */
+  size_t capacity() const { return slots_.size(); }
+
+  /* room for `count` live objects without growing */
+  void reserve(size_t count) {
+    while(slots_.size() < count) {
+      slots_.emplace_back();
+      slots_.back().next = free_;
+      free_ = (Handle) (slots_.size() - 1);
+    }
+  }
+
+  /* a T built from `args` in a free slot */
+  template <class... Args>
+  Handle make(Args&&... args) {
+    if(free_ == npos) reserve(slots_.size() + 1);
+
+    Handle handle = free_;
+    Slot& slot = slots_[handle];
+    new (slot.get()) T(std::forward<Args>(args)...);
+
+    free_ = slot.next;
+    slot.live = true;
+    ++size_;
+    return handle;
+  }
+
+  /* rebuilds the object of a live slot from `args`, in place */
+  template <class... Args>
+  void remake(Handle handle, Args&&... args) {
+    Slot& slot = slots_[handle];
+    assert(slot.live);
+
+    slot.get()->~T();
+    new (slot.get()) T(std::forward<Args>(args)...);
+  }
+
+  void release(Handle handle) {
+    Slot& slot = slots_[handle];
+    assert(slot.live);
+
+    slot.get()->~T();
+    slot.live = false;
+    slot.next = free_;
+    free_ = handle;
+    --size_;
+  }
+
+  T& operator[](Handle handle) { return *slots_[handle].get(); }
+  const T& operator[](Handle handle) const { return *slots_[handle].get(); }
+
+  /* fn(handle, object) for every live object, in order of slot */
+  template <class Fn>
+  void for_each(Fn fn) const {
+    for(size_t i = 0; i < slots_.size(); ++i)
+      if(slots_[i].live) fn((Handle) i, *slots_[i].get());
+  }
+
+  /* releases every object, keeps the slots */
+  void clear() {
+    for(size_t i = slots_.size(); i-- > 0;)
+      if(slots_[i].live) release((Handle) i);
+  }
+
+private:
+  struct Slot {
+    Slot() : next(npos), live(false) {}
+
+    T* get() { return reinterpret_cast<T*>(&storage); }
+    const T* get() const { return reinterpret_cast<const T*>(&storage); }
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    Handle next;
+    bool live;
+  };
+
+  /* a deque, so that growing never moves the slots */
+  std::deque<Slot, ArenaAllocator<Slot>> slots_;
+  Handle free_;
+  size_t size_;
+};
+
+
+/**
+ * \brief up to N objects of type T kept inline, in order, for small
+ *  collections of a known bound that are carried by value without
+ *  allocating. pushing to a full buffer is a bug, callers check full().
+ *  it throws rather than write past the end, in release builds too
+ */
+
+template <class T, size_t N>
+class FixedBuffer {
+public:
+  typedef T value_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  FixedBuffer() : size_(0) {}
+
+  void push_back(const T& value) {
+    if(size_ == N)
+      throw std::length_error("FixedBuffer is full");
+    items_[size_++] = value;
+  }
+
+  T& operator[](size_t i) { return items_[i]; }
+  const T& operator[](size_t i) const { return items_[i]; }
+
+  iterator begin() { return items_; }
+  iterator end() { return items_ + size_; }
+  const_iterator begin() const { return items_; }
+  const_iterator end() const { return items_ + size_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == N; }
+  static size_t capacity() { return N; }
+
+  /* resets the objects too, so that they let go of what they hold */
+  void clear() {
+    for(size_t i = 0; i < size_; ++i)
+      items_[i] = T();
+    size_ = 0;
+  }
+
+private:
+  T items_[N];
+  size_t size_;
+};
+
+}
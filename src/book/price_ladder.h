@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+#include <memory>
+
+#include "book_price.h"
+
+namespace book {
+
+/**
+ * \brief one side of the book stored as a ladder of price levels.
+ *  levels are kept in a sorted vector with the best level at the back,
+ *  and each level holds an intrusive FIFO of the trackers resting at
+ *  that price. levels are also linked to their worse neighbour, so
+ *  iterating the side never touches the vector.
+ *
+ *  the nodes of a level are carved from chunks owned by the level, so
+ *  that a sweep walks a few contiguous blocks per level instead of nodes
+ *  scattered by arrival time. slots freed by fills and cancels are reused
+ *  by the next orders of the same level.
+ *
+ *  the interface mirrors the subset of std::multimap<BookPrice, Tracker>
+ *  used by OB, so either can be used as the side of a book. chunks, levels
+ *  and the level vector are all allocated through Alloc.
+ */
+
+template <class Tracker,
+  class Alloc = std::allocator<std::pair<const BasicBookPrice<typename Tracker::Price>, Tracker>>>
+class PriceLadder {
+  struct Level;
+  struct Node;
+
+public:
+  typedef BasicBookPrice<typename Tracker::Price> key_type;
+  typedef Tracker mapped_type;
+  typedef std::pair<const key_type, Tracker> value_type;
+  typedef size_t size_type;
+  typedef Alloc allocator_type;
+
+  template <class Value>
+  class basic_iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    basic_iterator() : node_(nullptr) {}
+
+    /* iterator -> const_iterator */
+    template <class Other>
+    basic_iterator(const basic_iterator<Other>& other) : node_(other.node_) {}
+
+    reference operator*() const { return node_->value; }
+    pointer operator->() const { return &node_->value; }
+
+    basic_iterator& operator++() {
+      if(node_->next)
+        node_ = node_->next;
+      else
+        node_ = node_->level->worse ? node_->level->worse->head : nullptr;
+      return *this;
+    }
+
+    basic_iterator operator++(int) {
+      basic_iterator it = *this;
+      ++*this;
+      return it;
+    }
+
+    template <class Other>
+    bool operator==(const basic_iterator<Other>& rhs) const {
+      return node_ == rhs.node_;
+    }
+
+    template <class Other>
+    bool operator!=(const basic_iterator<Other>& rhs) const {
+      return node_ != rhs.node_;
+    }
+
+  private:
+    friend class PriceLadder;
+    template <class> friend class basic_iterator;
+
+    explicit basic_iterator(Node* node) : node_(node) {}
+
+    Node* node_;
+  };
+
+  typedef basic_iterator<value_type> iterator;
+  typedef basic_iterator<const value_type> const_iterator;
+
+  explicit PriceLadder(const Alloc& alloc = Alloc()) :
+    node_alloc_(alloc), chunk_alloc_(alloc), level_alloc_(alloc), levels_(LevelPtrAlloc(alloc)), size_(0) {}
+  ~PriceLadder() { clear(); }
+
+  PriceLadder(const PriceLadder&) = delete;
+  PriceLadder& operator=(const PriceLadder&) = delete;
+
+  iterator begin() { return iterator(best_head()); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const { return const_iterator(best_head()); }
+  const_iterator end() const { return const_iterator(); }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /* number of distinct price levels */
+  size_type level_count() const { return levels_.size(); }
+
+  /**
+   * \brief appends the tracker at the tail of the FIFO of its level,
+   *  creating the level if needed
+   */
+  template <class T>
+  iterator emplace(const key_type& key, T&& tracker) {
+    Level* level = find_or_insert_level(key);
+    Node* node = allocate_node(level);
+    NodeTraits::construct(node_alloc_, node, level, key, std::forward<T>(tracker));
+
+    node->prev = level->tail;
+    if(level->tail)
+      level->tail->next = node;
+    else
+      level->head = node;
+    level->tail = node;
+
+    ++size_;
+    return iterator(node);
+  }
+
+  /**
+   * \brief returns the first (oldest) tracker resting at `key`,
+   *  or end() if there is no such level
+   */
+  iterator find(const key_type& key) {
+    Level* level = find_level(key);
+    return iterator(level ? level->head : nullptr);
+  }
+
+  const_iterator find(const key_type& key) const {
+    Level* level = find_level(key);
+    return const_iterator(level ? level->head : nullptr);
+  }
+
+  /**
+   * \brief unlinks the tracker from its level and drops the level
+   *  when it becomes empty. returns the iterator following `pos`
+   */
+  iterator erase(const_iterator pos) {
+    Node* node = pos.node_;
+    iterator next(node);
+    ++next;
+
+    Level* level = node->level;
+
+    if(node->prev)
+      node->prev->next = node->next;
+    else
+      level->head = node->next;
+
+    if(node->next)
+      node->next->prev = node->prev;
+    else
+      level->tail = node->prev;
+
+    destroy_node(node);
+    --size_;
+
+    if(!level->head)
+      erase_level(level);
+
+    return next;
+  }
+
+  void clear() {
+    for(auto lit = levels_.begin(); lit != levels_.end(); ++lit) {
+      Node* node = (*lit)->head;
+      while(node) {
+        Node* next = node->next;
+        NodeTraits::destroy(node_alloc_, node);
+        node = next;
+      }
+      destroy_level(*lit);
+    }
+
+    levels_.clear();
+    size_ = 0;
+  }
+
+private:
+  struct Chunk;
+  struct FreeSlot { FreeSlot* next; };
+
+  /* first chunk of a level, chunks then double up to MAX_CHUNK_BYTES,
+    the largest size class of BookArena */
+  static const size_t MIN_CHUNK_NODES = 4;
+  static const size_t MAX_CHUNK_BYTES = 1024;
+
+  struct Level {
+    Level(const key_type& price_) :
+      price(price_), head(nullptr), tail(nullptr),
+      better(nullptr), worse(nullptr), chunks(nullptr), free(nullptr) {}
+
+    key_type price;
+    Node* head;
+    Node* tail;
+    Level* better;
+    Level* worse;
+    Chunk* chunks; /* newest first */
+    FreeSlot* free;
+  };
+
+  struct Node {
+    template <class T>
+    Node(Level* level_, const key_type& key, T&& tracker) :
+      value(key, std::forward<T>(tracker)),
+      level(level_), prev(nullptr), next(nullptr) {}
+
+    value_type value;
+    Level* level;
+    Node* prev;
+    Node* next;
+  };
+
+  /* header of a block of `capacity` node slots, which follow it */
+  struct alignas(Node) Chunk {
+    Chunk* next;
+    size_t capacity;
+    size_t used;
+
+    Node* slots() { return reinterpret_cast<Node*>(this + 1); }
+
+    /* in units of Chunk, header included */
+    static size_t units(size_t capacity) {
+      return 1 + (capacity * sizeof(Node) + sizeof(Chunk) - 1) / sizeof(Chunk);
+    }
+  };
+
+  typedef std::allocator_traits<Alloc> AllocTraits;
+  typedef typename AllocTraits::template rebind_alloc<Node> NodeAlloc;
+  typedef typename AllocTraits::template rebind_alloc<Chunk> ChunkAlloc;
+  typedef typename AllocTraits::template rebind_alloc<Level> LevelAlloc;
+  typedef typename AllocTraits::template rebind_alloc<Level*> LevelPtrAlloc;
+  typedef std::allocator_traits<NodeAlloc> NodeTraits;
+  typedef std::allocator_traits<ChunkAlloc> ChunkTraits;
+  typedef std::allocator_traits<LevelAlloc> LevelTraits;
+
+  typedef std::vector<Level*, LevelPtrAlloc> Levels;
+
+  NodeAlloc node_alloc_;
+  ChunkAlloc chunk_alloc_;
+  LevelAlloc level_alloc_;
+
+  /* sorted from the worst to the best level */
+  Levels levels_;
+  size_type size_;
+
+  Node* allocate_node(Level* level) {
+    if(level->free) {
+      FreeSlot* slot = level->free;
+      level->free = slot->next;
+      return reinterpret_cast<Node*>(slot);
+    }
+
+    Chunk* chunk = level->chunks;
+    if(!chunk || chunk->used == chunk->capacity) {
+      size_t max_nodes = std::max<size_t>(1, (MAX_CHUNK_BYTES - sizeof(Chunk)) / sizeof(Node));
+      size_t capacity = chunk ? std::min(chunk->capacity * 2, max_nodes)
+                              : std::min((size_t) MIN_CHUNK_NODES, max_nodes);
+
+      Chunk* fresh = ChunkTraits::allocate(chunk_alloc_, Chunk::units(capacity));
+      fresh->next = chunk;
+      fresh->capacity = capacity;
+      fresh->used = 0;
+      level->chunks = chunk = fresh;
+    }
+
+    return chunk->slots() + chunk->used++;
+  }
+
+  /* the slot goes back to its level, chunks are released with the level */
+  void destroy_node(Node* node) {
+    Level* level = node->level;
+    NodeTraits::destroy(node_alloc_, node);
+
+    FreeSlot* slot = reinterpret_cast<FreeSlot*>(node);
+    slot->next = level->free;
+    level->free = slot;
+  }
+
+  void destroy_level(Level* level) {
+    Chunk* chunk = level->chunks;
+    while(chunk) {
+      Chunk* next = chunk->next;
+      ChunkTraits::deallocate(chunk_alloc_, chunk, Chunk::units(chunk->capacity));
+      chunk = next;
+    }
+
+    LevelTraits::destroy(level_alloc_, level);
+    LevelTraits::deallocate(level_alloc_, level, 1);
+  }
+
+  Node* best_head() const {
+    return levels_.empty() ? nullptr : levels_.back()->head;
+  }
+
+  /* first level that is not worse than `key` */
+  typename Levels::const_iterator lower_bound(const key_type& key) const {
+    return std::lower_bound(levels_.begin(), levels_.end(), key,
+      [](const Level* level, const key_type& k) { return k < level->price; });
+  }
+
+  Level* find_level(const key_type& key) const {
+    /* most of the activity happens at the top of the book */
+    if(!levels_.empty() && levels_.back()->price == key)
+      return levels_.back();
+
+    auto pos = lower_bound(key);
+    if(pos != levels_.end() && (*pos)->price == key)
+      return *pos;
+
+    return nullptr;
+  }
+
+  Level* find_or_insert_level(const key_type& key) {
+    if(!levels_.empty() && levels_.back()->price == key)
+      return levels_.back();
+
+    auto pos = levels_.begin() + (lower_bound(key) - levels_.cbegin());
+    if(pos != levels_.end() && (*pos)->price == key)
+      return *pos;
+
+    Level* level = LevelTraits::allocate(level_alloc_, 1);
+    LevelTraits::construct(level_alloc_, level, key);
+    level->better = pos != levels_.end() ? *pos : nullptr;
+    level->worse = pos != levels_.begin() ? *(pos - 1) : nullptr;
+
+    if(level->better) level->better->worse = level;
+    if(level->worse) level->worse->better = level;
+
+    levels_.insert(pos, level);
+    return level;
+  }
+
+  void erase_level(Level* level) {
+    if(level->better) level->better->worse = level->worse;
+    if(level->worse) level->worse->better = level->better;
+
+    /* sweeps empty the best level first */
+    if(levels_.back() == level) {
+      levels_.pop_back();
+    } else {
+      auto pos = levels_.begin() + (lower_bound(level->price) - levels_.cbegin());
+      assert(pos != levels_.end() && *pos == level);
+      levels_.erase(pos);
+    }
+
+    destroy_level(level);
+  }
+};
+
+}
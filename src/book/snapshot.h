@@ -0,0 +1,336 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "journal.h"
+
+namespace book {
+
+/**
+ * \brief snapshot of a book: its resting orders, market price, time, and
+ *  the state of its plugins. OB::save() writes one, OB::load() restores it
+ *  into an empty book of the same configuration without matching, in
+ *  time proportional to the orders in it.
+ *
+ *  a file is a SnapshotHeader, then the book, then one section per
+ *  plugin in the order of Plugins. plugins with state implement
+ *
+ *    template <class Writer> void save_state(Writer& out) const;
+ *    template <class Reader> void load_state(Reader& in);
+ *
+ *  orders are encoded by the Codec of the journal, once each: later
+ *  references to the same order are by index, so that orders shared by
+ *  the book and the plugins are shared again once loaded. trackers are
+ *  rebuilt from their order, then given back their qty and fills.
+ *
+ *  journal_seq is the last journal record the snapshot includes, the
+ *  journal is replayed from the next one (see JournalReplayer::resume)
+ */
+
+class SnapshotException : public std::runtime_error {
+public:
+  explicit SnapshotException(const std::string& what) : std::runtime_error(what) {}
+};
+
+static const char SNAPSHOT_MAGIC[4] = { 'O', 'B', 'S', 'N' };
+static const uint32_t SNAPSHOT_VERSION = 4;
+
+struct SnapshotHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t symbol_id;
+  uint32_t sections;     /* one per plugin */
+  uint64_t journal_seq;
+  uint64_t orders;
+  uint64_t size;         /* of what follows the header */
+};
+
+template <class Codec>
+class SnapshotWriter {
+public:
+  typedef decltype(Codec::decode(std::declval<JournalDecoder&>())) OrderPtr;
+
+  SnapshotWriter() : sections_(0) {}
+
+  template <class T>
+  void put(const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    data_.insert(data_.end(), bytes, bytes + sizeof(T));
+  }
+
+  /* the order itself the first time, its index after that */
+  void put_order(const OrderPtr& order) {
+    if(!order) return put((uint32_t) UINT32_MAX);
+
+    auto indexed = orders_.emplace(&*order, (uint32_t) orders_.size());
+    put(indexed.first->second);
+    if(!indexed.second) return;
+
+    JournalEncoder record(journal_add);
+    Codec::encode(order, record);
+
+    size_t size = record.size() - sizeof(JournalRecordHeader);
+    put((uint16_t) size);
+    data_.insert(data_.end(), record.data() + sizeof(JournalRecordHeader), record.data() + record.size());
+  }
+
+  template <class Tracker>
+  void put_tracker(const Tracker& tracker) {
+    put_order(tracker.ptr());
+    put(tracker.qty());
+    put(tracker.filled_qty());
+    put(tracker.filled_cost());
+  }
+
+  template <class Callback>
+  void put_callback(const Callback& cb) {
+    put(cb.type);
+    put(cb.flags);
+    put(cb.reason);
+    put_order(cb.order);
+    put_order(cb.maker_order);
+    put(cb.qty);
+    put(cb.price);
+    put(cb.avg_price);
+    put(cb.generic_1);
+    put(cb.generic_2);
+    put(cb.generic_3);
+    put(cb.user_id);
+    put(cb.scope);
+  }
+
+  /* sections are prefixed with their size */
+  size_t begin_section() {
+    size_t at = data_.size();
+    put((uint32_t) 0);
+    return at;
+  }
+
+  void end_section(size_t at) {
+    uint32_t size = (uint32_t) (data_.size() - at - sizeof(uint32_t));
+    memcpy(&data_[at], &size, sizeof(size));
+    ++sections_;
+  }
+
+  void write(const std::string& path, uint32_t symbol_id, uint64_t journal_seq) const {
+    SnapshotHeader header = SnapshotHeader();
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.symbol_id = symbol_id;
+    header.sections = sections_;
+    header.journal_seq = journal_seq;
+    header.orders = orders_.size();
+    header.size = data_.size();
+
+    /* written aside, synced, then renamed and the rename synced: a crash
+      leaves either the previous snapshot or the whole new one */
+    std::string tmp = path + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "wb");
+    if(!file)
+      throw SnapshotException("cannot write snapshot " + path);
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+      (data_.empty() || fwrite(data_.data(), data_.size(), 1, file) == 1) &&
+      fflush(file) == 0 && fsync(fileno(file)) == 0;
+    ok &= fclose(file) == 0;
+
+    if(!ok || rename(tmp.c_str(), path.c_str()) || !sync_dir(path))
+      throw SnapshotException("cannot write snapshot " + path);
+  }
+
+private:
+  /* makes the entry of `path` in its directory durable */
+  static bool sync_dir(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." :
+      slash == 0 ? "/" : path.substr(0, slash);
+
+    int fd = open(dir.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    bool ok = fsync(fd) == 0;
+    return close(fd) == 0 && ok;
+  }
+
+  std::vector<char> data_;
+  std::unordered_map<const void*, uint32_t> orders_;
+  uint32_t sections_;
+};
+
+template <class Codec>
+class SnapshotReader {
+public:
+  typedef decltype(Codec::decode(std::declval<JournalDecoder&>())) OrderPtr;
+
+  /* maps the file, it is read in place */
+  explicit SnapshotReader(const std::string& path) : data_(nullptr), size_(0), pos_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw SnapshotException("cannot open snapshot " + path);
+
+    struct stat st;
+    if(fstat(fd, &st) || (size_t) st.st_size < sizeof(SnapshotHeader)) {
+      close(fd);
+      throw SnapshotException("snapshot too short " + path);
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if(data == MAP_FAILED)
+      throw SnapshotException("cannot map snapshot " + path);
+
+    data_ = static_cast<const char*>(data);
+    size_ = st.st_size;
+
+    memcpy(&header_, data_, sizeof(header_));
+    pos_ = sizeof(header_);
+
+    if(memcmp(header_.magic, SNAPSHOT_MAGIC, sizeof(header_.magic))) {
+      unmap();
+      throw SnapshotException("not a snapshot " + path);
+    }
+
+    if(header_.version != SNAPSHOT_VERSION) {
+      unmap();
+      throw SnapshotException("unsupported snapshot version " + path);
+    }
+
+    if(header_.size != size_ - sizeof(header_)) {
+      unmap();
+      throw SnapshotException("snapshot truncated " + path);
+    }
+
+    orders_.reserve(header_.orders);
+  }
+
+  ~SnapshotReader() { unmap(); }
+
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+  uint32_t symbol_id() const { return header_.symbol_id; }
+  uint64_t journal_seq() const { return header_.journal_seq; }
+  uint32_t sections() const { return header_.sections; }
+
+  /* the orders loaded so far, e.g. for JournalReplayer::resume */
+  const std::vector<OrderPtr>& orders() const { return orders_; }
+
+  template <class T>
+  T get() {
+    T value;
+    need(sizeof(T));
+    memcpy(&value, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  OrderPtr get_order() {
+    uint32_t index = get<uint32_t>();
+    if(index == UINT32_MAX) return OrderPtr();
+    if(index < orders_.size()) return orders_[index];
+    if(index != orders_.size())
+      throw SnapshotException("snapshot refers to an unknown order");
+
+    uint16_t size = get<uint16_t>();
+    need(size);
+
+    JournalDecoder payload(data_ + pos_, size);
+    orders_.push_back(Codec::decode(payload));
+    pos_ += size;
+
+    return orders_.back();
+  }
+
+  /* the rest of a tracker saved with put_tracker(), built from its order */
+  template <class Tracker>
+  void restore_tracker(Tracker& tracker) {
+    typename Tracker::Qty qty = get<typename Tracker::Qty>();
+    typename Tracker::Qty filled_qty = get<typename Tracker::Qty>();
+    typename Tracker::Cost filled_cost = get<typename Tracker::Cost>();
+    tracker.restore(qty, filled_qty, filled_cost);
+  }
+
+  template <class Callback>
+  Callback get_callback() {
+    Callback cb;
+    cb.type = get<decltype(cb.type)>();
+    cb.flags = get<uint8_t>();
+    cb.reason = get<uint8_t>();
+    cb.order = get_order();
+    cb.maker_order = get_order();
+    cb.qty = get<decltype(cb.qty)>();
+    cb.price = get<decltype(cb.price)>();
+    cb.avg_price = get<double>();
+    cb.generic_1 = get<double>();
+    cb.generic_2 = get<double>();
+    cb.generic_3 = get<double>();
+    cb.user_id = get<uint64_t>();
+    cb.scope = get<decltype(cb.scope)>();
+    return cb;
+  }
+
+  /* returns where the section ends */
+  size_t begin_section() {
+    uint32_t size = get<uint32_t>();
+    need(size);
+    return pos_ + size;
+  }
+
+  void end_section(size_t end) {
+    if(pos_ != end)
+      throw SnapshotException("plugin state does not match the snapshot");
+  }
+
+private:
+  void need(size_t n) {
+    if(pos_ + n > size_)
+      throw SnapshotException("snapshot truncated");
+  }
+
+  void unmap() {
+    if(data_) munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t pos_;
+  SnapshotHeader header_;
+  std::vector<OrderPtr> orders_;
+};
+
+}
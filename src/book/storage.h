@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <map>
+
+#include "book_price.h"
+#include "price_ladder.h"
+#include "arena.h"
+
+namespace book {
+
+/* storage engines for the resting orders of the book. Side<Tracker> is
+ * the container holding one side, sorted by BookPrice then by time.
+ * keys are in the Price type of the tracker. sides allocate from the
+ * arena of the book they belong to */
+
+template <class Tracker>
+using SideKey = BasicBookPrice<typename Tracker::Price>;
+
+template <class Tracker>
+using SideAllocator = ArenaAllocator<std::pair<const SideKey<Tracker>, Tracker>>;
+
+/* one red-black node per resting order */
+struct MapStorage {
+  template <class Tracker>
+  using Side = std::multimap<SideKey<Tracker>, Tracker,
+    std::less<SideKey<Tracker>>, SideAllocator<Tracker>>;
+};
+
+/* sorted price levels, each holding a FIFO of trackers */
+struct LadderStorage {
+  template <class Tracker>
+  using Side = PriceLadder<Tracker, SideAllocator<Tracker>>;
+};
+
+/* plugins are declared as P<Tracker, Book = UnboundBook>. this rebinds
+ * them to the book they are mixed into, which they reach statically */
+template <class Plugin, class Book>
+struct bind_book {
+  typedef Plugin type;
+};
+
+template <template <class, class> class P, class Tracker, class B, class Book>
+struct bind_book<P<Tracker, B>, Book> {
+  typedef P<Tracker, Book> type;
+};
+
+/* and P<Tracker, Book = UnboundBook, N>, e.g. the capacity of RoutablePlugin */
+template <template <class, class, size_t> class P, class Tracker, class B, size_t N, class Book>
+struct bind_book<P<Tracker, B, N>, Book> {
+  typedef P<Tracker, Book, N> type;
+};
+
+}
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include "arena.h"
+
+namespace book {
+
+/**
+ * \brief hierarchical timer wheel. Levels wheels of 64 slots each: a
+ *  slot of level k spans 64^k ticks, so that level 0 holds the timers of
+ *  the next 64 ticks, level 1 those of the next 4096, and so on. timers
+ *  further out than 64^Levels ticks wait in the last level and are placed
+ *  again when their slot comes around.
+ *
+ *  inserting and erasing a timer is O(1): a timer is a node of the
+ *  doubly linked list of its slot, and its handle is its index in a pool
+ *  of nodes recycled through a free list. advance() moves down to level
+ *  0 the timers of each slot of a higher level as its time comes, and
+ *  skips ticks without timers, so that its cost does not depend on how
+ *  far time moves.
+ *
+ *  ticks are in any unit, e.g. milliseconds. nothing happens between
+ *  two calls to advance(), the wheel has no clock of its own
+ */
+
+template <class T, unsigned Levels = 8>
+class TimerWheel {
+  static_assert(Levels > 0 && Levels * 6 < 64, "64^Levels ticks must fit 64 bits");
+
+public:
+  typedef uint32_t Handle;
+  static const Handle npos = UINT32_MAX;
+
+  explicit TimerWheel(BookArena* arena = nullptr, uint64_t now = 0) :
+    nodes_(arena), free_(npos), size_(0), now_(now)
+  {
+    for(unsigned i = 0; i < Levels * SLOTS; ++i)
+      heads_[i] = tails_[i] = npos;
+
+    for(unsigned k = 0; k < Levels; ++k)
+      occupied_[k] = 0;
+  }
+
+  /* the last tick advanced to. timers up to it have fired */
+  uint64_t now() const { return now_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /* room for `count` timers without growing the pool */
+  void reserve(size_t count) { nodes_.reserve(count); }
+
+  /* a timer firing at `deadline`, or at the next tick if it is past */
+  Handle insert(uint64_t deadline, const T& value) {
+    Handle timer;
+
+    if(free_ != npos) {
+      timer = free_;
+      free_ = nodes_[timer].next;
+    } else {
+      timer = (Handle) nodes_.size();
+      nodes_.push_back(Node());
+    }
+
+    Node& node = nodes_[timer];
+    node.deadline = deadline;
+    node.value = value;
+    ++size_;
+
+    place(timer, deadline > now_ ? deadline : now_ + 1);
+    return timer;
+  }
+
+  /* a timer that has not fired yet */
+  void erase(Handle timer) {
+    unlink(timer);
+    release(timer);
+  }
+
+  const T& value(Handle timer) const { return nodes_[timer].value; }
+  uint64_t deadline(Handle timer) const { return nodes_[timer].deadline; }
+
+  /**
+   * \brief moves time to `now`, calling fn(value, deadline) for every
+   *  timer due by then, in order of deadline. fn must not insert nor
+   *  erase timers. time does not go back, an earlier `now` does nothing
+   * \return the number of timers fired
+   */
+  template <class Fn>
+  size_t advance(uint64_t now, Fn fn) {
+    size_t fired = 0;
+
+    while(size_ > 0) {
+      uint64_t next = next_tick();
+      if(next > now) break;
+
+      now_ = next - 1;
+      fired += tick(fn);
+    }
+
+    if(now > now_)
+      now_ = now;
+
+    return fired;
+  }
+
+  /* the first tick after now() at which advance() has work to do,
+    firing timers or moving them down a level. no timer fires before
+    it. UINT64_MAX without timers */
+  uint64_t next_tick() const {
+    uint64_t next = UINT64_MAX;
+
+    for(unsigned k = 0; k < Levels; ++k) {
+      uint64_t occupied = occupied_[k];
+      if(!occupied) continue;
+
+      /* slots after the current one first, wrapping around */
+      uint64_t base = now_ >> (k * BITS);
+      unsigned from = (base + 1) & (SLOTS - 1);
+      uint64_t rotated = from == 0 ? occupied : (occupied >> from) | (occupied << (SLOTS - from));
+      uint64_t tick = (base + 1 + __builtin_ctzll(rotated)) << (k * BITS);
+
+      if(tick < next)
+        next = tick;
+    }
+
+    return next;
+  }
+
+  /* drops every timer and starts again at `now` */
+  void clear(uint64_t now) {
+    nodes_.clear();
+    free_ = npos;
+    size_ = 0;
+    now_ = now;
+
+    for(unsigned i = 0; i < Levels * SLOTS; ++i)
+      heads_[i] = tails_[i] = npos;
+
+    for(unsigned k = 0; k < Levels; ++k)
+      occupied_[k] = 0;
+  }
+
+private:
+  static const unsigned BITS = 6;
+  static const unsigned SLOTS = 1 << BITS;
+  static const uint64_t RANGE = (uint64_t) 1 << (BITS * Levels);
+
+  struct Node {
+    uint64_t deadline;
+    T value;
+    Handle prev;
+    Handle next;
+    uint32_t slot;
+  };
+
+  /* links the timer in the slot where tick `at` falls */
+  void place(Handle timer, uint64_t at) {
+    uint64_t delta = at - now_;
+
+    if(delta >= RANGE) {
+      at = now_ + RANGE - 1;
+      delta = RANGE - 1;
+    }
+
+    unsigned level = delta == 0 ? 0 : (63 - __builtin_clzll(delta)) / BITS;
+    unsigned index = (at >> (level * BITS)) & (SLOTS - 1);
+    uint32_t slot = level * SLOTS + index;
+
+    Node& node = nodes_[timer];
+    node.slot = slot;
+    node.next = npos;
+    node.prev = tails_[slot];
+
+    if(tails_[slot] == npos) heads_[slot] = timer;
+    else nodes_[tails_[slot]].next = timer;
+
+    tails_[slot] = timer;
+    occupied_[level] |= (uint64_t) 1 << index;
+  }
+
+  void unlink(Handle timer) {
+    Node& node = nodes_[timer];
+
+    if(node.prev == npos) heads_[node.slot] = node.next;
+    else nodes_[node.prev].next = node.next;
+
+    if(node.next == npos) tails_[node.slot] = node.prev;
+    else nodes_[node.next].prev = node.prev;
+
+    if(heads_[node.slot] == npos)
+      occupied_[node.slot / SLOTS] &= ~((uint64_t) 1 << (node.slot % SLOTS));
+  }
+
+  void release(Handle timer) {
+    nodes_[timer].value = T();
+    nodes_[timer].next = free_;
+    free_ = timer;
+    --size_;
+  }
+
+  /* takes the whole list of a slot out of the wheel */
+  Handle detach(unsigned level, unsigned index) {
+    uint32_t slot = level * SLOTS + index;
+    Handle head = heads_[slot];
+
+    heads_[slot] = tails_[slot] = npos;
+    occupied_[level] &= ~((uint64_t) 1 << index);
+    return head;
+  }
+
+  /* moves to the next tick: slots of the higher levels whose time has
+    come are moved down, then the slot of the tick fires */
+  template <class Fn>
+  size_t tick(Fn& fn) {
+    ++now_;
+
+    for(unsigned k = 1; k < Levels; ++k) {
+      if((now_ & (((uint64_t) 1 << (k * BITS)) - 1)) != 0) break;
+
+      unsigned index = (now_ >> (k * BITS)) & (SLOTS - 1);
+      for(Handle timer = detach(k, index); timer != npos; ) {
+        Handle next = nodes_[timer].next;
+        place(timer, nodes_[timer].deadline);
+        timer = next;
+      }
+    }
+
+    size_t fired = 0;
+    for(Handle timer = detach(0, now_ & (SLOTS - 1)); timer != npos; ++fired) {
+      Handle next = nodes_[timer].next;
+      fn(nodes_[timer].value, nodes_[timer].deadline);
+      release(timer);
+      timer = next;
+    }
+
+    return fired;
+  }
+
+  std::vector<Node, ArenaAllocator<Node>> nodes_;
+  Handle free_;
+  size_t size_;
+  uint64_t now_;
+
+  Handle heads_[Levels * SLOTS];
+  Handle tails_[Levels * SLOTS];
+  uint64_t occupied_[Levels];
+};
+
+template <class T, unsigned Levels>
+const typename TimerWheel<T, Levels>::Handle TimerWheel<T, Levels>::npos;
+
+}
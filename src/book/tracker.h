@@ -23,33 +23,101 @@
 #pragma once
 
 #include <stdexcept>
+#include <type_traits>
 #include <cassert>
 #include <cmath>
 #include "constants.h"
+#include "units.h"
 
 namespace book {
 
-template <class Order>
+/**
+ * \brief plain per-order state of the plugins, laid out as consecutive
+ *  members. unlike std::tuple it stays standard-layout, so a FlatTracker
+ *  built from standard-layout states is standard-layout too.
+ *
+ *  each state is constructed from the order, and exposes a nested
+ *  Accessors<Tracker> mixin that gives the tracker the accessors of
+ *  the plugin (e.g. user_id() or stp())
+ */
+
+template <class... States>
+struct TrackerState;
+
+template <>
+struct TrackerState<> {
+  template <class Order>
+  explicit TrackerState(const Order&) {}
+};
+
+template <class State>
+struct TrackerState<State> {
+  template <class Order>
+  explicit TrackerState(const Order& order) : head(order) {}
+
+  State& get(State*) { return head; }
+  const State& get(State*) const { return head; }
+
+  State head;
+};
+
+template <class State, class... Rest>
+struct TrackerState<State, Rest...> {
+  template <class Order>
+  explicit TrackerState(const Order& order) : head(order), tail(order) {}
+
+  State& get(State*) { return head; }
+  const State& get(State*) const { return head; }
+
+  template <class S>
+  S& get(S* tag) { return tail.get(tag); }
+
+  template <class S>
+  const S& get(S* tag) const { return tail.get(tag); }
+
+  State head;
+  TrackerState<Rest...> tail;
+};
+
+template <class Order, class Units_ = FloatingPoint, class State_ = TrackerState<>>
 struct BaseTracker {
   typedef Order OrderPtr;
+  typedef Units_ Units;
+  typedef State_ State;
+  typedef typename Units::Price Price;
+  typedef typename Units::Qty Qty;
+  typedef typename Units::Cost Cost;
 
   BaseTracker(const Order& order) :
-    is_bid_(order->is_bid()),
     price_(order->price()),
     qty_(order->qty()),
+    filled_qty_(0),
     funds_(order->funds()),
+    filled_cost_(0),
+    is_bid_(order->is_bid()),
+    state_(order),
+    order_(order) {
+    static_assert(!Units::scaled,
+      "fixed-point trackers are built with the TickScale of the book");
+  }
+
+  /* converts the price, qty and funds of the order to ticks and lots */
+  BaseTracker(const Order& order, const TickScale& scale) :
+    price_(scale.to_ticks(order->price())),
+    qty_(scale.to_lots(order->qty())),
     filled_qty_(0),
+    funds_(scale.to_tick_lots(order->funds())),
     filled_cost_(0),
-    avg_price_(0),
+    is_bid_(order->is_bid()),
+    state_(order),
     order_(order) { }
-  
-  /* virtual destructor to make BaseTracker polymorphic */
-  virtual ~BaseTracker() = default;
+
+  static Qty min_qty() { return Units::min_qty(); }
 
   bool is_bid() const { return is_bid_; }
-  double price() const { return price_; }
+  Price price() const { return price_; }
 
-  void fill(double fill_qty, double fill_cost) {
+  void fill(Qty fill_qty, Cost fill_cost) {
     if(funds_ != 0 && fill_cost + filled_cost_ > funds_) {
       throw std::runtime_error("Market buy fill exceeds funds");
     }
@@ -58,73 +126,136 @@ struct BaseTracker {
       throw std::runtime_error("Fill qty exceeds order qty");
     }
 
-    avg_price_ = (avg_price_ * filled_qty_  + fill_cost) / (filled_qty_ + fill_qty); 
     filled_cost_ += fill_cost;
     filled_qty_ += fill_qty;
   }
   
   bool filled() const {
     if(funds_ != 0)
-      return (funds_ - filled_cost_) < MIN_ORDER_FUNDS;
+      return Units::funds_exhausted(funds_ - filled_cost_);
     else
-      return (qty_ - filled_qty_) < MIN_ORDER_QTY;
+      return (qty_ - filled_qty_) < min_qty();
   }
 
-  double qty_on_book() const {
+  Qty qty_on_book() const {
     return price_ == 0 ? 0 : qty_ - filled_qty_;
   }
 
-  double open_qty() const {
+  Qty open_qty() const {
     assert(qty_ != 0);
     return qty_ - filled_qty_;
   }
 
-  double tradable_qty(double price) const {
+  Qty tradable_qty(Price price) const {
     /* limiting factor is qty only */
     if(funds_ == 0)
       return qty_ - filled_qty_;
 
     /* limiting factor is funds only */
     if(qty_ == 0)
-      return floor((funds_ - filled_cost_) / price / TRADE_QTY_INCREMENT) * TRADE_QTY_INCREMENT;
+      return Units::affordable_qty(funds_ - filled_cost_, price);
 
     /* limiting factors are both qty and funds */
-    return std::min(qty_ - filled_qty_, floor((funds_ - filled_cost_) / price / TRADE_QTY_INCREMENT) * TRADE_QTY_INCREMENT);
+    return std::min(qty_ - filled_qty_, Units::affordable_qty(funds_ - filled_cost_, price));
   }
 
   const Order& ptr() const {
     return order_;
   }
 
-  double filled_qty() const {
+  Qty filled_qty() const {
     return filled_qty_;
   }
 
-  double filled_cost() const {
+  Cost filled_cost() const {
     return filled_cost_;
   }
 
+  /* 0 unless the order is bounded by funds */
+  Cost funds() const {
+    return funds_;
+  }
+
+  /* in ticks for fixed-point trackers. derived from the fills rather
+    than kept up to date, only callbacks read it */
   double avg_price() const {
-    return avg_price_;
+    return filled_qty_ == 0 ? 0 : (double) filled_cost_ / filled_qty_;
   }
 
-  void change_open_qty(double delta) {
+  /* qty of the order, as changed by replaces */
+  Qty qty() const {
+    return qty_;
+  }
+
+  /* for trackers loaded from a snapshot (see snapshot.h) */
+  void restore(Qty qty, Qty filled_qty, Cost filled_cost) {
+    qty_ = qty;
+    filled_qty_ = filled_qty;
+    filled_cost_ = filled_cost;
+  }
+
+  void change_open_qty(Qty delta) {
     assert(qty_ != 0);
     assert(delta >= 0 || -delta <= qty_ - filled_qty_);
 
     qty_ += delta;
   }
 
+  /* plugin state S of the tracker, see TrackerState */
+  template <class S>
+  S& state() { return state_.get((S*) nullptr); }
+
+  template <class S>
+  const S& state() const { return state_.get((S*) nullptr); }
+
 protected:
+  /* the members are ordered, not split: what a match reads or writes for
+    every maker comes first, right after the price key of its node in the
+    storages, so that it fits in one cache line. the order pointer stays in the
+    tracker rather than in a side table, plugins copy trackers (e.g. the
+    taker of a routed sweep) and read ptr() from them in any hook */
+  Price price_;
+  Qty qty_;
+  Qty filled_qty_;
+  const Cost funds_;
+  Cost filled_cost_;
   const bool is_bid_;
-  double price_;
-  double qty_;
-  const double funds_;
-  double filled_qty_;
-  double filled_cost_;
-  double avg_price_;
+  /* states made of flags only fit in the padding after is_bid_ */
+  State state_;
+
+  /* last, read to build callbacks and by plugins */
   const Order order_;
 };
 
+/**
+ * \brief tracker composed of plugin states instead of tracker mixins.
+ *  it has no virtual base and no vtable, all its data lives in
+ *  BaseTracker, and its size is the sum of the states plus padding.
+ *
+ *    typedef FlatTracker<OrderPtr, TrackerState<
+ *      plugins::UserIDState<OrderPtr>,
+ *      plugins::SelfTradePolicyState<OrderPtr>>> Tracker;
+ *
+ *  each tracker mixin FooTracker of a plugin has a flat counterpart,
+ *  FooState, next to it with the same accessors. user_id() is needed by
+ *  several plugins, so it is a state of its own that is listed once:
+ *  SelfTradePolicyState and ReduceOnlyState are used along with it, and
+ *  Positions and Routable need nothing else. is_bid() and the quantities
+ *  always come from BaseTracker.
+ */
+
+template <class Order, class States = TrackerState<>, class Units = FloatingPoint>
+struct FlatTracker;
+
+template <class Order, class... States, class Units>
+struct FlatTracker<Order, TrackerState<States...>, Units> :
+  public BaseTracker<Order, Units, TrackerState<States...>>,
+  public States::template Accessors<FlatTracker<Order, TrackerState<States...>, Units>>... {
+
+  typedef BaseTracker<Order, Units, TrackerState<States...>> Base;
+
+  FlatTracker(const Order& order) : Base(order) {}
+  FlatTracker(const Order& order, const TickScale& scale) : Base(order, scale) {}
+};
 
-}
\ No newline at end of file
+}
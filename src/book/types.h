@@ -32,7 +32,10 @@ enum InsertRejectReasons : uint8_t {
   insufficient_funds,
   qty_too_small,
   funds_too_small,
-  duplicate_client_order_id
+  duplicate_client_order_id,
+  fill_or_kill_unfilled,
+  min_qty_unfilled,
+  off_grid               /* price or qty not a whole number of ticks or lots */
 };
 
 enum CancelRejectReasons : uint8_t {
@@ -60,6 +63,9 @@ enum CancelReasons : uint8_t {
   reduce_only_close,
   mm_routed,
   routing_failure,  
+  immediate_or_cancel,
+  expired,
+  routing_timeout,
 };
 
 
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <cmath>
+#include <algorithm>
+
+#include "constants.h"
+
+namespace book {
+
+/* price in ticks, qty in lots, and cost (price * qty) in tick-lots */
+typedef int64_t Ticks;
+typedef int64_t Lots;
+typedef int64_t TickLots;
+
+/**
+ * \brief tick size and lot size of a symbol. converts the double
+ *  prices and quantities of orders to ticks and lots, and back
+ */
+
+class TickScale {
+public:
+  TickScale(double tick_size = 1, double lot_size = 1) :
+    tick_size_(tick_size), lot_size_(lot_size) {}
+
+  double tick_size() const { return tick_size_; }
+  double lot_size() const { return lot_size_; }
+
+  /* whether a price or qty is a whole number of ticks or lots, within
+    rounding error. OB rejects orders that are not, rounding them would
+    change what they mean, e.g. move a limit past itself */
+  bool on_ticks(double price) const { return is_whole(price / tick_size_); }
+  bool on_lots(double qty) const { return is_whole(qty / lot_size_); }
+
+  /* of values on the grid, see on_ticks() */
+  Ticks to_ticks(double price) const {
+    return llround(price / tick_size_);
+  }
+
+  Lots to_lots(double qty) const {
+    return llround(qty / lot_size_);
+  }
+
+  /* a qty the order needs at least, rounded up so that it never gets
+    less than it asked for */
+  Lots to_min_lots(double qty) const {
+    double lots = qty / lot_size_;
+    return is_whole(lots) ? llround(lots) : (Lots) ceil(lots);
+  }
+
+  /* funds are rounded down, an order never spends more than it has.
+    quotients within rounding error of a whole number are kept whole */
+  TickLots to_tick_lots(double funds) const {
+    double tick_lots = funds / (tick_size_ * lot_size_);
+    return is_whole(tick_lots) ? llround(tick_lots) : (TickLots) floor(tick_lots);
+  }
+
+  double to_price(double ticks) const { return ticks * tick_size_; }
+  double to_qty(double lots) const { return lots * lot_size_; }
+  double to_funds(double tick_lots) const { return tick_lots * tick_size_ * lot_size_; }
+
+private:
+  static bool is_whole(double units) {
+    double nearest = nearbyint(units);
+    return fabs(units - nearest) <= EPSILON * std::max(1.0, fabs(nearest));
+  }
+
+  double tick_size_;
+  double lot_size_;
+};
+
+/**
+ * \brief numeric policies of the trackers. OB, the book sides and the
+ *  callbacks all use the Price, Qty and Cost types of the tracker
+ */
+
+struct FloatingPoint {
+  typedef double Price;
+  typedef double Qty;
+  typedef double Cost;
+
+  /* trackers are built from the order alone */
+  static const bool scaled = false;
+
+  static Qty min_qty() { return MIN_ORDER_QTY; }
+
+  static bool funds_exhausted(Cost funds_left) {
+    return funds_left < MIN_ORDER_FUNDS;
+  }
+
+  /* qty that funds can buy at price. can exceed the funds,
+    so we round down to its nearest TRADE_QTY_INCREMENT */
+  static Qty affordable_qty(Cost funds_left, Price price) {
+    return floor(funds_left / price / TRADE_QTY_INCREMENT) * TRADE_QTY_INCREMENT;
+  }
+};
+
+struct FixedPoint {
+  typedef Ticks Price;
+  typedef Lots Qty;
+  typedef TickLots Cost;
+
+  /* trackers are built from the order and the TickScale of the book */
+  static const bool scaled = true;
+
+  static Qty min_qty() { return 1; }
+
+  static bool funds_exhausted(Cost funds_left) {
+    return funds_left <= 0;
+  }
+
+  static Qty affordable_qty(Cost funds_left, Price price) {
+    return funds_left / price;
+  }
+};
+
+}
@@ -14,9 +14,16 @@
 
 namespace depth {
 
-template <int SIZE=30>
+/**
+ * \brief top SIZE levels of each side. Price and Quantity default to
+ *  double. books using fixed-point trackers pass ticks and lots
+ */
+
+template <int SIZE=30, class Price = depth::Price, class Quantity = depth::Quantity>
 class Depth {
 public:
+  typedef BasicDepthLevel<Price, Quantity> DepthLevel;
+
   Depth();
 
   const DepthLevel* bids() const;
@@ -42,7 +49,7 @@ public:
 
   bool close_order(Price price, Quantity open_qty, bool is_bid);
 
-  void change_qty_order(Price price, double qty_delta, bool is_bid);
+  void change_qty_order(Price price, Quantity qty_delta, bool is_bid);
   
   bool replace_order(Price current_price,
                      Price new_price,
@@ -78,8 +85,8 @@ private:
 };
 
 
-template <int SIZE> 
-Depth<SIZE>::Depth()
+template <int SIZE, class Price, class Quantity>
+Depth<SIZE, Price, Quantity>::Depth()
 : last_change_(0),
   last_published_change_(0),
   skip_bid_fill_(0),
@@ -88,72 +95,72 @@ Depth<SIZE>::Depth()
   memset(levels_, 0, sizeof(DepthLevel) * SIZE * 2);
 }
 
-template <int SIZE> 
-inline const DepthLevel* 
-Depth<SIZE>::bids() const
+template <int SIZE, class Price, class Quantity>
+inline const typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::bids() const
 {
   return levels_;
 }
 
-template <int SIZE> 
-inline const DepthLevel* 
-Depth<SIZE>::asks() const
+template <int SIZE, class Price, class Quantity>
+inline const typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::asks() const
 {
   return levels_ + SIZE;
 }
 
-template <int SIZE> 
-inline const DepthLevel*
-Depth<SIZE>::last_bid() const
+template <int SIZE, class Price, class Quantity>
+inline const typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::last_bid() const
 {
   return levels_ + (SIZE - 1);
 }
 
-template <int SIZE> 
-inline const DepthLevel*
-Depth<SIZE>::last_ask() const
+template <int SIZE, class Price, class Quantity>
+inline const typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::last_ask() const
 {
   return levels_ + (SIZE * 2 - 1);
 }
 
-template <int SIZE> 
-inline const DepthLevel* 
-Depth<SIZE>::end() const
+template <int SIZE, class Price, class Quantity>
+inline const typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::end() const
 {
   return levels_ + (SIZE * 2);
 }
 
-template <int SIZE> 
-inline DepthLevel* 
-Depth<SIZE>::bids()
+template <int SIZE, class Price, class Quantity>
+inline typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::bids()
 {
   return levels_;
 }
 
-template <int SIZE> 
-inline DepthLevel* 
-Depth<SIZE>::asks()
+template <int SIZE, class Price, class Quantity>
+inline typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::asks()
 {
   return levels_ + SIZE;
 }
 
-template <int SIZE> 
-inline DepthLevel*
-Depth<SIZE>::last_bid()
+template <int SIZE, class Price, class Quantity>
+inline typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::last_bid()
 {
   return levels_ + (SIZE - 1);
 }
 
-template <int SIZE> 
-inline DepthLevel*
-Depth<SIZE>::last_ask()
+template <int SIZE, class Price, class Quantity>
+inline typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::last_ask()
 {
   return levels_ + (SIZE * 2 - 1);
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline void
-Depth<SIZE>::add_order(Price price, Quantity qty, bool is_bid)
+Depth<SIZE, Price, Quantity>::add_order(Price price, Quantity qty, bool is_bid)
 {
   ChangeId last_change_copy = last_change_;
   DepthLevel* level = find_level(price, is_bid);
@@ -166,9 +173,9 @@ Depth<SIZE>::add_order(Price price, Quantity qty, bool is_bid)
   }
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline void
-Depth<SIZE>::skip_fill(Quantity qty, bool is_bid)
+Depth<SIZE, Price, Quantity>::skip_fill(Quantity qty, bool is_bid)
 {
   if(is_bid) {
     if(skip_bid_fill_) {
@@ -187,9 +194,9 @@ Depth<SIZE>::skip_fill(Quantity qty, bool is_bid)
   }
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline void
-Depth<SIZE>::fill_order(
+Depth<SIZE, Price, Quantity>::fill_order(
   Price price, 
   Quantity fill_qty, 
   bool filled,
@@ -208,9 +215,9 @@ Depth<SIZE>::fill_order(
   }
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline bool
-Depth<SIZE>::close_order(Price price, Quantity open_qty, bool is_bid)
+Depth<SIZE, Price, Quantity>::close_order(Price price, Quantity open_qty, bool is_bid)
 {
   DepthLevel* level = find_level(price, is_bid, false);
   if(level) {
@@ -225,9 +232,9 @@ Depth<SIZE>::close_order(Price price, Quantity open_qty, bool is_bid)
   return false;
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline void
-Depth<SIZE>::change_qty_order(Price price, double qty_delta, bool is_bid)
+Depth<SIZE, Price, Quantity>::change_qty_order(Price price, Quantity qty_delta, bool is_bid)
 {
   DepthLevel* level = find_level(price, is_bid, false);
   if(level && qty_delta) {
@@ -241,9 +248,9 @@ Depth<SIZE>::change_qty_order(Price price, double qty_delta, bool is_bid)
   }
 }
  
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 inline bool
-Depth<SIZE>::replace_order(
+Depth<SIZE, Price, Quantity>::replace_order(
   Price current_price,
   Price new_price,
   Quantity current_qty_on_book,
@@ -260,9 +267,9 @@ Depth<SIZE>::replace_order(
   return erased;
 }
 
-template <int SIZE> 
-DepthLevel*
-Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
+template <int SIZE, class Price, class Quantity>
+typename Depth<SIZE, Price, Quantity>::DepthLevel*
+Depth<SIZE, Price, Quantity>::find_level(Price price, bool is_bid, bool should_create)
 {
   DepthLevel* level = is_bid ? bids() : asks();
   const DepthLevel* past_end = is_bid ? asks() : end();
@@ -283,27 +290,27 @@ Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
 
   if(level == past_end) {
     if(is_bid) {
-      BidLevelMap::iterator find_result = hidden_bid_levels_.find(price);
+      typename BidLevelMap::iterator find_result = hidden_bid_levels_.find(price);
 
       if(find_result != hidden_bid_levels_.end()) {
         level = &find_result->second;
       } else if(should_create) {
         DepthLevel new_level;
         new_level.init(price, true);
-        std::pair<BidLevelMap::iterator, bool> insert_result;
+        std::pair<typename BidLevelMap::iterator, bool> insert_result;
         insert_result = hidden_bid_levels_.insert(
             std::make_pair(price, new_level));
         level = &insert_result.first->second;
       }
     } else {
-      AskLevelMap::iterator find_result = hidden_ask_levels_.find(price);
+      typename AskLevelMap::iterator find_result = hidden_ask_levels_.find(price);
 
       if(find_result != hidden_ask_levels_.end()) {
         level = &find_result->second;
       } else if(should_create) {
         DepthLevel new_level;
         new_level.init(price, true);
-        std::pair<AskLevelMap::iterator, bool> insert_result;
+        std::pair<typename AskLevelMap::iterator, bool> insert_result;
         insert_result = hidden_ask_levels_.insert(
             std::make_pair(price, new_level));
         level = &insert_result.first->second;
@@ -313,9 +320,9 @@ Depth<SIZE>::find_level(Price price, bool is_bid, bool should_create)
   return level;
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 void
-Depth<SIZE>::insert_before(DepthLevel* level, bool is_bid, Price price)
+Depth<SIZE, Price, Quantity>::insert_before(DepthLevel* level, bool is_bid, Price price)
 {
   DepthLevel* last_side_level = is_bid ? last_bid() : last_ask();
 
@@ -346,9 +353,9 @@ Depth<SIZE>::insert_before(DepthLevel* level, bool is_bid, Price price)
    level->init(price, false);
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 void
-Depth<SIZE>::erase_level(DepthLevel* level, bool is_bid)
+Depth<SIZE, Price, Quantity>::erase_level(DepthLevel* level, bool is_bid)
 {
   if(level->is_hidden()) {
     if(is_bid) {
@@ -373,7 +380,7 @@ Depth<SIZE>::erase_level(DepthLevel* level, bool is_bid)
     if((level == last_side_level) ||
         (last_side_level->price() != INVALID_PRICE)) {
       if(is_bid) {
-        BidLevelMap::iterator best_bid = hidden_bid_levels_.begin();
+        typename BidLevelMap::iterator best_bid = hidden_bid_levels_.begin();
         if(best_bid != hidden_bid_levels_.end()) {
           *last_side_level = best_bid->second;
           hidden_bid_levels_.erase(best_bid);
@@ -382,7 +389,7 @@ Depth<SIZE>::erase_level(DepthLevel* level, bool is_bid)
           last_side_level->last_change(last_change_);
         }
       } else {
-        AskLevelMap::iterator best_ask = hidden_ask_levels_.begin();
+        typename AskLevelMap::iterator best_ask = hidden_ask_levels_.begin();
         if(best_ask != hidden_ask_levels_.end()) {
           *last_side_level = best_ask->second;
           hidden_ask_levels_.erase(best_ask);
@@ -396,32 +403,32 @@ Depth<SIZE>::erase_level(DepthLevel* level, bool is_bid)
   }
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 bool
-Depth<SIZE>::changed() const
+Depth<SIZE, Price, Quantity>::changed() const
 {
   return last_change_ > last_published_change_;
 }
 
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 ChangeId
-Depth<SIZE>::last_change() const
+Depth<SIZE, Price, Quantity>::last_change() const
 {
   return last_change_;
 }
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 ChangeId
-Depth<SIZE>::last_published_change() const
+Depth<SIZE, Price, Quantity>::last_published_change() const
 {
   return last_published_change_;
 }
 
 
-template <int SIZE> 
+template <int SIZE, class Price, class Quantity>
 void
-Depth<SIZE>::published()
+Depth<SIZE, Price, Quantity>::published()
 {
   last_published_change_ = last_change_;
 }
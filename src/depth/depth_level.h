@@ -6,11 +6,17 @@
 namespace depth {
 using namespace book;
 
-class DepthLevel {
+/**
+ * \brief aggregate of the orders at one price. Price and Quantity are
+ *  double, or ticks and lots for books using fixed-point trackers
+ */
+
+template <class Price, class Quantity>
+class BasicDepthLevel {
 public:
-  DepthLevel();
+  BasicDepthLevel();
 
-  DepthLevel& operator=(const DepthLevel& rhs);
+  BasicDepthLevel& operator=(const BasicDepthLevel& rhs);
   const Price& price() const;
   uint32_t order_count() const;
   Quantity aggregate_qty() const;
@@ -41,23 +47,28 @@ public:
   ChangeId last_change_;
 };
 
+typedef BasicDepthLevel<Price, Quantity> DepthLevel;
+
+template <class Price, class Quantity>
 inline bool
-DepthLevel::changed_since(ChangeId last_published_change) const
+BasicDepthLevel<Price, Quantity>::changed_since(ChangeId last_published_change) const
 {
   return last_change_ > last_published_change;
 }
 
+template <class Price, class Quantity>
 inline
-DepthLevel::DepthLevel()
+BasicDepthLevel<Price, Quantity>::BasicDepthLevel()
   : price_(INVALID_PRICE),
   order_count_(0),
   aggregate_qty_(0)
 {
 }
 
+template <class Price, class Quantity>
 inline
-DepthLevel&
-DepthLevel::operator=(const DepthLevel& rhs)
+BasicDepthLevel<Price, Quantity>&
+BasicDepthLevel<Price, Quantity>::operator=(const BasicDepthLevel& rhs)
 {
   price_ = rhs.price_;
   order_count_ = rhs.order_count_;
@@ -69,16 +80,18 @@ DepthLevel::operator=(const DepthLevel& rhs)
   return *this;
 }
 
+template <class Price, class Quantity>
 inline
 const Price&
-DepthLevel::price() const
+BasicDepthLevel<Price, Quantity>::price() const
 {
   return price_;
 }
 
+template <class Price, class Quantity>
 inline
 void
-DepthLevel::init(Price price, bool is_hidden)
+BasicDepthLevel<Price, Quantity>::init(Price price, bool is_hidden)
 {
   price_ = price;
   order_count_ = 0;
@@ -86,31 +99,35 @@ DepthLevel::init(Price price, bool is_hidden)
   is_hidden_ = is_hidden;
 }
 
+template <class Price, class Quantity>
 inline
 uint32_t
-DepthLevel::order_count() const
+BasicDepthLevel<Price, Quantity>::order_count() const
 {
   return order_count_;
 }
 
+template <class Price, class Quantity>
 inline
 Quantity
-DepthLevel::aggregate_qty() const
+BasicDepthLevel<Price, Quantity>::aggregate_qty() const
 {
   return aggregate_qty_;
 }
 
+template <class Price, class Quantity>
 inline
 void
-DepthLevel::add_order(Quantity qty)
+BasicDepthLevel<Price, Quantity>::add_order(Quantity qty)
 {
   ++order_count_;
   aggregate_qty_ += qty;
 }
 
+template <class Price, class Quantity>
 inline
 bool
-DepthLevel::close_order(Quantity qty)
+BasicDepthLevel<Price, Quantity>::close_order(Quantity qty)
 {
   bool empty = false;
   // If this is the last order, reset the level
@@ -131,9 +148,10 @@ DepthLevel::close_order(Quantity qty)
   return empty;
 }
 
+template <class Price, class Quantity>
 inline
 void
-DepthLevel::set(Price price, 
+BasicDepthLevel<Price, Quantity>::set(Price price, 
   Quantity qty,
   uint32_t order_count,
   ChangeId last_change)
@@ -144,16 +162,18 @@ DepthLevel::set(Price price,
   last_change_ = last_change;
 }
 
+template <class Price, class Quantity>
 inline
 void
-DepthLevel::increase_qty(Quantity qty)
+BasicDepthLevel<Price, Quantity>::increase_qty(Quantity qty)
 {
   aggregate_qty_ += qty;
 }
 
+template <class Price, class Quantity>
 inline
 void
-DepthLevel::decrease_qty(Quantity qty)
+BasicDepthLevel<Price, Quantity>::decrease_qty(Quantity qty)
 {
   aggregate_qty_ -= qty;
 }
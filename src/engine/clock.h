@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+#include <book/latency.h>
+
+namespace engine {
+
+/**
+ * \brief clocks of the timer services of an engine, in nanoseconds. a
+ *  clock has
+ *
+ *    uint64_t now();
+ *    static const bool simulated;
+ *
+ *  each shard has a clock of its own, read on its thread only. the time
+ *  of a simulated clock is set by Engine::advance_time(), in order with
+ *  the commands, so that replays and backtests run as fast as the shards
+ *  go and fire the same timers between the same commands.
+ */
+
+/* std::chrono::steady_clock */
+struct MonotonicClock {
+  static const bool simulated = false;
+
+  uint64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+};
+
+/* read_tsc(), scaled to nanoseconds. cheaper to read than
+  MonotonicClock, assumes an invariant TSC */
+class TscClock {
+public:
+  static const bool simulated = false;
+
+  TscClock() : ns_per_tick_(ns_per_tick()) {}
+
+  uint64_t now() const { return (uint64_t) (book::read_tsc() * ns_per_tick_); }
+
+private:
+  /* calibrated once per process */
+  static double ns_per_tick() {
+    static const double value = 1 / book::tsc_ticks_per_ns();
+    return value;
+  }
+
+  double ns_per_tick_;
+};
+
+/* only moves when set, see Engine::advance_time() */
+class SimulatedClock {
+public:
+  static const bool simulated = true;
+
+  SimulatedClock() : now_(0) {}
+
+  uint64_t now() const { return now_; }
+
+  /* time does not go back */
+  void set(uint64_t now) {
+    if(now > now_)
+      now_ = now;
+  }
+
+private:
+  uint64_t now_;
+};
+
+}
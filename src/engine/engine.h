@@ -0,0 +1,647 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <book/ob.h>
+#include <book/latency.h>
+#include <book/types.h>
+
+#include "spsc_queue.h"
+#include "clock.h"
+#include "timer_service.h"
+
+namespace engine {
+
+enum CommandType : uint8_t {
+  command_add,
+  command_cancel,
+  command_replace,
+  command_market_price,
+  command_release,    /* the shard hands the book over */
+  command_adopt,      /* the shard takes the book over */
+  command_time        /* sets the simulated clock of the shard */
+};
+
+/**
+ * \brief an input of a book, as queued to its shard. commands of a
+ *  symbol are numbered by the gateway, `seq` is the number of this one.
+ *  a command_time has no book, and carries the time in `seq`
+ */
+template <class Book, class OrderPtr, class Price, class Qty>
+struct Command {
+  CommandType type;
+  book::CancelReasons reason;
+  Book* book;
+  uint64_t seq;
+  OrderPtr order;
+  Qty qty;
+  Price price;
+};
+
+/* a callback of a book, as published by its shard */
+template <class TypedCallback>
+struct Published {
+  uint32_t symbol_id;
+  TypedCallback callback;
+};
+
+struct EngineConfig {
+  EngineConfig() :
+    shards(1),
+    command_capacity(1 << 16),
+    callback_capacity(1 << 18),
+    publish(true),
+    rebalance_threshold(0.1) {}
+
+  size_t shards;
+  std::vector<int> cores;       /* core of each shard, unpinned if missing */
+  size_t command_capacity;      /* per shard */
+  size_t callback_capacity;     /* per shard */
+  bool publish;                 /* false to only count the callbacks */
+  double rebalance_threshold;   /* imbalance ignored by rebalance(), as a share of the busiest shard */
+};
+
+/* waits without a lock. spins a little, then lets the core go */
+inline void backoff(unsigned& idle) {
+  if(++idle < 64) return;
+  std::this_thread::yield();
+}
+
+inline bool pin_to_core(std::thread& thread, int core) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+  (void) thread;
+  (void) core;
+  return false;
+#endif
+}
+
+/**
+ * \brief books of many symbols, partitioned across shards. each shard
+ *  is a thread, optionally pinned to a core, that runs the commands of
+ *  its symbols from an SPSC queue and publishes their callbacks to an
+ *  outbound SPSC queue.
+ *
+ *    Engine<book::LadderOB<Tracker, Plugins...>> engine(config);
+ *    engine.add_symbol(1);
+ *    engine.start();
+ *    engine.add(1, order);                        // gateway thread
+ *    engine.poll(shard, [](const Engine::Output& out) { ... });
+ *
+ *  symbols move between shards while the engine runs. migrate() queues
+ *  a release after the last command of the symbol sent to its shard and
+ *  an adopt numbered right after it to the new one: the new shard takes
+ *  the book over once the old one has run every command up to that
+ *  barrier, and publishes nothing until the callbacks the old
+ *  one published are polled. no command is lost or reordered, and each
+ *  symbol's callbacks are still polled in order.
+ *
+ *  rebalance() measures the time each shard spent on each symbol since
+ *  it last ran, and moves hot symbols from the busiest shard to the
+ *  idlest one.
+ *
+ *  each shard has a Clock (see clock.h) and a TimerService. books ask to
+ *  be woken at a time with OB::wake_at(), e.g. ExpiryPlugin for its next
+ *  expiry, and the shard wakes them in batches between commands once its
+ *  clock gets there, or before a command of the book that finds it due.
+ *  only then does the time of a book move (OB::advance_time(), journaled),
+ *  so that plugins reading OB::now() in a command see the time of its
+ *  last wake. with a SimulatedClock, time moves only with advance_time(),
+ *  in order with the commands.
+ *
+ *  a command or a wake that throws fails its symbol, not the shard: the
+ *  book is left as the exception left it, so the shard runs no more of
+ *  its commands and drops its timer. Book::failed() tells which symbols
+ *  failed, Shard::failures() how many did, while the engine runs.
+ *
+ *  OB is the book type without its on_callbacks(), which the engine
+ *  implements. add(), cancel(), replace(), set_market_price(),
+ *  migrate() and rebalance() are called from a single thread. poll()
+ *  is called from at most one thread per shard, and must keep going
+ *  while symbols migrate. symbols are added and books accessed while
+ *  the engine is stopped.
+ */
+
+template <class OB, class Clock = MonotonicClock>
+class Engine {
+public:
+  typedef typename OB::OrderPtr OrderPtr;
+  typedef typename OB::Price Price;
+  typedef typename OB::Qty Qty;
+  typedef typename OB::TypedCallback TypedCallback;
+  typedef Published<TypedCallback> Output;
+
+  class Shard;
+
+  class Book : public OB {
+  public:
+    Book(uint32_t symbol_id, Shard* shard, const book::TickScale& scale, size_t capacity) :
+      OB(symbol_id, scale, capacity),
+      shard_(shard), seq_(0), barrier_(0), handoff_mark_(0), busy_(0), failed_(false),
+      wake_time_(TimerService<Book>::never), wake_timer_(TimerService<Book>::Wheel::npos) {}
+
+    /* written by the shard that owns the book */
+    Shard* shard() const { return shard_; }
+    uint64_t seq() const { return seq_; }
+
+    /* read_tsc() ticks spent on the book's commands, readable from any thread */
+    uint64_t busy() const { return busy_.load(std::memory_order_relaxed); }
+
+    /* a command or a wake of the book threw, see Shard::failures() */
+    bool failed() const { return failed_; }
+
+    /* the wakes of the TimerService of the shard land here */
+    void advance_time(uint64_t now) {
+      try {
+        OB::advance_time(now);
+      }
+      catch(...) {
+        shard_->fail(*this);
+      }
+    }
+
+  protected:
+    void on_callbacks(const typename OB::Callbacks& callbacks) {
+      shard_->publish(this->symbol_id(), callbacks);
+    }
+
+    void wake_at(uint64_t deadline) {
+      shard_->timers_.schedule(*this, deadline);
+    }
+
+  private:
+    friend class Shard;
+    friend class TimerService<Book>;
+
+    Shard* shard_;
+    uint64_t seq_;   /* last command run */
+
+    /* seq of the last release run, and the outbound queue position of
+      the old shard when it ran */
+    std::atomic<uint64_t> barrier_;
+    size_t handoff_mark_;
+
+    std::atomic<uint64_t> busy_;
+    bool failed_;
+
+    /* timer of the book in the TimerService of its shard */
+    uint64_t wake_time_;
+    typename TimerService<Book>::Handle wake_timer_;
+  };
+
+  typedef engine::Command<Book, OrderPtr, Price, Qty> Command;
+
+  class Shard {
+  public:
+    Shard(const EngineConfig& config) :
+      commands(config.command_capacity),
+      callbacks(config.callback_capacity),
+      publish_(config.publish),
+      processed_(0),
+      published_(0),
+      stalls_(0),
+      migrations_(0),
+      wakes_(0),
+      failures_(0),
+      timers_(clock_.now()) {}
+
+    SpscQueue<Command> commands;
+    SpscQueue<Output> callbacks;
+
+    /* commands run and callbacks published, readable from any thread */
+    uint64_t processed() const { return processed_.load(std::memory_order_relaxed); }
+    uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+
+    /* times the outbound queue was full */
+    uint64_t stalls() const { return stalls_.load(std::memory_order_relaxed); }
+
+    /* books taken over from another shard */
+    uint64_t migrations() const { return migrations_.load(std::memory_order_relaxed); }
+
+    /* books woken by the timer service */
+    uint64_t wakes() const { return wakes_.load(std::memory_order_relaxed); }
+
+    /* books failed by a command or a wake that threw */
+    uint64_t failures() const { return failures_.load(std::memory_order_relaxed); }
+
+    void publish(uint32_t symbol_id, const typename OB::Callbacks& cbs) {
+      published_.store(published() + cbs.size(), std::memory_order_relaxed);
+      if(!publish_) return;
+
+      for(auto it = cbs.begin(); it != cbs.end(); ++it) {
+        Output output = { symbol_id, *it };
+
+        if(callbacks.try_push(output)) continue;
+
+        stalls_.store(stalls() + 1, std::memory_order_relaxed);
+        unsigned idle = 0;
+        while(!callbacks.try_push(output))
+          backoff(idle);
+      }
+    }
+
+    void execute(Command& command) {
+      if(command.type == command_time) {
+        set_time(command.seq, std::integral_constant<bool, Clock::simulated>());
+        fire_timers();
+        processed_.store(processed() + 1, std::memory_order_relaxed);
+        return;
+      }
+
+      Book& book = *command.book;
+
+      if(command.type == command_adopt)
+        adopt(book, command.seq - 1);
+
+      uint64_t begin = book::read_tsc();
+
+      /* only moves the time of the book when it has something due, the
+        rest of its hooks and a journal record per command would be waste */
+      uint64_t now = clock_.now();
+      if(now >= book.wake_time_)
+        timers_.wake(book, now);
+
+      if(!book.failed_) {
+        try {
+          switch(command.type) {
+            case command_add: book.add(command.order); break;
+            case command_cancel: book.cancel(command.order, command.reason); break;
+            case command_replace: book.replace(command.order, command.qty); break;
+            case command_market_price: book.set_market_price(command.price); break;
+            default: break;
+          }
+        }
+        catch(...) {
+          fail(book);
+        }
+      }
+
+      book.seq_ = command.seq;
+      book.busy_.store(book.busy() + book::read_tsc() - begin, std::memory_order_relaxed);
+
+      /* the book belongs to the new shard from here on */
+      if(command.type == command_release) {
+        timers_.remove(book);
+        book.handoff_mark_ = callbacks.pushed();
+        book.barrier_.store(command.seq, std::memory_order_release);
+      }
+
+      processed_.store(processed() + 1, std::memory_order_relaxed);
+    }
+
+    /* wakes the books due by the clock of the shard, between commands */
+    void fire_timers() {
+      if(timers_.empty()) return;
+
+      size_t woken = timers_.fire(clock_.now());
+      if(woken)
+        wakes_.store(wakes() + woken, std::memory_order_relaxed);
+    }
+
+  private:
+    friend class Book;
+
+    /* the book keeps running its releases and adopts, and nothing else */
+    void fail(Book& book) {
+      if(book.failed_) return;
+
+      book.failed_ = true;
+      timers_.remove(book);
+      book.wake_time_ = TimerService<Book>::never;
+      failures_.store(failures() + 1, std::memory_order_relaxed);
+    }
+
+    void set_time(uint64_t now, std::true_type) { clock_.set(now); }
+    void set_time(uint64_t, std::false_type) {}
+
+    /* waits for the old shard to run the release numbered `barrier`,
+      then for its callbacks of the book to be polled */
+    void adopt(Book& book, uint64_t barrier) {
+      unsigned idle = 0;
+      while(book.barrier_.load(std::memory_order_acquire) != barrier)
+        backoff(idle);
+
+      if(publish_)
+        while(book.shard_->callbacks.popped() < book.handoff_mark_)
+          backoff(idle);
+
+      book.shard_ = this;
+      timers_.restore(book);
+      migrations_.store(migrations() + 1, std::memory_order_relaxed);
+    }
+
+    bool publish_;
+    std::atomic<uint64_t> processed_;
+    std::atomic<uint64_t> published_;
+    std::atomic<uint64_t> stalls_;
+    std::atomic<uint64_t> migrations_;
+    std::atomic<uint64_t> wakes_;
+    std::atomic<uint64_t> failures_;
+
+    Clock clock_;
+    TimerService<Book> timers_;
+  };
+
+  explicit Engine(const EngineConfig& config = EngineConfig()) :
+    config_(config), running_(false), stop_(false), submit_stalls_(0)
+  {
+    if(config.shards == 0)
+      throw std::invalid_argument("an engine needs a shard");
+
+    for(size_t i = 0; i < config.shards; ++i)
+      shards_.emplace_back(new Shard(config));
+  }
+
+  ~Engine() { stop(); }
+
+  Engine(const Engine&) = delete;
+  Engine& operator=(const Engine&) = delete;
+
+  /* symbols go to the shards in turn, each with the ticks and lots of its
+    own market */
+  void add_symbol(uint32_t symbol_id, size_t capacity = 0,
+    const book::TickScale& scale = book::TickScale())
+  {
+    if(running_)
+      throw std::logic_error("symbols are added while the engine is stopped");
+
+    if(routes_.count(symbol_id))
+      throw std::invalid_argument("symbol added twice");
+
+    uint32_t shard = (uint32_t) (books_.size() % shards_.size());
+    books_.emplace_back(new Book(symbol_id, shards_[shard].get(), scale, capacity));
+
+    Route route = { books_.back().get(), shard, 0, 0 };
+    routes_.emplace(symbol_id, route);
+  }
+
+  void start() {
+    if(running_) return;
+
+    stop_.store(false, std::memory_order_release);
+    running_ = true;
+
+    for(size_t i = 0; i < shards_.size(); ++i) {
+      threads_.emplace_back(&Engine::run, this, shards_[i].get());
+      if(i < config_.cores.size())
+        pin_to_core(threads_.back(), config_.cores[i]);
+    }
+  }
+
+  /* returns once every command submitted has run */
+  void stop() {
+    if(!running_) return;
+
+    stop_.store(true, std::memory_order_release);
+    for(auto it = threads_.begin(); it != threads_.end(); ++it)
+      it->join();
+
+    threads_.clear();
+    running_ = false;
+  }
+
+  bool add(uint32_t symbol_id, const OrderPtr& order) {
+    return submit(symbol_id, command_add, book::dont_cancel, order, Qty(), Price());
+  }
+
+  bool cancel(uint32_t symbol_id, const OrderPtr& order,
+    book::CancelReasons reason = book::user_cancel)
+  {
+    return submit(symbol_id, command_cancel, reason, order, Qty(), Price());
+  }
+
+  bool replace(uint32_t symbol_id, const OrderPtr& order, Qty delta) {
+    return submit(symbol_id, command_replace, book::dont_cancel, order, delta, Price());
+  }
+
+  bool set_market_price(uint32_t symbol_id, Price price) {
+    return submit(symbol_id, command_market_price, book::dont_cancel, OrderPtr(), Qty(), price);
+  }
+
+  /* moves the simulated clock of every shard to `now`. the commands
+    submitted before run at the earlier time */
+  void advance_time(uint64_t now) {
+    static_assert(Clock::simulated, "only a simulated clock is advanced");
+
+    for(auto it = shards_.begin(); it != shards_.end(); ++it) {
+      Command command = { command_time, book::dont_cancel, nullptr,
+        now, OrderPtr(), Qty(), Price() };
+      push((*it)->commands, command);
+    }
+  }
+
+  /**
+   * \brief moves a symbol to `shard`. commands submitted after it run
+   *  on the new shard once the old one is done with the earlier ones
+   * \return false if the symbol is unknown or already on `shard`
+   */
+  bool migrate(uint32_t symbol_id, size_t shard) {
+    auto it = routes_.find(symbol_id);
+    if(it == routes_.end() || it->second.shard == shard || shard >= shards_.size())
+      return false;
+
+    Route& route = it->second;
+    Command command = { command_release, book::dont_cancel, route.book,
+      ++route.seq, OrderPtr(), Qty(), Price() };
+
+    push(shards_[route.shard]->commands, command);
+
+    command.type = command_adopt;
+    command.seq = ++route.seq;
+    push(shards_[shard]->commands, command);
+
+    route.shard = (uint32_t) shard;
+    return true;
+  }
+
+  /**
+   * \brief moves up to `max_moves` symbols from the busiest shard to the
+   *  idlest one, by the time spent on each symbol since the last call.
+   *  a symbol moves only if it narrows the gap between the two shards
+   * \return the number of symbols moved
+   */
+  size_t rebalance(size_t max_moves = 1) {
+    std::vector<uint64_t> shard_load(shards_.size(), 0);
+    std::vector<std::pair<Route*, uint64_t>> loads;
+    loads.reserve(routes_.size());
+
+    for(auto it = routes_.begin(); it != routes_.end(); ++it) {
+      Route& route = it->second;
+      uint64_t busy = route.book->busy();
+      uint64_t load = busy - route.busy;
+
+      route.busy = busy;
+      shard_load[route.shard] += load;
+      loads.push_back(std::make_pair(&route, load));
+    }
+
+    size_t moves = 0;
+
+    while(moves < max_moves) {
+      size_t hi = 0, lo = 0;
+      for(size_t i = 1; i < shard_load.size(); ++i) {
+        if(shard_load[i] > shard_load[hi]) hi = i;
+        if(shard_load[i] < shard_load[lo]) lo = i;
+      }
+
+      uint64_t gap = shard_load[hi] - shard_load[lo];
+      if(hi == lo || gap == 0 || gap <= config_.rebalance_threshold * shard_load[hi])
+        break;
+
+      /* the hottest symbol of the busiest shard lighter than the gap */
+      std::pair<Route*, uint64_t>* best = nullptr;
+      for(auto it = loads.begin(); it != loads.end(); ++it)
+        if(it->first->shard == hi && it->second > 0 && it->second < gap &&
+          (!best || it->second > best->second))
+          best = &*it;
+
+      if(!best) break;
+
+      migrate(best->first->book->symbol_id(), lo);
+      shard_load[hi] -= best->second;
+      shard_load[lo] += best->second;
+      ++moves;
+    }
+
+    return moves;
+  }
+
+  /**
+   * \brief hands the callbacks published by `shard` to `fn`, up to `max`
+   * \return the number of callbacks handed
+   */
+  template <class Fn>
+  size_t poll(size_t shard, Fn&& fn, size_t max = SIZE_MAX) {
+    Output output;
+    size_t n = 0;
+
+    while(n < max && shards_[shard]->callbacks.try_pop(output)) {
+      fn(output);
+      ++n;
+    }
+
+    return n;
+  }
+
+  size_t shard_count() const { return shards_.size(); }
+  const Shard& shard(size_t i) const { return *shards_[i]; }
+
+  /* shard the next command of a symbol goes to, -1 if unknown */
+  int shard_of(uint32_t symbol_id) const {
+    auto it = routes_.find(symbol_id);
+    return it == routes_.end() ? -1 : (int) it->second.shard;
+  }
+
+  /* while stopped */
+  Book& book(uint32_t symbol_id) {
+    return *routes_.at(symbol_id).book;
+  }
+
+  /* times a command queue was full */
+  uint64_t submit_stalls() const { return submit_stalls_; }
+
+  bool running() const { return running_; }
+
+private:
+  /* where the gateway sends the commands of a symbol */
+  struct Route {
+    Book* book;
+    uint32_t shard;
+    uint64_t seq;    /* last command sent */
+    uint64_t busy;   /* Book::busy() at the last rebalance() */
+  };
+
+  /* false if the symbol is unknown */
+  bool submit(uint32_t symbol_id, CommandType type, book::CancelReasons reason,
+    const OrderPtr& order, Qty qty, Price price)
+  {
+    auto it = routes_.find(symbol_id);
+    if(it == routes_.end()) return false;
+
+    Route& route = it->second;
+    Command command = { type, reason, route.book, ++route.seq, order, qty, price };
+
+    push(shards_[route.shard]->commands, command);
+    return true;
+  }
+
+  void push(SpscQueue<Command>& commands, Command& command) {
+    if(commands.try_push(command)) return;
+
+    ++submit_stalls_;
+    unsigned idle = 0;
+    while(!commands.try_push(command))
+      backoff(idle);
+  }
+
+  void run(Shard* shard) {
+    Command command;
+    unsigned idle = 0;
+
+    for(;;) {
+      if(shard->commands.try_pop(command)) {
+        shard->execute(command);
+        shard->fire_timers();
+        idle = 0;
+        continue;
+      }
+
+      shard->fire_timers();
+
+      /* the queue is empty, and nothing is submitted after stop() */
+      if(stop_.load(std::memory_order_acquire) && shard->commands.empty())
+        break;
+
+      backoff(idle);
+    }
+  }
+
+  EngineConfig config_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::vector<std::unique_ptr<Book>> books_;
+  std::unordered_map<uint32_t, Route> routes_;
+  std::vector<std::thread> threads_;
+  bool running_;
+  std::atomic<bool> stop_;
+  uint64_t submit_stalls_;
+};
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+/**
+ * \brief bounded lock-free queue between one producer thread and one
+ *  consumer thread. each side keeps its index on its own cache line,
+ *  and a copy of the other side's index that it only refreshes when the
+ *  queue looks full, or empty
+ */
+
+template <class T>
+class SpscQueue {
+public:
+  /* rounded up to a power of two */
+  explicit SpscQueue(size_t capacity) :
+    slots_(round_up(capacity)),
+    mask_(slots_.size() - 1),
+    head_(0),
+    tail_cache_(0),
+    tail_(0),
+    head_cache_(0) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  /* producer */
+  template <class U>
+  bool try_push(U&& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    if(head - tail_cache_ == slots_.size()) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if(head - tail_cache_ == slots_.size()) return false;
+    }
+
+    slots_[head & mask_] = std::forward<U>(value);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* consumer */
+  bool try_pop(T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if(tail == head_cache_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if(tail == head_cache_) return false;
+    }
+
+    value = std::move(slots_[tail & mask_]);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* exact from either side when the other side is idle */
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /* values ever pushed and popped, readable from any thread */
+  size_t pushed() const { return head_.load(std::memory_order_acquire); }
+  size_t popped() const { return tail_.load(std::memory_order_acquire); }
+  size_t capacity() const { return slots_.size(); }
+
+private:
+  static size_t round_up(size_t n) {
+    size_t size = 2;
+    while(size < n) size <<= 1;
+    return size;
+  }
+
+  /* a cache line of padding keeps each side apart from the other and
+    from whatever is allocated next to the queue. padding rather than
+    alignas(64), which plain new does not honour before C++17 */
+  static const size_t CACHE_LINE = 64;
+
+  std::vector<T> slots_;
+  size_t mask_;
+  char pad0_[CACHE_LINE];
+
+  /* producer */
+  std::atomic<size_t> head_;
+  size_t tail_cache_;
+  char pad1_[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+  /* consumer */
+  std::atomic<size_t> tail_;
+  size_t head_cache_;
+  char pad2_[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+};
+
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#include <book/timer_wheel.h>
+
+namespace engine {
+
+/**
+ * \brief timers of the books of a shard, on a TimerWheel. a book asks to
+ *  be woken with OB::wake_at() and has at most one timer, at the earliest
+ *  time asked for: scheduling an earlier one replaces it, a later one is
+ *  dropped, the book asks again once woken. fire() advances the time of
+ *  the books due in one batch, between two commands of the shard.
+ *
+ *  Book keeps the time and the handle of its timer, which it takes along
+ *  when it moves to another shard (see remove() and restore())
+ */
+
+template <class Book>
+class TimerService {
+public:
+  typedef book::TimerWheel<Book*> Wheel;
+  typedef typename Wheel::Handle Handle;
+
+  /* Book::wake_time_ of a book that asked for nothing */
+  static const uint64_t never = UINT64_MAX;
+
+  explicit TimerService(uint64_t now) : wheel_(nullptr, now) {}
+
+  void schedule(Book& book, uint64_t deadline) {
+    if(book.wake_time_ <= deadline) return;
+
+    if(book.wake_timer_ != Wheel::npos)
+      wheel_.erase(book.wake_timer_);
+
+    book.wake_time_ = deadline;
+    book.wake_timer_ = wheel_.insert(deadline, &book);
+  }
+
+  /* the book leaves the shard, its timer goes with it */
+  void remove(Book& book) {
+    if(book.wake_timer_ == Wheel::npos) return;
+
+    wheel_.erase(book.wake_timer_);
+    book.wake_timer_ = Wheel::npos;
+  }
+
+  /* wakes the book ahead of the shard's batch, e.g. before a command
+    that finds its time due */
+  void wake(Book& book, uint64_t now) {
+    remove(book);
+    book.wake_time_ = never;
+    book.advance_time(now);
+  }
+
+  /* the book joins the shard */
+  void restore(Book& book) {
+    if(book.wake_time_ != never)
+      book.wake_timer_ = wheel_.insert(book.wake_time_, &book);
+  }
+
+  /**
+   * \brief wakes the books whose time is `now` or earlier, earliest
+   *  first. books may ask for another timer while woken
+   * \return the number of books woken
+   */
+  size_t fire(uint64_t now) {
+    if(now < wheel_.next_tick())
+      return 0;
+
+    wheel_.advance(now, [this](Book*& book, uint64_t) { due_.push_back(book); });
+
+    for(auto it = due_.begin(); it != due_.end(); ++it) {
+      (*it)->wake_timer_ = Wheel::npos;
+      (*it)->wake_time_ = never;
+      (*it)->advance_time(now);
+    }
+
+    size_t woken = due_.size();
+    due_.clear();
+    return woken;
+  }
+
+  /* books waiting to be woken */
+  size_t size() const { return wheel_.size(); }
+  bool empty() const { return wheel_.empty(); }
+
+private:
+  Wheel wheel_;
+  std::vector<Book*> due_;
+};
+
+template <class Book>
+const uint64_t TimerService<Book>::never;
+
+}
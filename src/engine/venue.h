@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+#include <book/ob.h>
+#include <book/timer_wheel.h>
+#include <book/types.h>
+
+#include "spsc_queue.h"
+#include "clock.h"
+
+namespace engine {
+
+/* the answer of a venue to a routing request */
+template <class Qty>
+struct VenueResponse {
+  uint64_t request_id;
+  Qty qty;          /* of the request */
+  Qty filled_qty;   /* 0 if it failed, qty if it succeeded */
+
+  bool succeeded() const { return !(filled_qty < qty); }
+  bool failed() const { return !(filled_qty > Qty()); }
+};
+
+struct VenueConfig {
+  VenueConfig() :
+    latency(20000),
+    jitter(0),
+    reject_rate(0),
+    queue_capacity(1 << 16),
+    seed(1) {}
+
+  uint64_t latency;         /* least delay of a response, in the time of run() */
+  uint64_t jitter;          /* mean of an exponential delay added to it, 0 for none */
+  double reject_rate;       /* share of the requests failed without matching */
+  size_t queue_capacity;    /* of the request and the response queues */
+  uint64_t seed;            /* of the delays and the rejects */
+};
+
+/**
+ * \brief an external exchange, simulated in process on a book of its
+ *  own, to route to without a network. routing requests come in over an
+ *  SPSC queue, and each one is matched on arrival against the liquidity
+ *  of the venue's book as an immediate or cancel order. the response, a
+ *  fill of all, part or none of the request, goes back over another SPSC
+ *  queue once a delay drawn from the latency of the config has passed.
+ *
+ *    class Venue : public SimulatedVenue<VenueOB, RoutingRequest> {
+ *      OrderPtr make_order(const RoutingRequest& request) { ... }
+ *    };
+ *
+ *    venue.book().add(liquidity);                  // venue thread
+ *    venue.submit(request);                        // from on_routing_request()
+ *    venue.run(now);                               // venue thread, or start()
+ *    venue.poll([&](const Venue::Response& r) { ... });
+ *
+ *  submit() and poll() are called from the thread of the routing book,
+ *  run() from the thread of the venue, which is the one start() makes
+ *  with a real Clock. with a SimulatedClock, the caller runs the venue
+ *  at the time of its choosing, e.g. in a single thread.
+ *
+ *  OB is the book type of the venue without its on_callbacks(), Request
+ *  has request_id, qty, price and is_bid (see BasicRoutingRequest).
+ */
+
+template <class OB, class Request, class Clock = MonotonicClock>
+class SimulatedVenue {
+public:
+  typedef typename OB::OrderPtr OrderPtr;
+  typedef typename OB::Price Price;
+  typedef typename OB::Qty Qty;
+  typedef VenueResponse<Qty> Response;
+
+  class Book : public OB {
+  public:
+    Book(uint32_t symbol_id, size_t capacity) :
+      OB(symbol_id, book::TickScale(), capacity), taker_(nullptr), filled_qty_() {}
+
+  protected:
+    /* fills of the request being matched, the rest is not published */
+    void on_callbacks(const typename OB::Callbacks& callbacks) {
+      if(!taker_) return;
+
+      for(auto it = callbacks.begin(); it != callbacks.end(); ++it)
+        if(it->type == OB::TypedCallback::cb_trade && it->order == *taker_)
+          filled_qty_ += it->qty;
+    }
+
+  private:
+    friend class SimulatedVenue;
+
+    const OrderPtr* taker_;
+    Qty filled_qty_;
+  };
+
+  explicit SimulatedVenue(const VenueConfig& config = VenueConfig(),
+    uint32_t symbol_id = 1, size_t capacity = 0) :
+    config_(config),
+    book_(symbol_id, capacity),
+    requests_(config.queue_capacity),
+    responses_(config.queue_capacity),
+    delays_(nullptr, clock_.now()),
+    rng_(config.seed),
+    jitter_(config.jitter ? 1.0 / config.jitter : 1.0),
+    matched_(0),
+    running_(false),
+    stop_(false) {}
+
+  virtual ~SimulatedVenue() { stop(); }
+
+  SimulatedVenue(const SimulatedVenue&) = delete;
+  SimulatedVenue& operator=(const SimulatedVenue&) = delete;
+
+  /* router side. false if the request queue is full */
+  bool submit(const Request& request) { return requests_.try_push(request); }
+
+  /**
+   * \brief hands the responses due to `fn`, up to `max`. router side
+   * \return the number of responses handed
+   */
+  template <class Fn>
+  size_t poll(Fn&& fn, size_t max = SIZE_MAX) {
+    Response response;
+    size_t n = 0;
+
+    while(n < max && responses_.try_pop(response)) {
+      fn(response);
+      ++n;
+    }
+
+    return n;
+  }
+
+  /**
+   * \brief matches the requests received, and sends the responses due
+   *  by `now`. venue side
+   * \return the number of responses sent
+   */
+  size_t run(uint64_t now) {
+    /* an idle wheel jumps to `now` at no cost, so that it never walks up
+      from a time long gone, e.g. a caller's clock that starts late */
+    if(delays_.empty())
+      delays_.advance(now, [](Response&, uint64_t) {});
+
+    Request request;
+    while(requests_.try_pop(request)) {
+      Response response = match(request);
+      uint64_t due = now + delay();
+
+      /* the wheel only fires after its time */
+      if(due > delays_.now()) delays_.insert(due, response);
+      else due_.push_back(response);
+      matched_.store(matched() + 1, std::memory_order_relaxed);
+    }
+
+    delays_.advance(now, [this](Response& response, uint64_t) {
+      due_.push_back(response);
+    });
+
+    /* what does not fit waits for the next run */
+    size_t sent = 0;
+    while(sent < due_.size() && responses_.try_push(due_[sent]))
+      ++sent;
+
+    due_.erase(due_.begin(), due_.begin() + sent);
+    return sent;
+  }
+
+  /* runs the venue on a thread of its own, on the clock of the venue */
+  void start() {
+    static_assert(!Clock::simulated, "a simulated venue is run by its caller");
+    if(running_) return;
+
+    stop_.store(false, std::memory_order_release);
+    running_ = true;
+    thread_ = std::thread([this]() {
+      unsigned idle = 0;
+      while(!stop_.load(std::memory_order_acquire)) {
+        if(run(clock_.now()) == 0) {
+          if(++idle >= 64) std::this_thread::yield();
+        }
+        else idle = 0;
+      }
+    });
+  }
+
+  void stop() {
+    if(!running_) return;
+
+    stop_.store(true, std::memory_order_release);
+    thread_.join();
+    running_ = false;
+  }
+
+  /* the liquidity of the venue, set up while it is not running */
+  Book& book() { return book_; }
+
+  /* requests matched, readable from any thread */
+  uint64_t matched() const { return matched_.load(std::memory_order_relaxed); }
+
+  /* responses waiting for their delay, venue side */
+  size_t in_flight() const { return delays_.size() + due_.size(); }
+
+protected:
+  /* the order a request is matched as, on the book of the venue */
+  virtual OrderPtr make_order(const Request& request) = 0;
+
+private:
+  Response match(const Request& request) {
+    Response response = { request.request_id, request.qty, Qty() };
+
+    if(config_.reject_rate > 0 && std::uniform_real_distribution<double>()(rng_) < config_.reject_rate)
+      return response;
+
+    OrderPtr order = make_order(request);
+
+    book_.taker_ = &order;
+    book_.filled_qty_ = Qty();
+
+    /* immediate or cancel, what is left does not rest */
+    book_.add(order);
+    book_.cancel(order, book::immediate_or_cancel);
+
+    book_.taker_ = nullptr;
+    response.filled_qty = book_.filled_qty_;
+    return response;
+  }
+
+  uint64_t delay() {
+    if(!config_.jitter) return config_.latency;
+    return config_.latency + (uint64_t) std::exponential_distribution<double>(jitter_)(rng_);
+  }
+
+  VenueConfig config_;
+  /* before delays_, which starts at its time */
+  Clock clock_;
+  Book book_;
+
+  SpscQueue<Request> requests_;
+  SpscQueue<Response> responses_;
+
+  /* responses by the time they are due */
+  book::TimerWheel<Response> delays_;
+  std::vector<Response> due_;
+
+  std::mt19937_64 rng_;
+  double jitter_;
+  std::atomic<uint64_t> matched_;
+
+  std::thread thread_;
+  bool running_;
+  std::atomic<bool> stop_;
+};
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace flow {
+
+enum EventType : uint8_t {
+  event_add,
+  event_cancel,
+  event_replace
+};
+
+/**
+ * \brief one instruction of an order stream. order ids are assigned in
+ *  sequence by the generator from 0, cancels and replaces refer to the
+ *  id of an earlier add
+ */
+
+struct Event {
+  EventType type;
+  bool is_bid;
+  bool reduce_only;
+  uint32_t user_id;
+  uint64_t order_id;
+  uint64_t ts;        /* arrival time, ns since the start of the stream */
+  double price;       /* 0 for market orders */
+  double qty;         /* qty delta of replaces */
+  double stop_price;  /* 0 unless a stop order */
+};
+
+}
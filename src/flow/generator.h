@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <stdint.h>
+
+#include "event.h"
+
+namespace flow {
+
+/**
+ * \brief random numbers of the generator. xoshiro256** seeded with
+ *  splitmix64, and distributions written out rather than taken from
+ *  <random>, whose distributions differ between standard libraries.
+ *  the same seed gives the same integers and uniforms everywhere. the
+ *  other distributions, and the arrivals and prices built on them, go
+ *  through log1p, exp and pow, whose last bits may differ between libm
+ *  versions: a stream is only replayed exactly with the same platform
+ *  and libm.
+ */
+
+class Random {
+public:
+  explicit Random(uint64_t seed) {
+    for(int i = 0; i < 4; ++i)
+      s_[i] = splitmix64(seed);
+  }
+
+  uint64_t next() {
+    uint64_t result = rotl(s_[1] * 5, 7) * 9;
+    uint64_t t = s_[1] << 17;
+
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 45);
+
+    return result;
+  }
+
+  /* in [0, 1) */
+  double uniform() { return (next() >> 11) * (1.0 / (UINT64_C(1) << 53)); }
+
+  /* in [0, n) */
+  uint64_t below(uint64_t n) { return (uint64_t) (uniform() * n); }
+
+  double exponential(double rate) { return -std::log1p(-uniform()) / rate; }
+
+  bool chance(double p) { return uniform() < p; }
+
+private:
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+  static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += UINT64_C(0x9e3779b97f4a7c15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return z ^ (z >> 31);
+  }
+
+  uint64_t s_[4];
+};
+
+/**
+ * \brief parameters of a generated order stream. the defaults look like
+ *  a liquid book: most orders rest close to the mid and are cancelled
+ */
+
+struct Model {
+  enum Arrivals { poisson, hawkes };
+  enum Distance { exponential_distance, uniform_distance, power_law_distance };
+
+  Model() :
+    arrivals(poisson),
+    rate(100000),
+    hawkes_alpha(70000),
+    hawkes_beta(100000),
+    cancel_ratio(0.95),
+    replace_ratio(0.05),
+    market_share(0.05),
+    stop_share(0.02),
+    reduce_only_share(0.02),
+    mid(1000),
+    tick(0.01),
+    mid_move_chance(0.01),
+    distance(exponential_distance),
+    mean_distance(10),
+    power_law_exponent(2.5),
+    max_distance(1000),
+    lot(1),
+    max_lots(10),
+    users(100) {}
+
+  Arrivals arrivals;
+  double rate;               /* events per second, the base intensity of hawkes */
+  double hawkes_alpha;       /* intensity added by each event, per second */
+  double hawkes_beta;        /* decay of that intensity per second. alpha < beta */
+
+  double cancel_ratio;       /* cancels per new order */
+  double replace_ratio;      /* replaces per new order */
+  double market_share;       /* share of new orders sent at market */
+  double stop_share;         /* share of new orders that are stop orders */
+  double reduce_only_share;  /* share of new limit orders that are reduce-only */
+
+  double mid;                /* starting mid price */
+  double tick;
+  double mid_move_chance;    /* chance that the mid moves a tick at each event */
+
+  Distance distance;         /* of limit prices to the mid, in ticks */
+  double mean_distance;      /* exponential and uniform */
+  double power_law_exponent; /* power law, from 1 tick */
+  double max_distance;
+
+  double lot;
+  uint32_t max_lots;         /* qty is 1 to max_lots lots */
+  uint32_t users;
+};
+
+/**
+ * \brief generates an order stream from a Model and a seed
+ */
+
+class Generator {
+public:
+  Generator(const Model& model, uint64_t seed) :
+    model_(model), random_(seed), mid_(model.mid),
+    time_(0), excitation_(0), next_order_id_(0) {}
+
+  Event next() {
+    Event event = Event();
+    event.ts = (uint64_t) (next_arrival() * 1e9);
+
+    if(random_.chance(model_.mid_move_chance))
+      mid_ += random_.chance(0.5) ? model_.tick : -model_.tick;
+
+    double total = 1 + model_.cancel_ratio + model_.replace_ratio;
+    double action = random_.uniform() * total;
+
+    if(!live_.empty() && action < model_.cancel_ratio)
+      cancel(event);
+    else if(!live_.empty() && action < model_.cancel_ratio + model_.replace_ratio)
+      replace(event);
+    else
+      add(event);
+
+    return event;
+  }
+
+  std::vector<Event> generate(size_t n) {
+    std::vector<Event> events;
+    events.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+      events.push_back(next());
+    return events;
+  }
+
+  double mid() const { return mid_; }
+
+  /* orders added and not cancelled by the stream so far */
+  size_t live_orders() const { return live_.size(); }
+
+private:
+  /* seconds since the start of the stream */
+  double next_arrival() {
+    if(model_.arrivals == Model::poisson)
+      return time_ += random_.exponential(model_.rate);
+
+    /* hawkes by thinning: the intensity only decays until the next event,
+      so its current value bounds it */
+    for(;;) {
+      double bound = model_.rate + excitation_;
+      double wait = random_.exponential(bound);
+
+      time_ += wait;
+      excitation_ *= std::exp(-model_.hawkes_beta * wait);
+
+      if(random_.uniform() * bound <= model_.rate + excitation_) {
+        excitation_ += model_.hawkes_alpha;
+        return time_;
+      }
+    }
+  }
+
+  double distance_ticks() {
+    double d;
+
+    switch(model_.distance) {
+      case Model::uniform_distance:
+        d = random_.uniform() * 2 * model_.mean_distance;
+        break;
+      case Model::power_law_distance:
+        d = std::pow(1 - random_.uniform(), -1 / (model_.power_law_exponent - 1));
+        break;
+      default:
+        d = random_.exponential(1 / model_.mean_distance);
+    }
+
+    return std::floor(std::min(d, model_.max_distance));
+  }
+
+  double round_to_tick(double price) const {
+    return std::round(price / model_.tick) * model_.tick;
+  }
+
+  void add(Event& event) {
+    event.type = event_add;
+    event.order_id = next_order_id_++;
+    event.user_id = 1 + (uint32_t) random_.below(model_.users);
+    event.is_bid = random_.chance(0.5);
+    event.qty = model_.lot * (1 + random_.below(model_.max_lots));
+
+    double side = event.is_bid ? -1 : 1;
+
+    if(random_.chance(model_.stop_share)) {
+      /* market stop, triggered when the price moves against the mid */
+      event.stop_price = round_to_tick(mid_ - side * (1 + distance_ticks()) * model_.tick);
+      live_.push_back(event.order_id);
+    }
+
+    else if(random_.chance(model_.market_share)) {
+      event.price = 0;
+    }
+
+    else {
+      event.price = round_to_tick(mid_ + side * distance_ticks() * model_.tick);
+      if(event.price <= 0) event.price = model_.tick;
+      event.reduce_only = random_.chance(model_.reduce_only_share);
+      live_.push_back(event.order_id);
+    }
+  }
+
+  /* picks a live order at random */
+  size_t pick() { return (size_t) random_.below(live_.size()); }
+
+  void cancel(Event& event) {
+    size_t pos = pick();
+    event.type = event_cancel;
+    event.order_id = live_[pos];
+
+    live_[pos] = live_.back();
+    live_.pop_back();
+  }
+
+  void replace(Event& event) {
+    event.type = event_replace;
+    event.order_id = live_[pick()];
+    event.qty = random_.chance(0.5) ? model_.lot : -model_.lot;
+  }
+
+  Model model_;
+  Random random_;
+  double mid_;
+  double time_;
+  double excitation_;
+  uint64_t next_order_id_;
+  std::vector<uint64_t> live_;
+};
+
+}
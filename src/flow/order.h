@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <memory>
+#include <stdint.h>
+
+#include <book/order.h>
+#include <book/journal.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <book/plugins/reduce_only.h>
+#include <book/plugins/post_only.h>
+#include <utils/uint128.h>
+
+#include "event.h"
+
+namespace flow {
+
+/**
+ * \brief order built from an add event. implements the order interfaces
+ *  of all the plugins, so it can be replayed through any configuration
+ */
+
+class Order :
+  public book::Order,
+  public book::plugins::SelfTradePolicyOrder,
+  public book::plugins::StopOrder,
+  public book::plugins::ReduceOnlyOrder,
+  public book::plugins::PostOnlyOrder {
+public:
+  explicit Order(const Event& event) :
+    order_id_(0, event.order_id),
+    user_id_(event.user_id),
+    is_bid_(event.is_bid),
+    price_(event.price),
+    qty_(event.qty),
+    stop_price_(event.stop_price),
+    reduce_only_(event.reduce_only) {}
+
+  utils::uint128 order_id() const { return order_id_; }
+  void order_id(const utils::uint128& order_id) { order_id_ = order_id; }
+
+  uint32_t user_id() const { return user_id_; }
+  bool is_bid() const { return is_bid_; }
+  double qty() const { return qty_; }
+  double price() const { return price_; }
+  double funds() const { return 0; }
+
+  book::plugins::SelfTradePolicy stp() const { return book::plugins::stp_cancel_taker; }
+  double stop_price() const { return stop_price_; }
+  bool reduce_only() const { return reduce_only_; }
+  bool post_only() const { return false; }
+
+private:
+  utils::uint128 order_id_;
+  uint32_t user_id_;
+  bool is_bid_;
+  double price_;
+  double qty_;
+  double stop_price_;
+  bool reduce_only_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+/* journals flow::Order, for books of Journaled storage */
+struct OrderCodec {
+  static void encode(const OrderPtr& order, book::JournalEncoder& out) {
+    Event event = Event();
+    event.order_id = order->order_id().lo;
+    event.user_id = order->user_id();
+    event.is_bid = order->is_bid();
+    event.reduce_only = order->reduce_only();
+    event.price = order->price();
+    event.qty = order->qty();
+    event.stop_price = order->stop_price();
+    out.put(event);
+  }
+
+  static OrderPtr decode(book::JournalDecoder& in) {
+    return std::make_shared<Order>(in.get<Event>());
+  }
+};
+
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 Lyes Bensaadi
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+#include <book/types.h>
+#include <book/latency.h>
+
+#include "event.h"
+#include "order.h"
+
+namespace flow {
+
+/**
+ * \brief counts and timings of a replay. latencies are in read_tsc()
+ *  ticks, one histogram per event type
+ */
+
+struct ReplayStats {
+  ReplayStats() : events(0), ns(0) {}
+
+  uint64_t events;
+  double ns;
+  book::LatencyHistogram latency[3];
+
+  uint64_t count(EventType type) const { return latency[type].count(); }
+  double events_per_second() const { return ns > 0 ? events / ns * 1e9 : 0; }
+};
+
+/* builds flow::Order, for books of flow::OrderPtr */
+struct MakeOrder {
+  OrderPtr operator()(const Event& event) const {
+    return std::make_shared<Order>(event);
+  }
+};
+
+/**
+ * \brief plays `events` through `book`, one call of the book per event.
+ *  `make_order` turns an add event into an order of the book, so any
+ *  configuration of OB can be driven by the same stream. cancels and
+ *  replaces of orders no longer on the book are passed on as they are:
+ *  a real stream has those too
+ */
+
+template <class Book, class Maker>
+void replay(Book& book, const std::vector<Event>& events,
+  ReplayStats& stats, Maker make_order)
+{
+  typedef typename Book::OrderPtr OrderPtr;
+  typedef std::chrono::steady_clock Clock;
+
+  /* order ids of a stream are its add events in sequence */
+  std::vector<OrderPtr> orders;
+  orders.reserve(events.size());
+
+  Clock::time_point start = Clock::now();
+
+  for(auto it = events.begin(); it != events.end(); ++it) {
+    const Event& event = *it;
+    uint64_t begin;
+
+    switch(event.type) {
+      case event_add:
+        orders.push_back(make_order(event));
+        begin = book::read_tsc();
+        book.add(orders.back());
+        break;
+
+      case event_cancel:
+        begin = book::read_tsc();
+        book.cancel(orders[event.order_id], book::user_cancel);
+        break;
+
+      default:
+        begin = book::read_tsc();
+        book.replace(orders[event.order_id], event.qty);
+    }
+
+    stats.latency[event.type].record(book::read_tsc() - begin);
+  }
+
+  stats.ns += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  stats.events += events.size();
+}
+
+template <class Book>
+void replay(Book& book, const std::vector<Event>& events, ReplayStats& stats) {
+  replay(book, events, stats, MakeOrder());
+}
+
+}
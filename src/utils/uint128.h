@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
 #include <iostream>
 
 namespace utils {
@@ -90,5 +91,11 @@ typedef struct uint128 {
 
 } uint128;
 
+/* for unordered containers keyed by order id */
+struct Uint128Hash {
+  size_t operator()(const uint128& id) const {
+    return std::hash<uint64_t>()(id.hi * 0x9e3779b97f4a7c15ULL ^ id.lo);
+  }
+};
 
 }
\ No newline at end of file
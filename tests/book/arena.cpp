@@ -0,0 +1,137 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <vector>
+
+#include <book/types.h>
+#include <book/arena.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+#include "fixtures/helpers.h"
+
+namespace arena_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithStopPrice Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>
+> MapBook;
+
+typedef fixtures::LadderME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>
+> LadderBook;
+
+TEST_CASE("book arena") {
+  book::BookArena arena;
+
+  SUBCASE("freed blocks are reused") {
+    void* a = arena.allocate(40);
+    arena.deallocate(a, 40);
+    void* b = arena.allocate(48);
+
+    /* 40 and 48 bytes share a size class */
+    CHECK(a == b);
+    CHECK(arena.counters().slab_allocations == 1);
+    CHECK(arena.counters().in_use() == 1);
+  }
+
+  SUBCASE("slabs grow geometrically") {
+    std::vector<void*> blocks;
+    for(size_t i = 0; i < book::BookArena::MIN_SLAB_BLOCKS * 3; ++i)
+      blocks.push_back(arena.allocate(64));
+
+    CHECK(arena.counters().slab_allocations == 2);
+    CHECK(arena.counters().bytes_reserved == 64 * book::BookArena::MIN_SLAB_BLOCKS * 3);
+
+    for(auto it = blocks.begin(); it != blocks.end(); ++it)
+      arena.deallocate(*it, 64);
+
+    CHECK(arena.counters().in_use() == 0);
+  }
+
+  SUBCASE("reserving tops up the size classes in use") {
+    arena.deallocate(arena.allocate(64), 64);
+    arena.reserve(1000);
+
+    std::vector<void*> blocks;
+    for(size_t i = 0; i < 1000; ++i)
+      blocks.push_back(arena.allocate(64));
+
+    CHECK(arena.counters().slab_allocations == 2);
+
+    /* first slab of a new class has the reserved capacity */
+    for(size_t i = 0; i < 1000; ++i)
+      arena.allocate(200);
+
+    CHECK(arena.counters().slab_allocations == 3);
+  }
+
+  SUBCASE("large blocks go to the global allocator") {
+    arena.deallocate(arena.allocate(book::BookArena::MAX_BLOCK_SIZE + 1),
+      book::BookArena::MAX_BLOCK_SIZE + 1);
+
+    CHECK(arena.counters().oversize_allocations == 1);
+    CHECK(arena.counters().slab_allocations == 0);
+    CHECK(arena.counters().in_use() == 0);
+  }
+}
+
+TEST_CASE_TEMPLATE("steady-state matching does not allocate", Book, MapBook, LadderBook) {
+  Book book(SYMBOL_ID_1, book::TickScale(), 1000);
+
+  auto cycle = [&book]() {
+    /* a few levels of asks, a triggered stop, and a sweep */
+    for(int i = 0; i < 100; ++i)
+      book.add(std::make_shared<Order>(USER_1, SELL, 1000 + i % 10, 1, 0));
+
+    book.add(std::make_shared<Order>(USER_2, BUY, 0, 1, 0, 1005));
+
+    OrderPtr cancelled = std::make_shared<Order>(USER_1, SELL, 1009, 1, 0);
+    book.add(cancelled);
+    book.cancel(cancelled, book::user_cancel);
+
+    book.add(std::make_shared<Order>(USER_2, BUY, 0, 200, 0));
+    book.set_market_price(1000);
+  };
+
+  /* the stop only rests once there is a market price */
+  cycle();
+  cycle();
+
+  const book::BookArena::Counters& counters = book.arena().counters();
+  uint64_t global_allocations = counters.global_allocations();
+  uint64_t in_use = counters.in_use();
+
+  CHECK(book.asks().size() == 0);
+
+  for(int i = 0; i < 50; ++i)
+    cycle();
+
+  CHECK(counters.global_allocations() == global_allocations);
+  CHECK(counters.in_use() == in_use);
+  CHECK(counters.allocations > 50 * 100);
+}
+
+}
@@ -0,0 +1,183 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <book/types.h>
+#include <book/ob.h>
+#include <book/plugins/self_trade_policy.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace batch_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>
+> ME;
+
+/* counts deliveries on top of recording callbacks */
+class Book : public ME {
+public:
+  Book() : ME(SYMBOL_ID_1) {}
+
+  size_t batches = 0;
+
+  void on_callbacks(const ME::Base::Callbacks& callbacks) {
+    ++batches;
+    ME::on_callbacks(callbacks);
+  }
+};
+
+size_t count(const Book::Callbacks& cbs, Book::TypedCallback::CbType type) {
+  size_t n = 0;
+  for(auto it = cbs.begin(); it != cbs.end(); ++it)
+    n += it->type == type;
+  return n;
+}
+
+TEST_CASE("batched adds and cancels") {
+  Book book;
+
+  std::vector<OrderPtr> asks = {
+    std::make_shared<Order>(USER_1, SELL, 1001, 1, 0),
+    std::make_shared<Order>(USER_1, SELL, 1002, 1, 0),
+    std::make_shared<Order>(USER_1, SELL, 1003, 1, 0),
+    std::make_shared<Order>(USER_2, BUY, 1002, 3, 0)
+  };
+
+  SUBCASE("one delivery and one book update per batch") {
+    book.start_recording_callbacks();
+    size_t matched = book.add_batch(asks.begin(), asks.end());
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(matched == 1);
+    CHECK(book.batches == 1);
+
+    CHECK(count(cb, Book::TypedCallback::cb_order_accept) == 4);
+    CHECK(count(cb, Book::TypedCallback::cb_trade) == 2);
+    CHECK(count(cb, Book::TypedCallback::cb_book_update) == 1);
+    CHECK(cb.back().type == Book::TypedCallback::cb_book_update);
+
+    /* accepts are still patched with the fills of their order */
+    CHECK(cb[3].type == Book::TypedCallback::cb_order_accept);
+    CHECK(cb[3].order == asks[3]);
+    CHECK(cb[3].qty == 2);
+
+    CHECK(book.asks().size() == 1);
+    CHECK(book.bids().size() == 1);
+  }
+
+  SUBCASE("book updates can be kept per order") {
+    book.start_recording_callbacks();
+    book.add_batch(asks.begin(), asks.end(), false);
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(book.batches == 1);
+    CHECK(count(cb, Book::TypedCallback::cb_book_update) == 4);
+  }
+
+  SUBCASE("the batch matches like sequential adds") {
+    Book sequential;
+    sequential.start_recording_callbacks();
+    for(auto it = asks.begin(); it != asks.end(); ++it)
+      sequential.add(*it);
+    Book::Callbacks expected = sequential.get_recorded_callbacks();
+
+    book.start_recording_callbacks();
+    book.add_batch(asks.begin(), asks.end(), false);
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    REQUIRE(cb.size() == expected.size());
+    for(size_t i = 0; i < cb.size(); ++i) {
+      CHECK(cb[i].type == expected[i].type);
+      CHECK(cb[i].order == expected[i].order);
+      CHECK(cb[i].qty == expected[i].qty);
+    }
+  }
+
+  SUBCASE("cancelling a batch") {
+    book.add_batch(asks.begin(), asks.begin() + 3);
+    book.batches = 0;
+
+    std::vector<OrderPtr> cancels = { asks[0], asks[2], asks[3] };
+
+    book.start_recording_callbacks();
+    book.cancel_batch(cancels.begin(), cancels.end(), book::user_cancel);
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(book.batches == 1);
+    CHECK(book.asks().size() == 1);
+
+    REQUIRE(cb.size() == 4);
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel);
+    CHECK(cb[1].type == Book::TypedCallback::cb_order_cancel);
+
+    /* never added */
+    CHECK(cb[2].type == Book::TypedCallback::cb_order_cancel_reject);
+    CHECK(cb[3].type == Book::TypedCallback::cb_book_update);
+  }
+}
+
+/* throws on orders at a price of 13 */
+template <class Tracker, class Book = book::UnboundBook>
+class FaultyPlugin :
+public book::Plugin<Tracker, Book, FaultyPlugin<Tracker, Book>>
+{
+public:
+  void should_add(const Tracker& taker, book::InsertRejectReasons&) {
+    if(taker.price() == 13) throw std::runtime_error("faulty order");
+  }
+};
+
+class FaultyBook : public fixtures::ME<Tracker, FaultyPlugin<Tracker>> {
+public:
+  FaultyBook() : fixtures::ME<Tracker, FaultyPlugin<Tracker>>(SYMBOL_ID_1) {}
+};
+
+TEST_CASE("an order that throws ends its batch") {
+  FaultyBook book;
+
+  std::vector<OrderPtr> asks = {
+    std::make_shared<Order>(USER_1, SELL, 11, 1, 0),
+    std::make_shared<Order>(USER_1, SELL, 12, 1, 0),
+    std::make_shared<Order>(USER_1, SELL, 13, 1, 0),
+    std::make_shared<Order>(USER_1, SELL, 14, 1, 0)
+  };
+
+  book.start_recording_callbacks();
+  CHECK_THROWS_AS(book.add_batch(asks.begin(), asks.end()), std::runtime_error);
+
+  /* delivered, rather than left for the next call */
+  FaultyBook::Callbacks cb = book.get_recorded_callbacks();
+  REQUIRE(cb.size() == 2);
+  CHECK(cb[0].order == asks[0]);
+  CHECK(cb[1].order == asks[1]);
+  CHECK(book.asks().size() == 2);
+
+  book.cancel(asks[0], book::user_cancel);
+  cb = book.get_recorded_callbacks();
+  REQUIRE(cb.size() == 2);
+  CHECK(cb[0].type == FaultyBook::TypedCallback::cb_order_cancel);
+}
+
+}
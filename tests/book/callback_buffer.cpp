@@ -0,0 +1,105 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <vector>
+
+#include <book/types.h>
+#include <book/ob.h>
+#include <book/plugins/self_trade_policy.h>
+#include "fixtures/order.h"
+
+namespace callback_buffer_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+/* keeps only what it needs from each batch, like a publisher would */
+class Book : public book::OB<Tracker, book::plugins::SelfTradePolicyPlugin<Tracker>> {
+public:
+  Book() : book::OB<Tracker, book::plugins::SelfTradePolicyPlugin<Tracker>>(SYMBOL_ID_1) {}
+
+  std::vector<const TypedCallback*> batch_begins;
+  size_t last_batch_size = 0;
+  size_t trades = 0;
+  long max_order_use_count = 0;
+
+protected:
+  void on_callbacks(const Callbacks& callbacks) {
+    batch_begins.push_back(callbacks.begin());
+    last_batch_size = callbacks.size();
+
+    for(auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+      if(it->type != TypedCallback::cb_trade) continue;
+      ++trades;
+      if(it->maker_order.use_count() > max_order_use_count)
+        max_order_use_count = it->maker_order.use_count();
+    }
+  }
+};
+
+TEST_CASE("callbacks are delivered in place") {
+  Book book;
+  book.reserve_callbacks(2000);
+
+  std::vector<OrderPtr> makers;
+  for(int i = 0; i < 500; ++i) {
+    makers.push_back(std::make_shared<Order>(USER_1, SELL, 1000 + i, 1, 0));
+    book.add(makers.back());
+  }
+
+  book.add(std::make_shared<Order>(USER_2, BUY, 0, 500, 0));
+
+  /* accept, 500 trades, book update */
+  CHECK(book.last_batch_size == 502);
+  CHECK(book.trades == 500);
+  CHECK(book.asks().size() == 0);
+
+  SUBCASE("every batch uses the same storage") {
+    for(size_t i = 1; i < book.batch_begins.size(); ++i)
+      CHECK(book.batch_begins[i] == book.batch_begins[0]);
+
+    CHECK(book.callback_buffer().growths() == 0);
+    CHECK(book.callback_buffer().capacity() >= 2000);
+  }
+
+  SUBCASE("a callback is the only extra owner of its order") {
+    /* makers[i] and the trade callback. the tracker is erased before delivery */
+    CHECK(book.max_order_use_count == 2);
+  }
+
+  SUBCASE("a batch larger than the capacity grows the buffer") {
+    book::CallbackBuffer<int> buffer(2);
+    buffer.push_back(1);
+    buffer.push_back(2);
+    CHECK(buffer.growths() == 0);
+
+    buffer.push_back(3);
+    CHECK(buffer.growths() == 1);
+
+    /* storage is kept across batches */
+    buffer.clear();
+    for(int i = 0; i < 3; ++i)
+      buffer.push_back(i);
+
+    CHECK(buffer.growths() == 1);
+    CHECK(buffer.span().size() == 3);
+    CHECK(buffer.span()[2] == 2);
+  }
+}
+
+}
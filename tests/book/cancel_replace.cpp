@@ -0,0 +1,126 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <cmath>
+#include <vector>
+
+#include <book/types.h>
+#include <book/plugins/self_trade_policy.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+#include "fixtures/helpers.h"
+
+namespace cancel_replace_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>
+> MapBook;
+
+typedef fixtures::LadderME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>
+> LadderBook;
+
+TEST_CASE_TEMPLATE("cancel and replace on a crowded level", Book, MapBook, LadderBook) {
+  Book book(SYMBOL_ID_1);
+
+  std::vector<OrderPtr> orders;
+  for(int i = 0; i < 1000; ++i) {
+    orders.push_back(std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0));
+    book.add(orders.back());
+  }
+
+  CHECK(book.bids().size() == 1000);
+  CHECK(book.order_count() == 1000);
+
+  SUBCASE("cancelling an order deep in the queue") {
+    book.start_recording_callbacks();
+    book.cancel(orders[700], book::user_cancel);
+    typename Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(cb.size() == 2);
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel);
+    CHECK(cb[0].order == orders[700]);
+    CHECK(cb[0].generic_1 == 1.0);
+    CHECK(cb[1].type == Book::TypedCallback::cb_book_update);
+
+    CHECK(book.bids().size() == 999);
+    CHECK(book.order_count() == 999);
+
+    SUBCASE("cancelling it again is rejected") {
+      book.start_recording_callbacks();
+      book.cancel(orders[700], book::user_cancel);
+      typename Book::Callbacks cb = book.get_recorded_callbacks();
+
+      CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel_reject);
+      CHECK(cb[0].reason == book::cancel_reject_not_found);
+    }
+  }
+
+  SUBCASE("replacing an order keeps its priority") {
+    book.start_recording_callbacks();
+    book.replace(orders[1], 2.0);
+    typename Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_replace);
+    CHECK(cb[0].generic_1 == 2.0);
+    CHECK(cb[0].generic_2 == 1.0);
+
+    book.start_recording_callbacks();
+    book.add(std::make_shared<Order>(USER_2, SELL, 0, 3.0, 0));
+    cb = book.get_recorded_callbacks();
+
+    CHECK(cb[1].type == Book::TypedCallback::cb_trade);
+    CHECK(cb[1].maker_order == orders[0]);
+    CHECK(cb[2].type == Book::TypedCallback::cb_trade);
+    CHECK(cb[2].maker_order == orders[1]);
+    CHECK(cb[2].qty == 2.0);
+  }
+
+  SUBCASE("replacing all the qty removes the order") {
+    book.replace(orders[500], -1.0);
+
+    CHECK(book.bids().size() == 999);
+    CHECK(book.order_count() == 999);
+
+    book.start_recording_callbacks();
+    book.replace(orders[500], 1.0);
+    typename Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_replace_reject);
+    CHECK(cb[0].reason == book::replace_reject_not_found);
+  }
+
+  SUBCASE("filled orders leave the index") {
+    book.add(std::make_shared<Order>(USER_2, SELL, 1000.00, 10.0, 0));
+
+    CHECK(book.order_count() == 990);
+
+    book.start_recording_callbacks();
+    book.cancel(orders[0], book::user_cancel);
+    typename Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel_reject);
+  }
+}
+
+}
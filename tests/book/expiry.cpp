@@ -0,0 +1,272 @@
+#include <doctest/doctest.h>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <book/types.h>
+#include <book/journal.h>
+#include <book/snapshot.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/expiry.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace expiry_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+class Order : public fixtures::OrderWithUserID, public book::plugins::ExpiryOrder {
+public:
+  Order(uint32_t user_id, bool is_bid, double price, double qty, uint64_t expire_time = 0) :
+    fixtures::OrderWithUserID(user_id, is_bid, price, qty, 0), expire_time_(expire_time) {}
+
+  uint64_t expire_time() const { return expire_time_; }
+
+private:
+  uint64_t expire_time_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Codec {
+  static void encode(const OrderPtr& order, book::JournalEncoder& out) {
+    out.put(order->order_id());
+    out.put(order->user_id());
+    out.put(order->is_bid());
+    out.put(order->price());
+    out.put(order->qty());
+    out.put(order->expire_time());
+  }
+
+  static OrderPtr decode(book::JournalDecoder& in) {
+    utils::uint128 order_id = in.get<utils::uint128>();
+    uint32_t user_id = in.get<uint32_t>();
+    bool is_bid = in.get<bool>();
+    double price = in.get<double>();
+    double qty = in.get<double>();
+    uint64_t expire_time = in.get<uint64_t>();
+
+    OrderPtr order = std::make_shared<Order>(user_id, is_bid, price, qty, expire_time);
+    order->order_id(order_id);
+    return order;
+  }
+};
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::ExpiryTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::ExpiryTracker<OrderPtr>(order) {}
+};
+
+template <class Storage>
+using BookOn = fixtures::BasicME<
+  book::Journaled<Storage, Codec>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::ExpiryPlugin<Tracker>
+>;
+
+typedef BookOn<book::MapStorage> Book;
+typedef Book::TypedCallback Callback;
+
+const char* JOURNAL = "expiry_test.journal";
+const char* SNAPSHOT = "expiry_test.snapshot";
+
+TEST_CASE("good-till-date orders expire") {
+  Book book(SYMBOL_ID_1);
+
+  OrderPtr gtc = std::make_shared<Order>(USER_1, SELL, 101, 1);
+  OrderPtr gtd_1 = std::make_shared<Order>(USER_1, SELL, 102, 2, 1000);
+  OrderPtr gtd_2 = std::make_shared<Order>(USER_1, BUY, 99, 3, 2000);
+
+  book.add(gtc);
+  book.add(gtd_1);
+  book.add(gtd_2);
+
+  CHECK(book.expiring_orders() == 2);
+
+  SUBCASE("at their expire time, in one batch") {
+    book.advance_time(999);
+    CHECK(book.order_count() == 3);
+
+    book.start_recording_callbacks();
+    book.advance_time(5000);
+    auto cbs = book.get_recorded_callbacks();
+
+    REQUIRE(cbs.size() == 3);
+    CHECK(cbs[0].type == Callback::cb_order_cancel);
+    CHECK(cbs[0].reason == book::expired);
+    CHECK(cbs[0].order == gtd_1);
+    CHECK(cbs[0].generic_1 == 2);
+    CHECK(cbs[1].order == gtd_2);
+    CHECK(cbs[2].type == Callback::cb_book_update);
+
+    CHECK(book.order_count() == 1);
+    CHECK(book.best_ask() == 101);
+    CHECK(book.side_qty(BUY) == 0);
+    CHECK(book.expiring_orders() == 0);
+    CHECK(book.now() == 5000);
+  }
+
+  SUBCASE("orders leaving the book drop their timer") {
+    book.add(std::make_shared<Order>(USER_2, BUY, 102, 3));
+    CHECK(book.expiring_orders() == 1);
+
+    book.cancel(gtd_2, book::user_cancel);
+    CHECK(book.expiring_orders() == 0);
+
+    book.start_recording_callbacks();
+    book.advance_time(5000);
+    CHECK(book.get_recorded_callbacks().empty());
+  }
+
+  SUBCASE("a partial fill keeps the timer") {
+    book.add(std::make_shared<Order>(USER_2, BUY, 102, 2));
+    CHECK(book.order_count() == 2);
+    CHECK(book.expiring_orders() == 2);
+
+    book.advance_time(1000);
+    CHECK(book.asks().size() == 0);
+    CHECK(book.expiring_orders() == 1);
+  }
+
+  SUBCASE("orders arriving expired do not rest") {
+    book.advance_time(1500);
+
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 101, 3, 1500));
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == 1);
+    CHECK(cbs[cbs.size() - 2].type == Callback::cb_order_cancel);
+    CHECK(cbs[cbs.size() - 2].reason == book::expired);
+
+    CHECK(book.bids().size() == 1);
+    CHECK(book.expiring_orders() == 1);
+
+    /* expiring later, it rests */
+    book.add(std::make_shared<Order>(USER_2, BUY, 100, 1, 1501));
+    CHECK(book.expiring_orders() == 2);
+  }
+}
+
+/* random orders, some expiring, and time moving on */
+template <class B>
+void run_session(B& book, std::vector<OrderPtr>& orders, int n, unsigned seed, uint64_t first_id) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> action(0, 19);
+  std::uniform_int_distribution<int> tick(-20, 20);
+  std::uniform_int_distribution<int> lots(1, 20);
+  std::uniform_int_distribution<uint64_t> lifetime(1, 5000);
+
+  uint64_t now = book.now();
+
+  for(int i = 0; i < n; ++i) {
+    int a = action(rng);
+
+    if(a < 3 && !orders.empty())
+      book.cancel(orders[rng() % orders.size()], book::user_cancel);
+
+    else if(a < 5)
+      book.advance_time(now += rng() % 200);
+
+    else {
+      uint64_t expire_time = a < 12 ? now + lifetime(rng) : 0;
+      OrderPtr order = std::make_shared<Order>(
+        1 + rng() % 4, rng() & 1, 1000 + tick(rng), lots(rng), expire_time);
+      order->order_id(utils::uint128(0, first_id + i));
+
+      orders.push_back(order);
+      book.add(order);
+    }
+  }
+}
+
+template <class Callbacks>
+void check_same(const Callbacks& a, const Callbacks& b) {
+  REQUIRE(a.size() == b.size());
+
+  for(size_t i = 0; i < a.size(); ++i) {
+    CHECK(a[i].type == b[i].type);
+    CHECK(a[i].reason == b[i].reason);
+    CHECK(a[i].qty == b[i].qty);
+    if(a[i].order) CHECK(a[i].order->order_id() == b[i].order->order_id());
+  }
+}
+
+TEST_CASE_TEMPLATE("expiries are journaled and restored from snapshots", Storage,
+  book::MapStorage, book::LadderStorage)
+{
+  typedef BookOn<Storage> B;
+
+  B book(SYMBOL_ID_1);
+  std::vector<OrderPtr> orders;
+  uint64_t journal_seq;
+
+  {
+    book::JournalWriter writer(JOURNAL, SYMBOL_ID_1);
+    book.journal().attach(&writer);
+    book.start_recording_callbacks();
+
+    run_session(book, orders, 2000, 42, 0);
+
+    book::SnapshotWriter<Codec> out;
+    book.save(out);
+    journal_seq = writer.next_seq() - 1;
+    out.write(SNAPSHOT, book.symbol_id(), journal_seq);
+
+    run_session(book, orders, 2000, 43, 2000);
+    book.journal().detach();
+  }
+
+  typename B::Callbacks recorded = book.get_recorded_callbacks();
+  CHECK(book.expiring_orders() > 0);
+
+  SUBCASE("replay expires the same orders") {
+    B replayed(SYMBOL_ID_1);
+    replayed.start_recording_callbacks();
+
+    book::JournalReader reader(JOURNAL);
+    book::JournalReplayer<B> replayer(replayed);
+    replayer.replay(reader);
+
+    check_same(recorded, replayed.get_recorded_callbacks());
+    CHECK(replayed.now() == book.now());
+    CHECK(replayed.expiring_orders() == book.expiring_orders());
+  }
+
+  SUBCASE("a restored book keeps the time and the timers") {
+    book::SnapshotReader<Codec> in(SNAPSHOT);
+    B restored(SYMBOL_ID_1);
+    restored.load(in);
+
+    book::JournalReader reader(JOURNAL);
+    book::JournalReplayer<B> replayer(restored);
+    replayer.resume(in.orders(), in.journal_seq());
+    replayer.fast_forward(reader);
+
+    CHECK(restored.now() == book.now());
+    CHECK(restored.order_count() == book.order_count());
+    CHECK(restored.expiring_orders() == book.expiring_orders());
+
+    /* and everything left expires alike */
+    uint64_t later = book.now() + 10000;
+    restored.advance_time(later);
+    book.advance_time(later);
+    CHECK(restored.order_count() == book.order_count());
+  }
+
+  std::remove(JOURNAL);
+  std::remove(SNAPSHOT);
+}
+
+}
@@ -0,0 +1,171 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <cmath>
+
+#include <book/types.h>
+#include <book/units.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/positions.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+#include "fixtures/helpers.h"
+
+namespace fixed_point_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+typedef book::BaseTracker<OrderPtr, book::FixedPoint> BaseTracker;
+
+struct Tracker :
+  public virtual BaseTracker,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::PositionsTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order, const book::TickScale& scale) :
+    BaseTracker(order, scale),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::PositionsTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::PositionsPlugin<Tracker>
+> Book;
+
+/* 0.01 price ticks, 0.001 qty lots */
+static const book::TickScale scale(0.01, 0.001);
+
+TEST_CASE("tick scale") {
+  CHECK(scale.to_ticks(1000.01) == 100001);
+  CHECK(scale.to_lots(0.1) == 100);
+  CHECK(scale.to_lots(0.3) == 300);
+  CHECK(scale.to_tick_lots(10.0) == 1000000);
+
+  /* funds never round up */
+  CHECK(scale.to_tick_lots(0.000019) == 1);
+
+  CHECK(scale.to_price(100001) == doctest::Approx(1000.01));
+  CHECK(scale.to_qty(300) == doctest::Approx(0.3));
+}
+
+TEST_CASE("tick scale grid") {
+  CHECK(scale.on_ticks(1000.01));
+  CHECK(scale.on_ticks(0));
+  CHECK(!scale.on_ticks(100.006));
+  CHECK(!scale.on_ticks(0.004));
+
+  CHECK(scale.on_lots(0.3));
+  CHECK(!scale.on_lots(0.0004));
+  CHECK(!scale.on_lots(0.1005));
+
+  /* a minimum qty never rounds below what was asked */
+  CHECK(scale.to_min_lots(0.3) == 300);
+  CHECK(scale.to_min_lots(0.0004) == 1);
+  CHECK(scale.to_min_lots(0.1001) == 101);
+}
+
+TEST_CASE("fixed-point orders off the grid are rejected") {
+  Book book(SYMBOL_ID_1, scale);
+  book.add(std::make_shared<Order>(USER_1, SELL, 100.01, 1, 0));
+
+  auto check_rejected = [&book](const OrderPtr& order) {
+    Book::Callbacks cb = book.add_and_get_cbs(order);
+    REQUIRE(cb.size() == 1);
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_reject);
+    CHECK(cb[0].reason == book::off_grid);
+  };
+
+  /* would have been rounded to 100.01, above its limit */
+  check_rejected(std::make_shared<Order>(USER_2, BUY, 100.006, 1, 0));
+
+  /* would have been rounded to 0, a market order */
+  check_rejected(std::make_shared<Order>(USER_2, BUY, 0.004, 1, 0));
+
+  /* would have been rounded to 0 lots */
+  check_rejected(std::make_shared<Order>(USER_2, BUY, 100.01, 0.0004, 0));
+
+  CHECK(book.asks().size() == 1);
+  CHECK(book.asks().begin()->second.qty_on_book() == 1000);
+  CHECK(book.bids().size() == 0);
+}
+
+TEST_CASE("fixed-point matching") {
+  Book book(SYMBOL_ID_1, scale);
+
+  CHECK(book.scale().tick_size() == 0.01);
+
+  SUBCASE("resting prices and quantities are in ticks and lots") {
+    book.add(std::make_shared<Order>(USER_1, BUY, 999.99, 0.5, 0));
+
+    CHECK(book.bids().size() == 1);
+    CHECK(book.bids().begin()->first.price() == 99999);
+    CHECK(book.bids().begin()->second.qty_on_book() == 500);
+  }
+
+  SUBCASE("tenths add up to a whole without drift") {
+    /* 0.1 * 10 != 1.0 in double */
+    for(int i = 0; i < 10; ++i)
+      book.add(std::make_shared<Order>(USER_1, SELL, 1000.01, 0.1, 0));
+
+    book.start_recording_callbacks();
+    book.add(std::make_shared<Order>(USER_2, BUY, 1000.01, 1.0, 0));
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(book.asks().size() == 0);
+    CHECK(book.bids().size() == 0);
+    CHECK(book.market_price() == 100001);
+
+    CHECK(cb[0].type == Book::TypedCallback::cb_order_accept);
+    CHECK(cb[0].qty == 1000);
+    CHECK(cb[0].avg_price == 100001);
+
+    CHECK(cb[1].type == Book::TypedCallback::cb_trade);
+    CHECK(cb[1].qty == 100);
+    CHECK(cb[1].price == 100001);
+
+    const Book::TypedCallback* last_trade = nullptr;
+    for(size_t i = 0; i < cb.size(); ++i)
+      if(cb[i].type == Book::TypedCallback::cb_trade)
+        last_trade = &cb[i];
+
+    REQUIRE(last_trade != nullptr);
+    CHECK(last_trade->generic_2 == 1000);
+    CHECK(last_trade->flags == Book::TypedCallback::both_filled);
+  }
+
+  SUBCASE("market buy with funds buys whole lots") {
+    book.add(std::make_shared<Order>(USER_1, SELL, 100.00, 1.0, 0));
+
+    book.start_recording_callbacks();
+    /* 0.2555 at 100.00 is 255.5 lots, rounded down */
+    book.add(std::make_shared<Order>(USER_2, BUY, 0, 0, 25.55));
+    Book::Callbacks cb = book.get_recorded_callbacks();
+
+    CHECK(cb[1].type == Book::TypedCallback::cb_trade);
+    CHECK(cb[1].qty == 255);
+    CHECK(cb[1].price == 10000);
+
+    CHECK(book.asks().begin()->second.qty_on_book() == 745);
+  }
+
+  SUBCASE("replace deltas are in lots") {
+    OrderPtr order = std::make_shared<Order>(USER_1, BUY, 999.99, 0.5, 0);
+    book.add(order);
+
+    book.replace(order, -499);
+    CHECK(book.bids().begin()->second.qty_on_book() == 1);
+
+    book.replace(order, -1);
+    CHECK(book.bids().size() == 0);
+  }
+}
+
+}
@@ -9,16 +9,18 @@
 
 namespace fixtures {
 
-template <class Tracker, class... Plugins>
-class ME : public book::OB<Tracker, Plugins...> {
+template <class Storage, class Tracker, class... Plugins>
+class BasicME : public book::BasicOB<Storage, Tracker, Plugins...> {
 public:
+  typedef book::BasicOB<Storage, Tracker, Plugins...> Base;
   typedef typename Tracker::OrderPtr OrderPtr;
-  typedef std::vector<typename book::OB<Tracker, Plugins...>::TypedCallback> Callbacks;
+  typedef std::vector<typename Base::TypedCallback> Callbacks;
 
-  ME(uint32_t symbol_id);
+  BasicME(uint32_t symbol_id,
+    const book::TickScale& scale = book::TickScale(), size_t capacity = 0);
   Callbacks add_and_get_cbs(const OrderPtr& order);
 
-  void on_callbacks(const Callbacks& callbacks);
+  void on_callbacks(const typename Base::Callbacks& callbacks);
 
   void start_recording_callbacks() {
     recording_callbacks_ = true;
@@ -39,28 +41,33 @@ private:
 };
 
 template <class Tracker, class... Plugins>
-ME<Tracker, Plugins...>::ME(uint32_t symbol_id)
-: book::OB<Tracker, Plugins...>(symbol_id), recording_callbacks_(false) {
+using ME = BasicME<book::MapStorage, Tracker, Plugins...>;
+
+template <class Tracker, class... Plugins>
+using LadderME = BasicME<book::LadderStorage, Tracker, Plugins...>;
+
+template <class Storage, class Tracker, class... Plugins>
+BasicME<Storage, Tracker, Plugins...>::BasicME(
+  uint32_t symbol_id, const book::TickScale& scale, size_t capacity)
+: Base(symbol_id, scale, capacity), recording_callbacks_(false) {
 
 }
 
 
-template <class Tracker, class... Plugins>
-typename ME<Tracker, Plugins...>::Callbacks ME<Tracker, Plugins...>::add_and_get_cbs(const OrderPtr& order) {
-  book::OB<Tracker, Plugins...>::add(order);
+template <class Storage, class Tracker, class... Plugins>
+typename BasicME<Storage, Tracker, Plugins...>::Callbacks BasicME<Storage, Tracker, Plugins...>::add_and_get_cbs(const OrderPtr& order) {
+  Base::add(order);
   assert(callbacks_.size() != 0);
   return callbacks_;
 }
 
-template <class Tracker, class... Plugins>
-void ME<Tracker, Plugins...>::on_callbacks(const ME<Tracker, Plugins...>::Callbacks& callbacks) {
-  callbacks_ = callbacks;
+template <class Storage, class Tracker, class... Plugins>
+void BasicME<Storage, Tracker, Plugins...>::on_callbacks(const typename Base::Callbacks& callbacks) {
+  /* the span is only valid during this call */
+  callbacks_.assign(callbacks.begin(), callbacks.end());
 
-  if(recording_callbacks_) {
-    for(auto cb : callbacks) {
-      recorded_callbacks_.push_back(cb);
-    }
-  }
+  if(recording_callbacks_)
+    recorded_callbacks_.insert(recorded_callbacks_.end(), callbacks.begin(), callbacks.end());
 }
 
 }
\ No newline at end of file
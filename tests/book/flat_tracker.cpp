@@ -0,0 +1,127 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <book/types.h>
+#include <book/tracker.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/positions.h>
+#include <book/plugins/reduce_only.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace flat_tracker_test {
+
+#define SYMBOL_ID_1 1
+
+typedef fixtures::OrderWithReduceOnly Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+/* same plugins, composed both ways */
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::PositionsTracker<OrderPtr>,
+  public book::plugins::ReduceOnlyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::PositionsTracker<OrderPtr>(order),
+    book::plugins::ReduceOnlyTracker<OrderPtr>(order) {}
+};
+
+typedef book::FlatTracker<OrderPtr, book::TrackerState<
+  book::plugins::UserIDState<OrderPtr>,
+  book::plugins::SelfTradePolicyState<OrderPtr>,
+  book::plugins::ReduceOnlyState<OrderPtr>
+>> FlatTracker;
+
+static_assert(std::is_standard_layout<FlatTracker>::value,
+  "flat trackers are standard-layout");
+static_assert(!std::is_polymorphic<FlatTracker>::value,
+  "flat trackers have no vtable");
+static_assert(sizeof(FlatTracker) == sizeof(FlatTracker::Base),
+  "the accessors add nothing to the size of the tracker");
+static_assert(sizeof(FlatTracker) < sizeof(Tracker),
+  "no vptrs nor virtual base pointers");
+
+template <class T>
+using BookOf = fixtures::ME<T,
+  book::plugins::SelfTradePolicyPlugin<T>,
+  book::plugins::PositionsPlugin<T>,
+  book::plugins::ReduceOnlyPlugin<T>
+>;
+
+typedef BookOf<Tracker> Book;
+typedef BookOf<FlatTracker> FlatBook;
+
+TEST_CASE("flat tracker accessors") {
+  OrderPtr order = std::make_shared<Order>(7, true, 1000, 2, 0, true);
+  order->stp(book::plugins::stp_cancel_both);
+
+  FlatTracker tracker(order);
+
+  CHECK(tracker.user_id() == 7);
+  CHECK(tracker.stp() == book::plugins::stp_cancel_both);
+  CHECK(tracker.reduce_only());
+  CHECK(tracker.is_bid());
+  CHECK(tracker.price() == 1000);
+  CHECK(tracker.open_qty() == 2);
+  CHECK(tracker.ptr() == order);
+}
+
+TEST_CASE("flat trackers match like composed trackers") {
+  Book book(SYMBOL_ID_1);
+  FlatBook flat_book(SYMBOL_ID_1);
+
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> action(0, 9);
+  std::uniform_int_distribution<int> tick(-10, 10);
+  std::uniform_int_distribution<int> lots(1, 10);
+  std::uniform_int_distribution<int> user(1, 3);
+
+  std::vector<OrderPtr> orders;
+
+  book.start_recording_callbacks();
+  flat_book.start_recording_callbacks();
+
+  for(int i = 0; i < 3000; ++i) {
+    int a = action(rng);
+
+    if(a < 2 && !orders.empty()) {
+      OrderPtr order = orders[rng() % orders.size()];
+      book.cancel(order, book::user_cancel);
+      flat_book.cancel(order, book::user_cancel);
+    }
+
+    else {
+      bool is_bid = rng() & 1;
+      double price = a == 9 ? 0 : 1000 + tick(rng);
+      OrderPtr order = std::make_shared<Order>(
+        user(rng), is_bid, price, lots(rng), 0, a == 8);
+      order->stp((book::plugins::SelfTradePolicy) (1 + rng() % 3));
+
+      orders.push_back(order);
+      book.add(order);
+      flat_book.add(order);
+    }
+  }
+
+  Book::Callbacks cbs = book.get_recorded_callbacks();
+  FlatBook::Callbacks flat_cbs = flat_book.get_recorded_callbacks();
+
+  REQUIRE(cbs.size() == flat_cbs.size());
+
+  for(size_t i = 0; i < cbs.size(); ++i) {
+    CHECK(cbs[i].type == flat_cbs[i].type);
+    CHECK(cbs[i].reason == flat_cbs[i].reason);
+    CHECK(cbs[i].order == flat_cbs[i].order);
+    CHECK(cbs[i].qty == flat_cbs[i].qty);
+    CHECK(cbs[i].price == flat_cbs[i].price);
+  }
+}
+
+}
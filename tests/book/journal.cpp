@@ -0,0 +1,419 @@
+#include <doctest/doctest.h>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <book/types.h>
+#include <book/journal.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <book/plugins/routable.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace journal_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+#define MM_ID 1000
+#define MM_EXCHANGE 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithStopPrice Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Codec {
+  static void encode(const OrderPtr& order, book::JournalEncoder& out) {
+    out.put(order->order_id());
+    out.put(order->user_id());
+    out.put(order->is_bid());
+    out.put(order->price());
+    out.put(order->qty());
+    out.put(order->funds());
+    out.put(order->stp());
+    out.put(order->stop_price());
+  }
+
+  static OrderPtr decode(book::JournalDecoder& in) {
+    utils::uint128 order_id = in.get<utils::uint128>();
+    uint32_t user_id = in.get<uint32_t>();
+    bool is_bid = in.get<bool>();
+    double price = in.get<double>();
+    double qty = in.get<double>();
+    double funds = in.get<double>();
+    book::plugins::SelfTradePolicy stp = in.get<book::plugins::SelfTradePolicy>();
+    double stop_price = in.get<double>();
+
+    OrderPtr order = std::make_shared<Order>(user_id, is_bid, price, qty, funds, stop_price);
+    order->order_id(order_id);
+    order->stp(stp);
+    return order;
+  }
+};
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::RoutableTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::RoutableTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::BasicME<
+  book::Journaled<book::LadderStorage, Codec>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>
+> Book;
+
+typedef fixtures::BasicME<
+  book::Journaled<book::MapStorage, Codec>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::RoutablePlugin<Tracker>
+> RoutingBook_;
+
+/* routing requests are answered later, by the test */
+class RoutingBook : public RoutingBook_ {
+public:
+  typedef book::plugins::RoutablePlugin<Tracker>::RoutingRequest RoutingRequest;
+
+  RoutingBook() : RoutingBook_(SYMBOL_ID_1) { register_market_maker(MM_ID, MM_EXCHANGE); }
+
+  void answer(uint64_t request_id, bool success) {
+    if(success) on_routing_success(request_id);
+    else on_routing_failure(request_id);
+  }
+
+  void answer_partial(uint64_t request_id, double filled_qty) {
+    on_routing_partial_success(request_id, filled_qty);
+  }
+
+  std::vector<uint64_t> requests;
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    requests.push_back(request.request_id);
+  }
+};
+
+const char* PATH = "journal_test.journal";
+
+template <class Callbacks>
+void check_same(const Callbacks& a, const Callbacks& b) {
+  REQUIRE(a.size() == b.size());
+
+  for(size_t i = 0; i < a.size(); ++i) {
+    CHECK(a[i].type == b[i].type);
+    CHECK(a[i].reason == b[i].reason);
+    CHECK(a[i].scope == b[i].scope);
+    CHECK(a[i].qty == b[i].qty);
+    CHECK(a[i].price == b[i].price);
+    if(a[i].order) CHECK(a[i].order->order_id() == b[i].order->order_id());
+    if(a[i].maker_order) CHECK(a[i].maker_order->order_id() == b[i].maker_order->order_id());
+  }
+}
+
+template <class B>
+void check_same_book(const B& a, const B& b) {
+  REQUIRE(a.order_count() == b.order_count());
+  CHECK(a.market_price() == b.market_price());
+
+  for(auto ia = a.bids().begin(), ib = b.bids().begin(); ia != a.bids().end(); ++ia, ++ib) {
+    CHECK(ia->first.price() == ib->first.price());
+    CHECK(ia->second.ptr()->order_id() == ib->second.ptr()->order_id());
+    CHECK(ia->second.open_qty() == ib->second.open_qty());
+  }
+
+  for(auto ia = a.asks().begin(), ib = b.asks().begin(); ia != a.asks().end(); ++ia, ++ib) {
+    CHECK(ia->first.price() == ib->first.price());
+    CHECK(ia->second.ptr()->order_id() == ib->second.ptr()->order_id());
+    CHECK(ia->second.open_qty() == ib->second.open_qty());
+  }
+}
+
+/* adds, cancels, replaces and market prices at random */
+void run_session(Book& book, int n, unsigned seed, uint64_t first_id = 0) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> action(0, 19);
+  std::uniform_int_distribution<int> tick(-20, 20);
+  std::uniform_int_distribution<int> lots(1, 20);
+  std::vector<OrderPtr> orders;
+
+  for(int i = 0; i < n; ++i) {
+    int a = action(rng);
+
+    if(a < 4 && !orders.empty())
+      book.cancel(orders[rng() % orders.size()], book::user_cancel);
+
+    else if(a < 6 && !orders.empty())
+      book.replace(orders[rng() % orders.size()], tick(rng) / 4);
+
+    else if(a == 6)
+      book.set_market_price(1000 + tick(rng));
+
+    else {
+      double price = a == 19 ? 0 : 1000 + tick(rng);
+      double stop_price = a == 18 ? 1000 + tick(rng) : 0;
+      OrderPtr order = std::make_shared<Order>(
+        1 + rng() % 4, rng() & 1, price, lots(rng), 0, stop_price);
+      order->order_id(utils::uint128(0, first_id + i));
+
+      orders.push_back(order);
+      book.add(order);
+    }
+  }
+}
+
+TEST_CASE("journal replay rebuilds the book") {
+  Book book(SYMBOL_ID_1);
+  book.start_recording_callbacks();
+
+  {
+    book::JournalWriter writer(PATH, SYMBOL_ID_1, 1, 4096);
+    book.journal().attach(&writer);
+    run_session(book, 3000, 42);
+    writer.flush();
+
+    /* a small ring fills up, appends wait for the writer */
+    CHECK(writer.stalls() > 0);
+    CHECK(writer.next_seq() > 3000);
+    book.journal().detach();
+  }
+
+  Book::Callbacks recorded = book.get_recorded_callbacks();
+
+  SUBCASE("replay delivers the same callbacks") {
+    book::JournalReader reader(PATH);
+    CHECK(reader.symbol_id() == SYMBOL_ID_1);
+
+    Book replayed(SYMBOL_ID_1);
+    replayed.start_recording_callbacks();
+
+    book::JournalReplayer<Book> replayer(replayed);
+    CHECK(replayer.replay(reader) == 3000);
+    CHECK(replayer.last_seq() == 3000);
+
+    check_same(recorded, replayed.get_recorded_callbacks());
+    check_same_book(book, replayed);
+  }
+
+  SUBCASE("fast forward rebuilds the state without callbacks") {
+    book::JournalReader reader(PATH);
+    Book replayed(SYMBOL_ID_1);
+    book::JournalReplayer<Book> replayer(replayed);
+
+    replayed.start_recording_callbacks();
+    CHECK(replayer.fast_forward(reader, 1000) == 1000);
+    CHECK(replayed.get_recorded_callbacks().empty());
+
+    CHECK(replayer.fast_forward(reader) == 2000);
+    CHECK(replayed.get_recorded_callbacks().empty());
+    check_same_book(book, replayed);
+
+    /* and callbacks are delivered again */
+    replayed.add(std::make_shared<Order>(USER_1, BUY, 1, 1, 0));
+    CHECK(!replayed.get_recorded_callbacks().empty());
+  }
+
+  SUBCASE("a replayed book continues the journal") {
+    Book replayed(SYMBOL_ID_1);
+    book::JournalReplayer<Book> replayer(replayed);
+    {
+      book::JournalReader reader(PATH);
+      replayer.fast_forward(reader);
+    }
+
+    {
+      book::JournalWriter writer(PATH, SYMBOL_ID_1, replayer.last_seq() + 1);
+      replayed.journal().attach(&writer);
+      run_session(replayed, 500, 7, 100000);
+      replayed.journal().detach();
+    }
+
+    Book again(SYMBOL_ID_1);
+    book::JournalReader reader(PATH);
+    book::JournalReplayer<Book> again_replayer(again);
+    CHECK(again_replayer.fast_forward(reader) == 3500);
+    check_same_book(replayed, again);
+  }
+
+  std::remove(PATH);
+}
+
+/* counts deliveries on top of recording callbacks */
+class BatchBook : public Book {
+public:
+  BatchBook() : Book(SYMBOL_ID_1), deliveries(0) {}
+
+  size_t deliveries;
+
+  void on_callbacks(const Book::Base::Callbacks& callbacks) {
+    ++deliveries;
+    Book::on_callbacks(callbacks);
+  }
+};
+
+TEST_CASE("batches are replayed as batches") {
+  BatchBook book;
+  book.start_recording_callbacks();
+
+  std::vector<OrderPtr> asks, bids;
+  for(int i = 0; i < 4; ++i) {
+    asks.push_back(std::make_shared<Order>(USER_1, SELL, 100 + i, 1, 0));
+    asks.back()->order_id(utils::uint128(0, i));
+    bids.push_back(std::make_shared<Order>(USER_2, BUY, 98 - i, 1, 0));
+    bids.back()->order_id(utils::uint128(1, i));
+  }
+
+  OrderPtr taker = std::make_shared<Order>(USER_2, BUY, 101, 3, 0);
+  taker->order_id(utils::uint128(2, 0));
+
+  {
+    book::JournalWriter writer(PATH, SYMBOL_ID_1);
+    book.journal().attach(&writer);
+
+    book.add_batch(asks.begin(), asks.end());
+    book.add_batch(bids.begin(), bids.end(), false);
+    book.add(taker);
+    book.cancel_batch(bids.begin(), bids.begin() + 2, book::user_cancel, false);
+    book.cancel_batch(asks.begin() + 2, asks.end(), book::user_cancel);
+
+    writer.flush();
+    book.journal().detach();
+  }
+
+  Book::Callbacks recorded = book.get_recorded_callbacks();
+  CHECK(book.deliveries == 5);
+
+  BatchBook replayed;
+  replayed.start_recording_callbacks();
+
+  book::JournalReader reader(PATH);
+  book::JournalReplayer<BatchBook> replayer(replayed);
+  CHECK(replayer.replay(reader) == 4 * 2 + 8 + 1 + 4);
+
+  CHECK(replayed.deliveries == 5);
+  check_same(recorded, replayed.get_recorded_callbacks());
+  check_same_book(book, replayed);
+
+  std::remove(PATH);
+}
+
+TEST_CASE("a record cut short by a crash ends the journal") {
+  {
+    Book book(SYMBOL_ID_1);
+    book::JournalWriter writer(PATH, SYMBOL_ID_1);
+    book.journal().attach(&writer);
+
+    for(int i = 0; i < 3; ++i) {
+      OrderPtr order = std::make_shared<Order>(USER_1, SELL, 100 + i, 1, 0);
+      order->order_id(utils::uint128(0, i));
+      book.add(order);
+    }
+  }
+
+  FILE* file = fopen(PATH, "rb");
+  std::vector<char> data(1 << 12);
+  data.resize(fread(&data[0], 1, data.size(), file));
+  fclose(file);
+
+  file = fopen(PATH, "wb");
+  fwrite(&data[0], 1, data.size() - 5, file);
+  fclose(file);
+
+  book::JournalReader reader(PATH);
+  Book replayed(SYMBOL_ID_1);
+  book::JournalReplayer<Book> replayer(replayed);
+
+  CHECK(replayer.replay(reader) == 2);
+  CHECK(replayed.asks().size() == 2);
+
+  std::remove(PATH);
+}
+
+TEST_CASE("a failed journal write stops the book") {
+  /* every write to /dev/full fails with ENOSPC */
+  FILE* full = fopen("/dev/full", "wb");
+  if(!full) return;
+  fclose(full);
+
+  Book book(SYMBOL_ID_1);
+  book::JournalWriter writer("/dev/full", SYMBOL_ID_1);
+  book.journal().attach(&writer);
+
+  OrderPtr order = std::make_shared<Order>(USER_1, SELL, 100, 1, 0);
+  order->order_id(utils::uint128(0, 0));
+  book.add(order);
+
+  CHECK(!writer.failed());
+  CHECK_THROWS_AS(writer.flush(), book::JournalException);
+  CHECK(writer.failed());
+
+  /* the input is refused before it reaches the book */
+  order = std::make_shared<Order>(USER_1, SELL, 101, 1, 0);
+  order->order_id(utils::uint128(0, 1));
+  CHECK_THROWS_AS(book.add(order), book::JournalException);
+  CHECK(book.asks().size() == 1);
+
+  book.journal().detach();
+}
+
+TEST_CASE("routing responses are journaled") {
+  RoutingBook book;
+  book.start_recording_callbacks();
+
+  {
+    book::JournalWriter writer(PATH, SYMBOL_ID_1);
+    book.journal().attach(&writer);
+
+    for(int i = 0; i < 3; ++i) {
+      OrderPtr maker = std::make_shared<Order>(MM_ID, SELL, 1000, 1, 0);
+      maker->order_id(utils::uint128(1, i));
+      book.add(maker);
+
+      OrderPtr taker = std::make_shared<Order>(USER_1, BUY, 1000, 2, 0);
+      taker->order_id(utils::uint128(2, i));
+      book.add(taker);
+    }
+
+    OrderPtr maker = std::make_shared<Order>(MM_ID, SELL, 1000, 2, 0);
+    maker->order_id(utils::uint128(1, 3));
+    book.add(maker);
+
+    OrderPtr taker = std::make_shared<Order>(USER_1, BUY, 1000, 2, 0);
+    taker->order_id(utils::uint128(2, 3));
+    book.add(taker);
+
+    /* request ids are a sequence of the book */
+    REQUIRE(book.requests == std::vector<uint64_t>({ 1, 2, 3, 4 }));
+
+    book.answer(2, false);
+    book.answer(1, true);
+    book.answer_partial(4, 0.5);
+    book.answer(3, true);
+  }
+
+  RoutingBook replayed;
+  replayed.start_recording_callbacks();
+
+  book::JournalReader reader(PATH);
+  book::JournalReplayer<RoutingBook> replayer(replayed);
+  CHECK(replayer.replay(reader) == 12);
+
+  CHECK(replayed.requests == book.requests);
+  check_same(book.get_recorded_callbacks(), replayed.get_recorded_callbacks());
+  check_same_book(book, replayed);
+
+  std::remove(PATH);
+}
+
+}
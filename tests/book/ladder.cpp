@@ -0,0 +1,219 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <book/types.h>
+#include <book/price_ladder.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+#include "fixtures/helpers.h"
+
+namespace ladder_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithStopPrice Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>
+> MapBook;
+
+typedef fixtures::LadderME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>
+> LadderBook;
+
+typedef book::PriceLadder<Tracker> Ladder;
+
+TEST_CASE("price ladder") {
+  Ladder bids;
+
+  auto o1 = std::make_shared<Order>(USER_1, BUY, 100, 1, 0);
+  auto o2 = std::make_shared<Order>(USER_1, BUY, 101, 1, 0);
+  auto o3 = std::make_shared<Order>(USER_1, BUY, 100, 1, 0);
+  auto o4 = std::make_shared<Order>(USER_1, BUY, 99, 1, 0);
+
+  bids.emplace(book::BookPrice(BUY, 100), Tracker(o1));
+  bids.emplace(book::BookPrice(BUY, 101), Tracker(o2));
+  bids.emplace(book::BookPrice(BUY, 100), Tracker(o3));
+  bids.emplace(book::BookPrice(BUY, 99), Tracker(o4));
+
+  CHECK(bids.size() == 4);
+  CHECK(bids.level_count() == 3);
+
+  SUBCASE("iterates by price then time") {
+    std::vector<OrderPtr> expected = { o2, o1, o3, o4 };
+    std::vector<OrderPtr> actual;
+
+    for(auto it = bids.begin(); it != bids.end(); ++it)
+      actual.push_back(it->second.ptr());
+
+    CHECK(actual == expected);
+  }
+
+  SUBCASE("find returns the oldest order of the level") {
+    auto it = bids.find(book::BookPrice(BUY, 100));
+    REQUIRE(it != bids.end());
+    CHECK(it->second.ptr() == o1);
+    CHECK(it->first.price() == 100);
+
+    CHECK(bids.find(book::BookPrice(BUY, 98)) == bids.end());
+  }
+
+  SUBCASE("erasing the last order of a level drops the level") {
+    auto it = bids.erase(bids.begin());
+    CHECK(it->second.ptr() == o1);
+    CHECK(bids.size() == 3);
+    CHECK(bids.level_count() == 2);
+    CHECK(bids.find(book::BookPrice(BUY, 101)) == bids.end());
+
+    /* erasing in the middle of a FIFO keeps its order */
+    it = bids.erase(bids.find(book::BookPrice(BUY, 100)));
+    CHECK(it->second.ptr() == o3);
+    CHECK(bids.level_count() == 2);
+
+    bids.erase(it);
+    CHECK(bids.level_count() == 1);
+    CHECK(bids.begin()->second.ptr() == o4);
+
+    bids.erase(bids.begin());
+    CHECK(bids.empty());
+    CHECK(bids.begin() == bids.end());
+  }
+
+  SUBCASE("asks are sorted ascending") {
+    Ladder asks;
+    asks.emplace(book::BookPrice(SELL, 102), Tracker(std::make_shared<Order>(USER_1, SELL, 102, 1, 0)));
+    asks.emplace(book::BookPrice(SELL, 101), Tracker(std::make_shared<Order>(USER_1, SELL, 101, 1, 0)));
+    asks.emplace(book::BookPrice(SELL, 103), Tracker(std::make_shared<Order>(USER_1, SELL, 103, 1, 0)));
+
+    std::vector<double> prices;
+    for(auto it = asks.begin(); it != asks.end(); ++it)
+      prices.push_back(it->first.price());
+
+    CHECK(prices == std::vector<double>({ 101, 102, 103 }));
+  }
+}
+
+TEST_CASE("orders of a level are stored together") {
+  Ladder bids;
+
+  std::vector<const Tracker*> trackers;
+  for(int i = 0; i < 4; ++i) {
+    auto it = bids.emplace(book::BookPrice(BUY, 100),
+      Tracker(std::make_shared<Order>(USER_1, BUY, 100, 1, 0)));
+    trackers.push_back(&it->second);
+  }
+
+  /* the first chunk of a level holds 4 consecutive nodes */
+  ptrdiff_t stride = (const char*) trackers[1] - (const char*) trackers[0];
+  CHECK(stride > 0);
+  CHECK((const char*) trackers[3] - (const char*) trackers[0] == 3 * stride);
+
+  /* filled and cancelled slots are reused by the level */
+  bids.erase(bids.begin());
+  auto it = bids.emplace(book::BookPrice(BUY, 100),
+    Tracker(std::make_shared<Order>(USER_1, BUY, 100, 1, 0)));
+  CHECK(&it->second == trackers[0]);
+
+  /* and the FIFO is unchanged */
+  std::vector<const Tracker*> actual;
+  for(auto it = bids.begin(); it != bids.end(); ++it)
+    actual.push_back(&it->second);
+
+  CHECK(actual == std::vector<const Tracker*>({ trackers[1], trackers[2], trackers[3], trackers[0] }));
+}
+
+TEST_CASE("ladder storage matches like the multimap storage") {
+  MapBook map_book(SYMBOL_ID_1);
+  LadderBook ladder_book(SYMBOL_ID_1);
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> action(0, 9);
+  std::uniform_int_distribution<int> tick(-20, 20);
+  std::uniform_int_distribution<int> lots(1, 20);
+  std::uniform_int_distribution<int> user(1, 4);
+
+  std::vector<OrderPtr> orders;
+
+  map_book.start_recording_callbacks();
+  ladder_book.start_recording_callbacks();
+
+  for(int i = 0; i < 5000; ++i) {
+    int a = action(rng);
+
+    if(a < 2 && !orders.empty()) {
+      OrderPtr order = orders[rng() % orders.size()];
+      map_book.cancel(order, book::user_cancel);
+      ladder_book.cancel(order, book::user_cancel);
+    }
+
+    else if(a < 3 && !orders.empty()) {
+      OrderPtr order = orders[rng() % orders.size()];
+      double delta = tick(rng) / 4;
+      map_book.replace(order, delta);
+      ladder_book.replace(order, delta);
+    }
+
+    else {
+      bool is_bid = rng() & 1;
+      double price = a == 9 ? 0 : 1000 + tick(rng);
+      double stop_price = a == 8 ? 1000 + tick(rng) : 0;
+      OrderPtr order = std::make_shared<Order>(
+        user(rng), is_bid, price, lots(rng), 0, stop_price);
+      order->order_id(utils::uint128(0, i));
+
+      orders.push_back(order);
+      map_book.add(order);
+      ladder_book.add(order);
+    }
+
+    REQUIRE(map_book.bids().size() == ladder_book.bids().size());
+    REQUIRE(map_book.asks().size() == ladder_book.asks().size());
+  }
+
+  MapBook::Callbacks map_cbs = map_book.get_recorded_callbacks();
+  LadderBook::Callbacks ladder_cbs = ladder_book.get_recorded_callbacks();
+
+  REQUIRE(map_cbs.size() == ladder_cbs.size());
+
+  for(size_t i = 0; i < map_cbs.size(); ++i) {
+    CHECK(map_cbs[i].type == ladder_cbs[i].type);
+    CHECK(map_cbs[i].reason == ladder_cbs[i].reason);
+    CHECK(map_cbs[i].order == ladder_cbs[i].order);
+    CHECK(map_cbs[i].maker_order == ladder_cbs[i].maker_order);
+    CHECK(map_cbs[i].qty == ladder_cbs[i].qty);
+    CHECK(map_cbs[i].price == ladder_cbs[i].price);
+  }
+
+  auto mit = map_book.bids().begin();
+  auto lit = ladder_book.bids().begin();
+  for(; mit != map_book.bids().end(); ++mit, ++lit) {
+    CHECK(mit->first.price() == lit->first.price());
+    CHECK(mit->second.ptr() == lit->second.ptr());
+  }
+}
+
+}
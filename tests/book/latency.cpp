@@ -0,0 +1,144 @@
+#include <doctest/doctest.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <book/types.h>
+#include <book/latency.h>
+#include <book/plugins/self_trade_policy.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace latency_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::BasicME<
+  book::Instrumented<book::LadderStorage>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>
+> Book;
+
+typedef fixtures::LadderME<
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>
+> PlainBook;
+
+static_assert(std::is_empty<PlainBook::LatencyRecorder>::value,
+  "books are not instrumented by default");
+
+TEST_CASE("latency histogram") {
+  book::LatencyHistogram histogram;
+
+  CHECK(histogram.count() == 0);
+  CHECK(histogram.percentile(50) == 0);
+
+  SUBCASE("buckets cover values without gaps") {
+    for(uint64_t v = 0; v < 100000; v += 7) {
+      unsigned b = book::LatencyHistogram::bucket_of(v);
+      CHECK(book::LatencyHistogram::lowest_of(b) <= v);
+      CHECK(v < book::LatencyHistogram::lowest_of(b) + book::LatencyHistogram::width_of(b));
+    }
+
+    CHECK(book::LatencyHistogram::bucket_of((uint64_t) 1 << 50) ==
+      book::LatencyHistogram::BUCKETS - 1);
+  }
+
+  SUBCASE("percentiles are within a sub-bucket") {
+    for(uint64_t v = 1; v <= 1000; ++v)
+      histogram.record(v * 100);
+
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.max() == 100000);
+    CHECK(histogram.mean() == doctest::Approx(50050));
+
+    uint64_t p50 = histogram.percentile(50);
+    CHECK(p50 >= 50000);
+    CHECK(p50 <= 50000 + 50000 / 16);
+
+    CHECK(histogram.percentile(99.9) >= 99900);
+    CHECK(histogram.percentile(100) == 100000);
+    CHECK(histogram.percentile(0) <= 100 + 100 / 16);
+  }
+}
+
+TEST_CASE("instrumented books time operations and hooks") {
+  Book book(SYMBOL_ID_1);
+  const Book::LatencyRecorder& latency = book.latency();
+
+  std::vector<OrderPtr> asks;
+  for(int i = 0; i < 10; ++i) {
+    asks.push_back(std::make_shared<Order>(USER_1, SELL, 100 + i, 1, 0));
+    book.add(asks.back());
+  }
+
+  book.add(std::make_shared<Order>(USER_2, BUY, 102, 3, 0));
+  book.cancel(asks[5], book::user_cancel);
+  book.replace(asks[6], 1);
+  book.cancel_batch(asks.begin() + 7, asks.end(), book::user_cancel);
+
+  CHECK(latency.op(book::latency_add).count() == 11);
+  CHECK(latency.op(book::latency_cancel).count() == 1);
+  CHECK(latency.op(book::latency_replace).count() == 1);
+  CHECK(latency.op(book::latency_cancel_batch).count() == 1);
+  CHECK(latency.op(book::latency_add_batch).count() == 0);
+
+  /* every add matches, only the buy finds makers */
+  CHECK(latency.op(book::latency_match).count() == 11);
+  CHECK(latency.op(book::latency_add).max() >= latency.op(book::latency_match).max());
+
+  /* SelfTradePolicyPlugin only implements should_trade */
+  CHECK(latency.hook(0, book::hook_should_trade).count() == 3);
+  CHECK(latency.hook(0, book::hook_should_add).count() == 0);
+  CHECK(latency.hook(0, book::hook_after_trade).count() == 0);
+}
+
+TEST_CASE("latencies are read while the book runs") {
+  Book book(SYMBOL_ID_1);
+  const Book::LatencyRecorder& latency = book.latency();
+
+  std::atomic<bool> done(false);
+  uint64_t last_count = 0;
+  bool monotonic = true;
+
+  std::thread reader([&]() {
+    while(!done.load()) {
+      uint64_t count = latency.op(book::latency_add).count();
+      monotonic &= count >= last_count;
+      last_count = count;
+      latency.op(book::latency_add).percentile(99);
+    }
+  });
+
+  for(int i = 0; i < 2000; ++i) {
+    book.add(std::make_shared<Order>(USER_1, SELL, 100 + i % 10, 1, 0));
+    book.add(std::make_shared<Order>(USER_2, BUY, 0, 1, 0));
+  }
+
+  done = true;
+  reader.join();
+
+  CHECK(monotonic);
+  CHECK(latency.op(book::latency_add).count() == 4000);
+}
+
+}
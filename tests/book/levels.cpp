@@ -0,0 +1,185 @@
+#include <doctest/doctest.h>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <book/types.h>
+#include <book/levels.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace levels_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithStopPrice Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order) {}
+};
+
+template <class Storage>
+using Book = fixtures::BasicME<Storage, Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>>;
+
+/* the aggregates of a side, by walking its trackers */
+template <class Side>
+std::map<double, book::Level<double>> walk(const Side& side) {
+  std::map<double, book::Level<double>> levels;
+  for(auto it = side.begin(); it != side.end(); ++it) {
+    book::Level<double>& level = levels[it->first.price()];
+    level.qty += it->second.qty_on_book();
+    ++level.orders;
+  }
+  return levels;
+}
+
+template <class B, class Side>
+bool matches_walk(const B& book, const Side& side, bool is_bid) {
+  std::map<double, book::Level<double>> levels = walk(side);
+  const typename B::Levels& aggregates = book.levels(is_bid);
+
+  double qty = 0;
+  bool same = aggregates.level_count() == levels.size() && aggregates.orders() == side.size();
+
+  for(auto it = levels.begin(); it != levels.end(); ++it) {
+    book::Level<double> level = book.level(is_bid, it->first);
+    same &= level.qty == it->second.qty && level.orders == it->second.orders;
+    qty += it->second.qty;
+  }
+
+  same &= book.side_qty(is_bid) == qty;
+
+  if(side.size() == 0)
+    return same && aggregates.best_price() == 0 && aggregates.best_qty() == 0;
+
+  double best = side.begin()->first.price();
+  return same && aggregates.best_price() == best &&
+    aggregates.best_qty() == levels[best].qty && aggregates.best_orders() == levels[best].orders;
+}
+
+TEST_CASE_TEMPLATE("top of book and levels", Storage, book::MapStorage, book::LadderStorage) {
+  Book<Storage> book(SYMBOL_ID_1);
+
+  CHECK(book.best_bid() == 0);
+  CHECK(book.best_ask() == 0);
+  CHECK(book.side_qty(BUY) == 0);
+
+  auto b1 = std::make_shared<Order>(USER_1, BUY, 99, 2, 0);
+  auto b2 = std::make_shared<Order>(USER_1, BUY, 100, 3, 0);
+  auto b3 = std::make_shared<Order>(USER_1, BUY, 100, 1, 0);
+  auto a1 = std::make_shared<Order>(USER_1, SELL, 102, 5, 0);
+
+  book.add(b1);
+  book.add(b2);
+  book.add(b3);
+  book.add(a1);
+
+  CHECK(book.best_bid() == 100);
+  CHECK(book.best_bid_qty() == 4);
+  CHECK(book.levels(BUY).best_orders() == 2);
+  CHECK(book.best_ask() == 102);
+  CHECK(book.best_ask_qty() == 5);
+  CHECK(book.level(BUY, 99).qty == 2);
+  CHECK(book.level(BUY, 98).orders == 0);
+  CHECK(book.side_qty(BUY) == 6);
+  CHECK(book.levels(BUY).level_count() == 2);
+
+  SUBCASE("trades take qty off the level") {
+    book.add(std::make_shared<Order>(USER_2, SELL, 100, 3.5, 0));
+
+    CHECK(book.best_bid() == 100);
+    CHECK(book.best_bid_qty() == 0.5);
+    CHECK(book.levels(BUY).best_orders() == 1);
+    CHECK(book.side_qty(BUY) == 2.5);
+
+    /* the level empties, the next one is the best */
+    book.add(std::make_shared<Order>(USER_2, SELL, 0, 1, 0));
+    CHECK(book.best_bid() == 99);
+    CHECK(book.best_bid_qty() == 1.5);
+    CHECK(book.level(BUY, 100).orders == 0);
+  }
+
+  SUBCASE("replaces change the level") {
+    book.replace(b2, 2);
+    CHECK(book.best_bid_qty() == 6);
+
+    book.replace(b3, -1);
+    CHECK(book.best_bid_qty() == 5);
+    CHECK(book.levels(BUY).best_orders() == 1);
+  }
+
+  SUBCASE("cancels") {
+    book.cancel(b2, book::user_cancel);
+    book.cancel(b3, book::user_cancel);
+    CHECK(book.best_bid() == 99);
+
+    book.cancel(b1, book::user_cancel);
+    book.cancel(a1, book::user_cancel);
+    CHECK(book.best_bid() == 0);
+    CHECK(book.best_ask() == 0);
+    CHECK(book.side_qty(BUY) == 0);
+    CHECK(book.levels(SELL).level_count() == 0);
+  }
+
+  SUBCASE("better prices become the best") {
+    book.add(std::make_shared<Order>(USER_1, BUY, 101, 1, 0));
+    book.add(std::make_shared<Order>(USER_1, SELL, 101.5, 1, 0));
+    CHECK(book.best_bid() == 101);
+    CHECK(book.best_ask() == 101.5);
+  }
+}
+
+TEST_CASE_TEMPLATE("aggregates match the trackers", Storage, book::MapStorage, book::LadderStorage) {
+  Book<Storage> book(SYMBOL_ID_1);
+
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> action(0, 9);
+  std::uniform_int_distribution<int> tick(-15, 15);
+  std::uniform_int_distribution<int> lots(1, 20);
+  std::uniform_int_distribution<int> user(1, 4);
+
+  std::vector<OrderPtr> orders;
+  bool same = true;
+
+  for(int i = 0; i < 5000; ++i) {
+    int a = action(rng);
+
+    if(a < 2 && !orders.empty())
+      book.cancel(orders[rng() % orders.size()], book::user_cancel);
+
+    else if(a < 3 && !orders.empty())
+      book.replace(orders[rng() % orders.size()], tick(rng));
+
+    else {
+      bool is_bid = rng() & 1;
+      double price = a == 9 ? 0 : 1000 + tick(rng);
+      double stop_price = a == 8 ? 1000 + tick(rng) : 0;
+      orders.push_back(std::make_shared<Order>(user(rng), is_bid, price, lots(rng), 0, stop_price));
+      book.add(orders.back());
+    }
+
+    same &= matches_walk(book, book.bids(), BUY);
+    same &= matches_walk(book, book.asks(), SELL);
+  }
+
+  CHECK(same);
+  CHECK(book.order_count() > 0);
+}
+
+}
@@ -0,0 +1,120 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <type_traits>
+
+#include <book/types.h>
+#include <book/ob.h>
+#include <book/plugin.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace plugin_hooks_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+typedef book::BaseTracker<OrderPtr> Tracker;
+
+/* implements a single hook */
+template <class Tracker, class Book = book::UnboundBook>
+class TradeCounterPlugin :
+  public book::Plugin<Tracker, Book, TradeCounterPlugin<Tracker, Book>> {
+public:
+  size_t trades = 0;
+
+protected:
+  void after_trade(Tracker& taker, Tracker& maker,
+    bool maker_is_bid, double qty, double price) {
+    ++trades;
+  }
+};
+
+/* implements every hook, and cancels the taker once it traded twice */
+template <class Tracker, class Book = book::UnboundBook>
+class HookCounterPlugin :
+  public book::Plugin<Tracker, Book, HookCounterPlugin<Tracker, Book>> {
+public:
+  size_t should_add_calls = 0;
+  size_t should_add_tracker_calls = 0;
+  size_t after_add_tracker_calls = 0;
+  size_t should_trade_calls = 0;
+  size_t after_trade_calls = 0;
+  size_t market_price_changes = 0;
+
+protected:
+  void should_add(const Tracker& taker, book::InsertRejectReasons& reason) {
+    ++should_add_calls;
+  }
+
+  bool should_add_tracker(const Tracker& taker) {
+    ++should_add_tracker_calls;
+    return true;
+  }
+
+  void after_add_tracker(const Tracker& taker) {
+    ++after_add_tracker_calls;
+  }
+
+  void should_trade(Tracker& taker, Tracker& maker,
+    book::CancelReasons& taker_reason, book::CancelReasons& maker_reason) {
+    if(should_trade_calls++ == 2)
+      taker_reason = book::self_trade;
+  }
+
+  void after_trade(Tracker& taker, Tracker& maker,
+    bool maker_is_bid, double qty, double price) {
+    ++after_trade_calls;
+  }
+
+  void on_market_price_change(double prev_price, double new_price) {
+    ++market_price_changes;
+  }
+};
+
+typedef fixtures::ME<
+  Tracker,
+  TradeCounterPlugin<Tracker>,
+  HookCounterPlugin<Tracker>
+> Book;
+
+/* plugins without virtual hooks add no vtable to the book */
+static_assert(!std::is_polymorphic<TradeCounterPlugin<Tracker, Book::Base>>::value,
+  "plugin hooks are resolved statically");
+
+TEST_CASE("plugin hooks are resolved at compile time") {
+  Book book(SYMBOL_ID_1);
+
+  for(int i = 0; i < 5; ++i)
+    book.add(std::make_shared<Order>(USER_1, SELL, 100 + i, 1, 0));
+
+  CHECK(book.should_add_calls == 5);
+  CHECK(book.should_add_tracker_calls == 5);
+  CHECK(book.after_add_tracker_calls == 5);
+  CHECK(book.should_trade_calls == 0);
+
+  book.start_recording_callbacks();
+  book.add(std::make_shared<Order>(USER_2, BUY, 0, 5, 0));
+  Book::Callbacks cb = book.get_recorded_callbacks();
+
+  /* the third maker is refused by the hook, which cancels the taker */
+  CHECK(book.should_trade_calls == 3);
+  CHECK(book.after_trade_calls == 2);
+  CHECK(book.trades == 2);
+  CHECK(book.market_price_changes == 2);
+  CHECK(book.asks().size() == 3);
+
+  bool taker_cancelled = false;
+  for(auto it = cb.begin(); it != cb.end(); ++it)
+    taker_cancelled |= it->type == Book::TypedCallback::cb_order_cancel &&
+      it->reason == book::self_trade;
+
+  CHECK(taker_cancelled);
+}
+
+}
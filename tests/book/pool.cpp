@@ -0,0 +1,130 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <vector>
+
+#include <book/arena.h>
+#include <book/pool.h>
+
+namespace pool_test {
+
+/* neither default constructible nor assignable, counts the live ones */
+struct Item {
+  Item(int value_, int& live_) : value(value_), live(live_) { ++live; }
+  Item(const Item& other) : value(other.value), live(other.live) { ++live; }
+  ~Item() { --live; }
+
+  Item& operator=(const Item&) = delete;
+
+  const int value;
+  int& live;
+};
+
+typedef book::Pool<Item> Pool;
+
+TEST_CASE("pool") {
+  book::BookArena arena;
+  int live = 0;
+
+  {
+    Pool pool(&arena);
+
+    Pool::Handle a = pool.make(1, live);
+    Pool::Handle b = pool.make(2, live);
+    CHECK(pool.size() == 2);
+    CHECK(live == 2);
+    CHECK(pool[a].value == 1);
+    CHECK(pool[b].value == 2);
+
+    SUBCASE("released slots are made again") {
+      pool.release(a);
+      CHECK(live == 1);
+      CHECK(pool.size() == 1);
+
+      Pool::Handle c = pool.make(3, live);
+      CHECK(c == a);
+      CHECK(pool[c].value == 3);
+      CHECK(pool.capacity() == 2);
+    }
+
+    SUBCASE("objects do not move as the pool grows") {
+      const Item* first = &pool[a];
+
+      std::vector<Pool::Handle> handles;
+      for(int i = 0; i < 1000; ++i)
+        handles.push_back(pool.make(i, live));
+
+      CHECK(&pool[a] == first);
+      CHECK(pool[a].value == 1);
+      CHECK(pool[handles[999]].value == 999);
+    }
+
+    SUBCASE("remade in place") {
+      const Item* item = &pool[b];
+      pool.remake(b, 4, live);
+
+      CHECK(&pool[b] == item);
+      CHECK(pool[b].value == 4);
+      CHECK(live == 2);
+    }
+
+    SUBCASE("live objects in order of slot") {
+      pool.release(a);
+      pool.make(5, live);
+      pool.make(6, live);
+
+      std::vector<int> values;
+      pool.for_each([&](Pool::Handle, const Item& item) { values.push_back(item.value); });
+      CHECK(values == std::vector<int>({ 5, 2, 6 }));
+    }
+
+    SUBCASE("reserved slots are made without growing") {
+      pool.reserve(100);
+      uint64_t allocations = arena.counters().allocations;
+
+      for(int i = 0; i < 98; ++i)
+        pool.make(i, live);
+
+      CHECK(pool.capacity() == 100);
+      CHECK(arena.counters().allocations == allocations);
+
+      pool.clear();
+      CHECK(pool.empty());
+      CHECK(live == 0);
+    }
+  }
+
+  /* the pool destroys what is left */
+  CHECK(live == 0);
+}
+
+TEST_CASE("fixed buffer") {
+  book::FixedBuffer<std::shared_ptr<int>, 4> buffer;
+  std::shared_ptr<int> value = std::make_shared<int>(1);
+
+  buffer.push_back(value);
+  buffer.push_back(value);
+  CHECK(buffer.size() == 2);
+  CHECK(!buffer.full());
+  CHECK(value.use_count() == 3);
+
+  /* copies by value, inline */
+  book::FixedBuffer<std::shared_ptr<int>, 4> copy = buffer;
+  CHECK(copy.size() == 2);
+  CHECK(value.use_count() == 5);
+
+  copy.push_back(value);
+  copy.push_back(value);
+  CHECK(copy.full());
+  CHECK(copy.end() - copy.begin() == 4);
+
+  /* never past the end */
+  CHECK_THROWS_AS(copy.push_back(value), std::length_error);
+  CHECK(copy.size() == 4);
+
+  /* lets go of what it held */
+  copy.clear();
+  CHECK(copy.empty());
+  CHECK(value.use_count() == 3);
+}
+
+}
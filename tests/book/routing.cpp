@@ -57,7 +57,8 @@ class Book : public Book_ {
 public:
   typedef book::plugins::RoutablePlugin<Tracker>::RoutingRequest RoutingRequest;
 
-  Book(uint32_t symbol_id) : Book_(symbol_id), routing_scenario(ROUTING_SUCCESS) {
+  Book(uint32_t symbol_id) : Book_(symbol_id), routing_scenario(ROUTING_SUCCESS),
+    answer_on_callbacks(0) {
     register_market_maker(MM1_ID, MM1_EXCHANGE);
     register_market_maker(MM2_ID, MM2_EXCHANGE);
   }
@@ -72,6 +73,16 @@ public:
     return routing_requests_.size();
   }
 
+  /* a response from the venue, after on_routing_request() returned */
+  void respond(uint64_t request_id, bool success) {
+    if(success) on_routing_success(request_id);
+    else on_routing_failure(request_id);
+  }
+
+  void respond_partial(uint64_t request_id, double filled_qty) {
+    on_routing_partial_success(request_id, filled_qty);
+  }
+
   void clear_routing_requests() {
     std::stack<RoutingRequest> routing_requests;
     routing_requests_.swap(routing_requests);
@@ -79,6 +90,18 @@ public:
 
   RoutingScenario routing_scenario;
 
+  /* a request the venue answers as the next callbacks are delivered,
+    0 for none */
+  uint64_t answer_on_callbacks;
+
+  void on_callbacks(const Book_::Base::Callbacks& callbacks) {
+    Book_::on_callbacks(callbacks);
+
+    uint64_t request_id = answer_on_callbacks;
+    answer_on_callbacks = 0;
+    if(request_id != 0) on_routing_success(request_id);
+  }
+
 protected:
   void on_routing_request(const RoutingRequest& request) {
     routing_requests_.push(request);
@@ -226,6 +249,148 @@ TEST_CASE("routable orders") {
       CHECK(routing_request.cancel_reason == book::dont_cancel);
     }
 
+    SUBCASE("adding a user order exactly matching the MM order, timeout") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+      book.set_routing_timeout(MM1_EXCHANGE, 500);
+      book.advance_time(1000);
+
+      auto order2 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order2->order_id((uint128){1, 2});
+      book.add(order2);
+
+      CHECK(book.pending_routing_requests() == 1);
+      auto routing_request = book.pop_routing_request();
+      CHECK(routing_request.deadline == 1500);
+
+      book.start_recording_callbacks();
+      book.advance_time(1499);
+      CHECK(book.get_recorded_callbacks().size() == 0);
+
+      book.advance_time(1500);
+      Book::Callbacks cb = book.get_recorded_callbacks();
+
+      /* the user order is cancelled, the fill with the MM is not replayed */
+      REQUIRE(cb.size() == 1);
+      CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel);
+      CHECK(cb[0].scope == Book::TypedCallback::CbScope::external_only);
+      CHECK(cb[0].reason == book::CancelReasons::routing_timeout);
+      CHECK(cb[0].order->order_id() == order2->order_id());
+      CHECK(cb[0].generic_1 == 1.0);
+
+      CHECK(book.pending_routing_requests() == 0);
+
+      /* a late response finds nothing */
+      book.start_recording_callbacks();
+      book.respond(routing_request.request_id, true);
+      CHECK(book.get_recorded_callbacks().size() == 0);
+
+      /* the next request times out from the time of the book */
+      auto order3 = std::make_shared<Order>(MM1_ID, SELL, 1000.00, 1.0, 0.0);
+      auto order4 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order3->order_id((uint128){1, 3});
+      order4->order_id((uint128){1, 4});
+      book.add(order3);
+      book.add(order4);
+
+      REQUIRE(book.pending_routing_requests() == 1);
+      CHECK(book.pop_routing_request().deadline == 2000);
+    }
+
+    SUBCASE("adding a user order matching the MM order, partial fill") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+
+      auto order2 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order2->order_id((uint128){1, 2});
+      book.add(order2);
+
+      book.start_recording_callbacks();
+      book.respond_partial(book.pop_routing_request().request_id, 0.25);
+      Book::Callbacks cb = book.get_recorded_callbacks();
+
+      /* the fill replayed up to what the venue filled, the rest cancelled */
+      REQUIRE(cb.size() == 2);
+      CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+      CHECK(cb[0].scope == Book::TypedCallback::CbScope::external_only);
+      CHECK(cb[0].qty == 0.25);
+
+      CHECK(cb[1].type == Book::TypedCallback::cb_order_cancel);
+      CHECK(cb[1].reason == book::CancelReasons::routing_failure);
+      CHECK(cb[1].qty == 0.25);
+      CHECK(cb[1].generic_1 == 0.75);
+
+      CHECK(book.pending_routing_requests() == 0);
+    }
+
+    SUBCASE("a request timing out with another one answered meanwhile") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+      book.set_routing_timeout(MM1_EXCHANGE, 500);
+
+      auto order2 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      auto order3 = std::make_shared<Order>(MM1_ID, SELL, 1000.00, 1.0, 0.0);
+      auto order4 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order2->order_id((uint128){1, 2});
+      order3->order_id((uint128){1, 3});
+      order4->order_id((uint128){1, 4});
+      book.add(order2);
+      book.add(order3);
+      book.add(order4);
+
+      REQUIRE(book.pending_routing_requests() == 2);
+      auto r2 = book.pop_routing_request();
+      auto r1 = book.pop_routing_request();
+      CHECK(r1.deadline == r2.deadline);
+
+      /* both time out, the venue answers the second as the first is
+        cancelled */
+      book.answer_on_callbacks = r2.request_id;
+      book.start_recording_callbacks();
+      book.advance_time(r1.deadline);
+      Book::Callbacks cb = book.get_recorded_callbacks();
+
+      /* answered from within the delivery of the cancel, which is
+        delivered again with the fill */
+      REQUIRE(cb.size() >= 2);
+      CHECK(cb.front().type == Book::TypedCallback::cb_order_cancel);
+      CHECK(cb.front().reason == book::CancelReasons::routing_timeout);
+      CHECK(cb.front().order->order_id() == order2->order_id());
+      CHECK(cb.back().type == Book::TypedCallback::cb_trade);
+      CHECK(cb.back().order->order_id() == order4->order_id());
+
+      CHECK(book.pending_routing_requests() == 0);
+
+      /* and the timers still work */
+      auto order5 = std::make_shared<Order>(MM1_ID, SELL, 1000.00, 1.0, 0.0);
+      auto order6 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order5->order_id((uint128){1, 5});
+      order6->order_id((uint128){1, 6});
+      book.add(order5);
+      book.add(order6);
+
+      REQUIRE(book.pending_routing_requests() == 1);
+      book.start_recording_callbacks();
+      book.advance_time(r1.deadline + 500);
+      cb = book.get_recorded_callbacks();
+      CHECK(book.pending_routing_requests() == 0);
+      REQUIRE(cb.size() == 1);
+      CHECK(cb[0].reason == book::CancelReasons::routing_timeout);
+    }
+
+    SUBCASE("a response before the timeout cancels it") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+      book.set_routing_timeout(MM1_EXCHANGE, 500);
+
+      auto order2 = std::make_shared<Order>(USER_1, BUY, 1000.00, 1.0, 0.0);
+      order2->order_id((uint128){1, 2});
+      book.add(order2);
+
+      book.respond(book.pop_routing_request().request_id, true);
+      CHECK(book.pending_routing_requests() == 0);
+
+      book.start_recording_callbacks();
+      book.advance_time(1000);
+      CHECK(book.get_recorded_callbacks().size() == 0);
+    }
+
   }
 
   SUBCASE("1 MM order with 1 user limit order") {
@@ -808,6 +973,145 @@ TEST_CASE("routable orders") {
       CHECK(book.bids().size() == 0);
       CHECK(book.asks().size() == 1);
     }
+
+    SUBCASE("adding a user order fully matching the two MM orders, routed in parallel") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+      book.set_parallel_routing(true);
+
+      auto order3 = std::make_shared<Order>(USER_1, BUY, 2000.00, 2.0, 0.0);
+      order3->order_id((uint128){1, 3});
+      book.add(order3);
+
+      /* one request per exchange, both sent before any response */
+      REQUIRE(book.routing_requests_size() == 2);
+      auto r2 = book.pop_routing_request();
+      auto r1 = book.pop_routing_request();
+
+      CHECK(r1.exchange_id == MM1_EXCHANGE);
+      CHECK(r1.qty == 1.0);
+      CHECK(r1.price == 1000.00);
+      CHECK(r2.exchange_id == MM2_EXCHANGE);
+      CHECK(r2.qty == 1.0);
+      CHECK(r2.price == 2000.00);
+      CHECK(r1.sweep_id == r1.request_id);
+      CHECK(r2.sweep_id == r1.request_id);
+      CHECK(book.pending_routing_requests() == 2);
+      CHECK(book.bids().size() == 0);
+      CHECK(book.asks().size() == 0);
+
+      SUBCASE("both filled, in any order") {
+        book.start_recording_callbacks();
+        book.respond(r2.request_id, true);
+        Book::Callbacks cb = book.get_recorded_callbacks();
+
+        /* the fills of a venue are replayed as it answers */
+        REQUIRE(cb.size() == 1);
+        CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+        CHECK(cb[0].scope == Book::TypedCallback::CbScope::external_only);
+        CHECK(cb[0].maker_order->order_id() == order2->order_id());
+
+        book.start_recording_callbacks();
+        book.respond(r1.request_id, true);
+        cb = book.get_recorded_callbacks();
+
+        /* filled in full, nothing to add again */
+        REQUIRE(cb.size() == 1);
+        CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+        CHECK(cb[0].maker_order->order_id() == order1->order_id());
+
+        CHECK(book.pending_routing_requests() == 0);
+        CHECK(book.bids().size() == 0);
+      }
+
+      SUBCASE("one partly filled, the taker is cancelled once both are in") {
+        book.start_recording_callbacks();
+        book.respond_partial(r1.request_id, 0.5);
+        Book::Callbacks cb = book.get_recorded_callbacks();
+
+        REQUIRE(cb.size() == 1);
+        CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+        CHECK(cb[0].qty == 0.5);
+
+        book.start_recording_callbacks();
+        book.respond(r2.request_id, true);
+        cb = book.get_recorded_callbacks();
+
+        REQUIRE(cb.size() == 2);
+        CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+        CHECK(cb[0].qty == 1.0);
+        CHECK(cb[1].type == Book::TypedCallback::cb_order_cancel);
+        CHECK(cb[1].scope == Book::TypedCallback::CbScope::external_only);
+        CHECK(cb[1].reason == book::CancelReasons::routing_failure);
+        CHECK(cb[1].qty == 1.5);
+        CHECK(cb[1].generic_1 == 0.5);
+
+        CHECK(book.pending_routing_requests() == 0);
+      }
+
+      SUBCASE("both failed, cancelled once") {
+        book.respond(r2.request_id, false);
+        CHECK(book.pending_routing_requests() == 1);
+
+        book.start_recording_callbacks();
+        book.respond(r1.request_id, false);
+        Book::Callbacks cb = book.get_recorded_callbacks();
+
+        REQUIRE(cb.size() == 1);
+        CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel);
+        CHECK(cb[0].reason == book::CancelReasons::routing_failure);
+        CHECK(cb[0].qty == 0);
+        CHECK(cb[0].generic_1 == 2.0);
+      }
+    }
+
+    SUBCASE("adding a user order sweeping the two MM orders in parallel, then resting") {
+      book.routing_scenario = ROUTING_NO_RESPONSE;
+      book.set_parallel_routing(true);
+      book.set_routing_timeout(MM2_EXCHANGE, 500);
+
+      auto order3 = std::make_shared<Order>(USER_1, BUY, 2000.00, 3.0, 0.0);
+      order3->order_id((uint128){1, 3});
+      book.add(order3);
+
+      REQUIRE(book.routing_requests_size() == 2);
+      auto r2 = book.pop_routing_request();
+      auto r1 = book.pop_routing_request();
+      CHECK(r1.deadline == 0);
+      CHECK(r2.deadline == 500);
+
+      book.respond(r1.request_id, true);
+      CHECK(book.bids().size() == 0);
+
+      /* the slowest venue times out, what it had is cancelled with the
+        rest of the taker */
+      book.start_recording_callbacks();
+      book.advance_time(500);
+      Book::Callbacks cb = book.get_recorded_callbacks();
+
+      REQUIRE(cb.size() == 1);
+      CHECK(cb[0].type == Book::TypedCallback::cb_order_cancel);
+      CHECK(cb[0].reason == book::CancelReasons::routing_timeout);
+      CHECK(cb[0].generic_1 == 2.0);
+
+      CHECK(book.pending_routing_requests() == 0);
+      CHECK(book.bids().size() == 0);
+
+      /* the maker ids of the sweep are released */
+      auto order4 = std::make_shared<Order>(MM1_ID, SELL, 1000.00, 1.0, 0.0);
+      auto order5 = std::make_shared<Order>(USER_1, BUY, 1000.00, 2.0, 0.0);
+      order4->order_id((uint128){1, 4});
+      order5->order_id((uint128){1, 5});
+      book.add(order4);
+      book.add(order5);
+
+      REQUIRE(book.routing_requests_size() == 1);
+      auto r3 = book.pop_routing_request();
+      CHECK(r3.sweep_id == r3.request_id);
+
+      /* filled, the rest of the taker rests */
+      book.respond(r3.request_id, true);
+      CHECK(book.bids().size() == 1);
+    }
   }
 
   SUBCASE("match with MM order, then stp cancel taker with own") {
@@ -877,4 +1181,144 @@ TEST_CASE("routable orders") {
   }
 }
 
-}
\ No newline at end of file
+TEST_CASE("routing requests hold a bounded number of fills") {
+  Book book(SYMBOL_ID_1);
+  book.routing_scenario = ROUTING_NO_RESPONSE;
+
+  const size_t n = Book::RoutingRequest::MAX_FILLS + 2;
+  for(size_t i = 0; i < n; ++i) {
+    auto order = std::make_shared<Order>(MM1_ID, SELL, 1000.00, 1.0, 0.0);
+    order->order_id((uint128){1, i});
+    book.add(order);
+  }
+
+  auto taker = std::make_shared<Order>(USER_1, BUY, 1000.00, (double) n, 0.0);
+  taker->order_id((uint128){2, 0});
+  book.add(taker);
+
+  /* the taker stops once the request is full */
+  REQUIRE(book.routing_requests_size() == 1);
+  auto r1 = book.pop_routing_request();
+  CHECK(r1.qty == (double) Book::RoutingRequest::MAX_FILLS);
+  CHECK(r1.fills.full());
+  CHECK(book.asks().size() == 2);
+
+  /* and goes on once routed */
+  book.respond(r1.request_id, true);
+
+  REQUIRE(book.routing_requests_size() == 1);
+  auto r2 = book.pop_routing_request();
+  CHECK(r2.qty == 2.0);
+  CHECK(r2.fills.size() == 2);
+
+  book.start_recording_callbacks();
+  book.respond(r2.request_id, true);
+  Book::Callbacks cb = book.get_recorded_callbacks();
+
+  REQUIRE(cb.size() == 2);
+  CHECK(cb[0].type == Book::TypedCallback::cb_trade);
+  CHECK(cb[1].type == Book::TypedCallback::cb_trade);
+
+  CHECK(book.pending_routing_requests() == 0);
+  CHECK(book.bids().size() == 0);
+  CHECK(book.asks().size() == 0);
+}
+
+/* a book that routes at most 2 fills to a venue at once */
+class SmallBook : public fixtures::ME<Tracker,
+  book::plugins::RoutablePlugin<Tracker, book::UnboundBook, 2>>
+{
+public:
+  typedef book::plugins::RoutablePlugin<Tracker, book::UnboundBook, 2>::RoutingRequest RoutingRequest;
+
+  SmallBook(uint32_t symbol_id) : fixtures::ME<Tracker,
+    book::plugins::RoutablePlugin<Tracker, book::UnboundBook, 2>>(symbol_id) {
+    register_market_maker(MM1_ID, MM1_EXCHANGE);
+  }
+
+  void respond(uint64_t request_id) { on_routing_success(request_id); }
+
+  std::vector<RoutingRequest> requests;
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    requests.push_back(request);
+  }
+};
+
+TEST_CASE("the fills a request holds are a parameter of the book") {
+  SmallBook book(SYMBOL_ID_1);
+  CHECK(SmallBook::RoutingRequest::MAX_FILLS == 2);
+
+  for(uint64_t i = 0; i < 3; ++i) {
+    auto order = std::make_shared<Order>(MM1_ID, SELL, 1000.00 + i, 1.0, 0.0);
+    order->order_id((uint128){1, i});
+    book.add(order);
+  }
+
+  auto taker = std::make_shared<Order>(USER_1, BUY, 1010.00, 3.0, 0.0);
+  taker->order_id((uint128){2, 0});
+  book.add(taker);
+
+  REQUIRE(book.requests.size() == 1);
+  CHECK(book.requests[0].qty == 2.0);
+  CHECK(book.requests[0].price == 1001.00);
+  REQUIRE(book.requests[0].fills.size() == 2);
+  CHECK(book.requests[0].fills[1].maker_order->order_id() == (uint128){1, 1});
+  CHECK(book.requests[0].fills[1].taker_filled_qty == 2.0);
+
+  book.respond(book.requests[0].request_id);
+
+  REQUIRE(book.requests.size() == 2);
+  CHECK(book.requests[1].qty == 1.0);
+
+  book.respond(book.requests[1].request_id);
+  CHECK(book.pending_routing_requests() == 0);
+  CHECK(book.asks().size() == 0);
+}
+
+TEST_CASE("steady-state routing does not allocate") {
+  Book book(SYMBOL_ID_1);
+  book.routing_scenario = ROUTING_NO_RESPONSE;
+  book.set_parallel_routing(true);
+
+  uint64_t id = 0;
+
+  /* 100 takers each crossing both exchanges, answered all at once */
+  auto cycle = [&]() {
+    for(int i = 0; i < 100; ++i) {
+      for(uint32_t mm : { MM1_ID, MM2_ID }) {
+        auto maker = std::make_shared<Order>(mm, SELL, 1000.00, 1.0, 0.0);
+        maker->order_id((uint128){1, ++id});
+        book.add(maker);
+      }
+
+      auto taker = std::make_shared<Order>(USER_1, BUY, 1000.00, 3.0, 0.0);
+      taker->order_id((uint128){2, ++id});
+      book.add(taker);
+    }
+
+    while(book.routing_requests_size() > 0)
+      book.respond(book.pop_routing_request().request_id, true);
+
+    /* what is left of the takers */
+    book.add(std::make_shared<Order>(USER_2, SELL, 1000.00, 100.0, 0.0));
+  };
+
+  cycle();
+  cycle();
+
+  const book::BookArena::Counters& counters = book.arena().counters();
+  uint64_t global_allocations = counters.global_allocations();
+  uint64_t in_use = counters.in_use();
+
+  for(int i = 0; i < 20; ++i)
+    cycle();
+
+  CHECK(book.pending_routing_requests() == 0);
+  CHECK(book.bids().size() == 0);
+  CHECK(counters.global_allocations() == global_allocations);
+  CHECK(counters.in_use() == in_use);
+}
+
+}
@@ -0,0 +1,353 @@
+#include <doctest/doctest.h>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <book/types.h>
+#include <book/snapshot.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <book/plugins/positions.h>
+#include <book/plugins/reduce_only.h>
+#include <book/plugins/routable.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace snapshot_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define MM_ID 1000
+#define MM_EXCHANGE 2
+#define MM2_ID 1001
+#define MM2_EXCHANGE 3
+
+#define BUY true
+#define SELL false
+
+class Order : public fixtures::OrderWithStopPrice, public book::plugins::ReduceOnlyOrder {
+public:
+  Order(uint32_t user_id, bool is_bid, double price, double qty,
+    double stop_price = 0, bool reduce_only = false) :
+    fixtures::OrderWithStopPrice(user_id, is_bid, price, qty, 0, stop_price),
+    reduce_only_(reduce_only) {}
+
+  bool reduce_only() const { return reduce_only_; }
+
+private:
+  bool reduce_only_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Codec {
+  static void encode(const OrderPtr& order, book::JournalEncoder& out) {
+    out.put(order->order_id());
+    out.put(order->user_id());
+    out.put(order->is_bid());
+    out.put(order->price());
+    out.put(order->qty());
+    out.put(order->stop_price());
+    out.put(order->reduce_only());
+  }
+
+  static OrderPtr decode(book::JournalDecoder& in) {
+    utils::uint128 order_id = in.get<utils::uint128>();
+    uint32_t user_id = in.get<uint32_t>();
+    bool is_bid = in.get<bool>();
+    double price = in.get<double>();
+    double qty = in.get<double>();
+    double stop_price = in.get<double>();
+    bool reduce_only = in.get<bool>();
+
+    OrderPtr order = std::make_shared<Order>(user_id, is_bid, price, qty, stop_price, reduce_only);
+    order->order_id(order_id);
+    return order;
+  }
+};
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::PositionsTracker<OrderPtr>,
+  public book::plugins::ReduceOnlyTracker<OrderPtr>,
+  public book::plugins::RoutableTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::PositionsTracker<OrderPtr>(order),
+    book::plugins::ReduceOnlyTracker<OrderPtr>(order),
+    book::plugins::RoutableTracker<OrderPtr>(order) {}
+};
+
+template <class Storage>
+using BookOn = fixtures::BasicME<
+  book::Journaled<Storage, Codec>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>,
+  book::plugins::PositionsPlugin<Tracker>,
+  book::plugins::ReduceOnlyPlugin<Tracker>
+>;
+
+typedef fixtures::BasicME<
+  book::Journaled<book::MapStorage, Codec>,
+  Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::RoutablePlugin<Tracker>
+> RoutingBook_;
+
+class RoutingBook : public RoutingBook_ {
+public:
+  typedef book::plugins::RoutablePlugin<Tracker>::RoutingRequest RoutingRequest;
+
+  RoutingBook() : RoutingBook_(SYMBOL_ID_1) {
+    register_market_maker(MM_ID, MM_EXCHANGE);
+    register_market_maker(MM2_ID, MM2_EXCHANGE);
+    set_parallel_routing(true);
+  }
+
+  void answer(uint64_t request_id, bool success) {
+    if(success) on_routing_success(request_id);
+    else on_routing_failure(request_id);
+  }
+
+protected:
+  void on_routing_request(const RoutingRequest&) {}
+};
+
+const char* SNAPSHOT = "snapshot_test.snapshot";
+const char* JOURNAL = "snapshot_test.journal";
+
+template <class Callbacks>
+void check_same(const Callbacks& a, const Callbacks& b) {
+  REQUIRE(a.size() == b.size());
+
+  for(size_t i = 0; i < a.size(); ++i) {
+    CHECK(a[i].type == b[i].type);
+    CHECK(a[i].reason == b[i].reason);
+    CHECK(a[i].scope == b[i].scope);
+    CHECK(a[i].qty == b[i].qty);
+    CHECK(a[i].price == b[i].price);
+    CHECK(a[i].avg_price == b[i].avg_price);
+    if(a[i].order) CHECK(a[i].order->order_id() == b[i].order->order_id());
+  }
+}
+
+template <class Callbacks>
+Callbacks without_rejects(const Callbacks& callbacks) {
+  typedef typename Callbacks::value_type Callback;
+  Callbacks result;
+
+  for(auto it = callbacks.begin(); it != callbacks.end(); ++it) {
+    /* a rejected cancel still ends with a book update */
+    if(it->type == Callback::cb_order_cancel_reject) { ++it; continue; }
+    if(it->type == Callback::cb_order_replace_reject) continue;
+    result.push_back(*it);
+  }
+
+  return result;
+}
+
+template <class Side>
+void check_same_side(const Side& a, const Side& b) {
+  REQUIRE(a.size() == b.size());
+
+  for(auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+    CHECK(ia->first.price() == ib->first.price());
+    CHECK(ia->second.ptr()->order_id() == ib->second.ptr()->order_id());
+    CHECK(ia->second.qty() == ib->second.qty());
+    CHECK(ia->second.filled_qty() == ib->second.filled_qty());
+    CHECK(ia->second.filled_cost() == ib->second.filled_cost());
+  }
+}
+
+template <class B>
+void check_same_book(const B& a, const B& b) {
+  CHECK(a.market_price() == b.market_price());
+  check_same_side(a.bids(), b.bids());
+  check_same_side(a.asks(), b.asks());
+}
+
+/* orders, cancels, replaces and market prices at random, on orders
+  looked up by id so that restored books are driven alike */
+template <class B>
+void run_session(B& book, std::unordered_map<uint64_t, OrderPtr>& orders,
+  int n, unsigned seed, uint64_t first_id)
+{
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> action(0, 19);
+  std::uniform_int_distribution<int> tick(-20, 20);
+  std::uniform_int_distribution<int> lots(1, 20);
+
+  for(int i = 0; i < n; ++i) {
+    int a = action(rng);
+
+    if(a < 4 && !orders.empty()) {
+      auto it = orders.find(rng() % (first_id + i));
+      if(it != orders.end()) book.cancel(it->second, book::user_cancel);
+    }
+
+    else if(a < 6 && !orders.empty()) {
+      auto it = orders.find(rng() % (first_id + i));
+      if(it != orders.end()) book.replace(it->second, tick(rng) / 4);
+    }
+
+    else if(a == 6)
+      book.set_market_price(1000 + tick(rng));
+
+    else {
+      double price = a == 19 ? 0 : 1000 + tick(rng);
+      double stop_price = a == 18 ? 1000 + tick(rng) : 0;
+      OrderPtr order = std::make_shared<Order>(1 + rng() % 4, rng() & 1,
+        price, lots(rng), stop_price, a == 17);
+      order->order_id(utils::uint128(0, first_id + i));
+
+      orders[first_id + i] = order;
+      book.add(order);
+    }
+  }
+}
+
+TEST_CASE_TEMPLATE("snapshots restore the book and its plugins", Storage,
+  book::MapStorage, book::LadderStorage)
+{
+  typedef BookOn<Storage> Book;
+
+  Book book(SYMBOL_ID_1);
+  std::unordered_map<uint64_t, OrderPtr> orders;
+  uint64_t journal_seq;
+
+  {
+    book::JournalWriter writer(JOURNAL, SYMBOL_ID_1);
+    book.journal().attach(&writer);
+
+    run_session(book, orders, 3000, 42, 0);
+
+    book::SnapshotWriter<Codec> out;
+    book.save(out);
+    journal_seq = writer.next_seq() - 1;
+    out.write(SNAPSHOT, book.symbol_id(), journal_seq);
+
+    book.start_recording_callbacks();
+    run_session(book, orders, 3000, 43, 3000);
+    book.journal().detach();
+  }
+
+  typename Book::Callbacks after_snapshot = book.get_recorded_callbacks();
+
+  SUBCASE("and the journal continues from it") {
+    book::SnapshotReader<Codec> in(SNAPSHOT);
+    CHECK(in.symbol_id() == SYMBOL_ID_1);
+    CHECK(in.journal_seq() == journal_seq);
+
+    Book restored(SYMBOL_ID_1);
+    restored.load(in);
+    CHECK(restored.order_count() > 0);
+
+    book::JournalReader reader(JOURNAL);
+    book::JournalReplayer<Book> replayer(restored);
+    replayer.resume(in.orders(), in.journal_seq());
+
+    restored.start_recording_callbacks();
+    CHECK(replayer.replay(reader) > 0);
+
+    /* the orders gone before the snapshot are not in it. cancelling them
+      was rejected, and is skipped by the replay */
+    CHECK(replayer.skipped() > 0);
+    check_same(without_rejects(after_snapshot),
+      without_rejects(restored.get_recorded_callbacks()));
+    check_same_book(book, restored);
+  }
+
+  SUBCASE("into an empty book only") {
+    book::SnapshotReader<Codec> in(SNAPSHOT);
+    CHECK_THROWS_AS(book.load(in), book::SnapshotException);
+  }
+
+  SUBCASE("of the same plugins") {
+    book::SnapshotReader<Codec> in(SNAPSHOT);
+    RoutingBook other;
+    CHECK_THROWS_AS(other.load(in), book::SnapshotException);
+  }
+
+  SUBCASE("truncated snapshots are refused") {
+    FILE* file = fopen(SNAPSHOT, "r+b");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    REQUIRE(truncate(SNAPSHOT, size - 1) == 0);
+
+    CHECK_THROWS_AS(book::SnapshotReader<Codec> in(SNAPSHOT), book::SnapshotException);
+  }
+
+  std::remove(SNAPSHOT);
+  std::remove(JOURNAL);
+}
+
+TEST_CASE("snapshots keep pending routing requests") {
+  RoutingBook book;
+
+  for(int i = 0; i < 3; ++i) {
+    OrderPtr maker = std::make_shared<Order>(MM_ID, SELL, 1000 + i, 1);
+    maker->order_id(utils::uint128(1, i));
+    book.add(maker);
+
+    OrderPtr taker = std::make_shared<Order>(USER_1, BUY, 1000 + i, 2);
+    taker->order_id(utils::uint128(2, i));
+    book.add(taker);
+  }
+
+  /* a sweep of both exchanges, routed in parallel */
+  for(uint32_t mm : { MM_ID, MM2_ID }) {
+    OrderPtr maker = std::make_shared<Order>(mm, SELL, 1500, 1);
+    maker->order_id(utils::uint128(3, mm));
+    book.add(maker);
+  }
+
+  OrderPtr sweeper = std::make_shared<Order>(USER_1, BUY, 1500, 3);
+  sweeper->order_id(utils::uint128(4, 0));
+  book.add(sweeper);
+  REQUIRE(book.pending_routing_requests() == 5);
+
+  book::SnapshotWriter<Codec> out;
+  book.save(out);
+  out.write(SNAPSHOT, book.symbol_id(), 0);
+
+  book::SnapshotReader<Codec> in(SNAPSHOT);
+  RoutingBook restored;
+  restored.load(in);
+  check_same_book(book, restored);
+
+  book.start_recording_callbacks();
+  restored.start_recording_callbacks();
+
+  for(RoutingBook* b : { &book, &restored }) {
+    b->answer(2, false);
+    b->answer(1, true);
+    b->answer(3, true);
+    b->answer(5, true);
+    b->answer(4, true);
+  }
+
+  check_same(book.get_recorded_callbacks(), restored.get_recorded_callbacks());
+  check_same_book(book, restored);
+
+  /* and new requests follow the restored ones */
+  OrderPtr maker = std::make_shared<Order>(MM_ID, SELL, 2000, 1);
+  maker->order_id(utils::uint128(1, 9));
+  restored.add(maker);
+
+  OrderPtr taker = std::make_shared<Order>(USER_1, BUY, 2000, 1);
+  taker->order_id(utils::uint128(2, 9));
+  restored.add(taker);
+
+  CHECK_NOTHROW(restored.answer(6, true));
+
+  std::remove(SNAPSHOT);
+}
+
+}
@@ -37,6 +37,13 @@ typedef fixtures::ME<
   book::plugins::StopOrdersPlugin<Tracker>
 > Book;
 
+typedef book::FlatTracker<OrderPtr, book::TrackerState<>, book::FixedPoint> FixedTracker;
+
+typedef fixtures::LadderME<
+  FixedTracker,
+  book::plugins::StopOrdersPlugin<FixedTracker>
+> FixedBook;
+
 using Callbacks = Book::Callbacks;
 using TypedCallback = Book::TypedCallback;
 
@@ -238,4 +245,31 @@ TEST_CASE("Stop Orders") {
         CHECK(book.bids().size() == 2); // Stop A remainder + Stop B full
     }
 }
+TEST_CASE("stop prices of a fixed-point book are in ticks") {
+    /* 0.01 price ticks, whole lots */
+    FixedBook book(SYMBOL_ID_1, book::TickScale(0.01, 1));
+    book.set_market_price(10000);
+
+    auto stop_buy = std::make_shared<Order>(USER_1, BUY, 111, 10, 0, 110.5);
+    auto cbs = book.add_and_get_cbs(stop_buy);
+    CHECK(cbs[0].type == FixedBook::TypedCallback::cb_order_accept);
+    CHECK(book.bids().size() == 0);
+
+    /* off the tick grid */
+    cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_1, BUY, 111, 10, 0, 110.505));
+    CHECK(cbs[0].type == FixedBook::TypedCallback::cb_order_reject);
+    CHECK(cbs[0].reason == book::off_grid);
+
+    book.add(std::make_shared<Order>(USER_1, BUY, 110.49, 1, 0, 0));
+    book.add(std::make_shared<Order>(USER_2, SELL, 110.49, 1, 0, 0));
+    CHECK(book.market_price() == 11049);
+    CHECK(book.bids().size() == 0);
+
+    book.add(std::make_shared<Order>(USER_1, BUY, 110.5, 1, 0, 0));
+    book.add(std::make_shared<Order>(USER_2, SELL, 110.5, 1, 0, 0));
+    REQUIRE(book.bids().size() == 1);
+    CHECK(book.bids().begin()->second.ptr() == stop_buy);
+    CHECK(book.best_bid() == 11100);
+}
+
 }
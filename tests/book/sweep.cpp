@@ -0,0 +1,163 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <random>
+
+#include <book/types.h>
+#include <book/units.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace sweep_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+
+#define BUY true
+#define SELL false
+
+typedef fixtures::OrderWithUserID Order;
+typedef std::shared_ptr<Order> OrderPtr;
+
+typedef book::BaseTracker<OrderPtr> Tracker;
+typedef book::BaseTracker<OrderPtr, book::FixedPoint> FixedTracker;
+
+template <class Storage>
+using Book = fixtures::BasicME<Storage, Tracker>;
+
+template <class Storage>
+using FixedBook = fixtures::BasicME<Storage, FixedTracker>;
+
+/* 0.01 price ticks, 0.001 qty lots */
+static const book::TickScale scale(0.01, 0.001);
+
+TEST_CASE_TEMPLATE("simulated sweeps", Storage, book::MapStorage, book::LadderStorage) {
+  Book<Storage> book(SYMBOL_ID_1);
+
+  book.add(std::make_shared<Order>(USER_1, SELL, 101, 2, 0));
+  book.add(std::make_shared<Order>(USER_1, SELL, 101, 1, 0));
+  book.add(std::make_shared<Order>(USER_1, SELL, 102, 4, 0));
+  book.add(std::make_shared<Order>(USER_1, SELL, 104, 5, 0));
+
+  SUBCASE("by qty") {
+    auto sweep = book.simulate_sweep(BUY, 5);
+    CHECK(sweep.filled);
+    CHECK(sweep.qty == 5);
+    CHECK(sweep.cost == 3 * 101 + 2 * 102);
+    CHECK(sweep.worst_price == 102);
+    CHECK(sweep.levels == 2);
+    CHECK(sweep.vwap() == doctest::Approx((3 * 101 + 2 * 102) / 5.0));
+  }
+
+  SUBCASE("up to a limit") {
+    auto sweep = book.simulate_sweep(BUY, 20, 0, 102);
+    CHECK(!sweep.filled);
+    CHECK(sweep.qty == 7);
+    CHECK(sweep.worst_price == 102);
+
+    sweep = book.simulate_sweep(BUY, 1, 0, 100);
+    CHECK(sweep.qty == 0);
+    CHECK(sweep.levels == 0);
+    CHECK(sweep.worst_price == 0);
+  }
+
+  SUBCASE("by funds") {
+    auto sweep = book.simulate_sweep(BUY, 0, 303 + 204);
+    CHECK(sweep.filled);
+    CHECK(sweep.qty == doctest::Approx(5));
+    CHECK(sweep.worst_price == 102);
+
+    /* qty limits first */
+    sweep = book.simulate_sweep(BUY, 1, 1e6);
+    CHECK(sweep.qty == 1);
+    CHECK(sweep.filled);
+  }
+
+  SUBCASE("an empty side fills nothing") {
+    auto sweep = book.simulate_sweep(SELL, 1);
+    CHECK(!sweep.filled);
+    CHECK(sweep.qty == 0);
+  }
+
+  SUBCASE("the book is left as it was") {
+    book.start_recording_callbacks();
+    book.simulate_sweep(BUY, 100);
+
+    CHECK(book.get_recorded_callbacks().empty());
+    CHECK(book.order_count() == 4);
+    CHECK(book.best_ask_qty() == 3);
+  }
+}
+
+/* order units to those of the trackers of the book */
+struct Floating {
+  double price(double p) const { return p; }
+  double qty(double q) const { return q; }
+  double funds(double f) const { return f; }
+};
+
+struct Fixed {
+  book::Ticks price(double p) const { return scale.to_ticks(p); }
+  book::Lots qty(double q) const { return scale.to_lots(q); }
+  book::TickLots funds(double f) const { return scale.to_tick_lots(f); }
+};
+
+/* sweeps simulated before each taker fill what adding it fills */
+template <class B, class Units>
+void check_against_add(B& book, const Units& units) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> tick(-30, 30);
+  std::uniform_int_distribution<int> lots(1, 40);
+
+  bool same = true;
+  int takers = 0, filled = 0;
+
+  for(int i = 0; i < 4000; ++i) {
+    bool is_bid = rng() & 1;
+
+    if(rng() % 4) {
+      /* makers rest away from the mid */
+      double price = 1000 + (is_bid ? -1 - abs(tick(rng)) : 1 + abs(tick(rng)));
+      book.add(std::make_shared<Order>(USER_1, is_bid, price + 0.25, lots(rng) / 4.0, 0));
+      continue;
+    }
+
+    /* funds for market orders only: makers resting with funds can
+      trade less than they show */
+    double limit = rng() % 3 ? 0 : 1000 + tick(rng) + 0.25;
+    double qty = limit != 0 || rng() % 3 ? lots(rng) : 0;
+    double funds = limit == 0 && (qty == 0 || rng() % 2) ? lots(rng) * 1000.0 : 0;
+
+    auto sweep = book.simulate_sweep(is_bid, units.qty(qty), units.funds(funds), units.price(limit));
+
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, is_bid, limit, qty, funds));
+    REQUIRE(cbs[0].type == B::TypedCallback::cb_order_accept);
+
+    same &= sweep.qty == doctest::Approx(cbs[0].qty).epsilon(1e-9);
+    if(cbs[0].qty != 0)
+      same &= sweep.vwap() == doctest::Approx(cbs[0].avg_price).epsilon(1e-9);
+
+    ++takers;
+    filled += sweep.filled;
+  }
+
+  CHECK(same);
+  CHECK(takers > 500);
+  CHECK(filled > 100);
+}
+
+TEST_CASE_TEMPLATE("simulated sweeps fill what adding fills", Storage,
+  book::MapStorage, book::LadderStorage)
+{
+  SUBCASE("floating point") {
+    Book<Storage> book(SYMBOL_ID_1);
+    check_against_add(book, Floating());
+  }
+
+  SUBCASE("fixed point") {
+    FixedBook<Storage> book(SYMBOL_ID_1, scale);
+    check_against_add(book, Fixed());
+  }
+}
+
+}
@@ -0,0 +1,270 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <vector>
+
+#include <book/types.h>
+#include <book/tracker.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/time_in_force.h>
+#include <book/plugins/routable.h>
+#include "fixtures/order.h"
+#include "fixtures/me.h"
+
+namespace time_in_force_test {
+
+#define SYMBOL_ID_1 1
+#define USER_1 1
+#define USER_2 2
+#define MM_ID 1000
+#define MM_EXCHANGE 2
+
+#define BUY true
+#define SELL false
+
+using book::plugins::tif_gtc;
+using book::plugins::tif_ioc;
+using book::plugins::tif_fok;
+
+class Order : public fixtures::OrderWithUserID, public book::plugins::TimeInForceOrder {
+public:
+  Order(uint32_t user_id, bool is_bid, double price, double qty, double funds = 0,
+    book::plugins::TimeInForce tif = tif_gtc, double min_fill_qty = 0) :
+    fixtures::OrderWithUserID(user_id, is_bid, price, qty, funds),
+    tif_(tif), min_fill_qty_(min_fill_qty) {}
+
+  book::plugins::TimeInForce tif() const { return tif_; }
+  double min_fill_qty() const { return min_fill_qty_; }
+
+private:
+  book::plugins::TimeInForce tif_;
+  double min_fill_qty_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<OrderPtr>,
+  public book::plugins::TimeInForceTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<OrderPtr>(order),
+    book::plugins::TimeInForceTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::TimeInForcePlugin<Tracker>> Book;
+
+/* fixed-point, with a flat tracker */
+typedef book::FlatTracker<OrderPtr, book::TrackerState<
+  book::plugins::TimeInForceState<OrderPtr>>, book::FixedPoint> FixedTracker;
+
+typedef fixtures::LadderME<FixedTracker,
+  book::plugins::TimeInForcePlugin<FixedTracker>> FixedBook;
+
+typedef Book::TypedCallback Callback;
+
+/* time in force listed before routing, so that it sees the taker first */
+struct RoutedTracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::TimeInForceTracker<OrderPtr>,
+  public book::plugins::RoutableTracker<OrderPtr>
+{
+  RoutedTracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::TimeInForceTracker<OrderPtr>(order),
+    book::plugins::RoutableTracker<OrderPtr>(order) {}
+};
+
+typedef fixtures::ME<RoutedTracker,
+  book::plugins::TimeInForcePlugin<RoutedTracker>,
+  book::plugins::RoutablePlugin<RoutedTracker>> RoutedBook_;
+
+class RoutedBook : public RoutedBook_ {
+public:
+  RoutedBook() : RoutedBook_(SYMBOL_ID_1) {
+    register_market_maker(MM_ID, MM_EXCHANGE);
+  }
+
+  std::vector<uint64_t> requests;
+
+  void respond(uint64_t request_id) { on_routing_success(request_id); }
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    requests.push_back(request.request_id);
+  }
+};
+
+size_t count(const Book::Callbacks& cbs, Callback::CbType type) {
+  size_t n = 0;
+  for(auto it = cbs.begin(); it != cbs.end(); ++it)
+    n += it->type == type;
+  return n;
+}
+
+/* seen by the user, routing hides some of the callbacks */
+template <class Callbacks>
+size_t count_external(const Callbacks& cbs, Callback::CbType type) {
+  size_t n = 0;
+  for(auto it = cbs.begin(); it != cbs.end(); ++it)
+    n += it->type == type && (it->scope & Callback::CbScope::external_only) != 0;
+  return n;
+}
+
+TEST_CASE("time in force") {
+  Book book(SYMBOL_ID_1);
+
+  book.add(std::make_shared<Order>(USER_1, SELL, 101, 2));
+  book.add(std::make_shared<Order>(USER_1, SELL, 102, 3));
+  book.add(std::make_shared<Order>(USER_1, SELL, 104, 5));
+
+  SUBCASE("IOC cancels what is left instead of resting") {
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 102, 8, 0, tif_ioc));
+
+    CHECK(count(cbs, Callback::cb_trade) == 2);
+    REQUIRE(count(cbs, Callback::cb_order_cancel) == 1);
+
+    const Callback& cancel = cbs[cbs.size() - 2];
+    CHECK(cancel.type == Callback::cb_order_cancel);
+    CHECK(cancel.reason == book::immediate_or_cancel);
+    CHECK(cancel.qty == 5);
+    CHECK(cancel.generic_1 == 3);
+
+    CHECK(book.bids().size() == 0);
+    CHECK(book.best_ask() == 104);
+  }
+
+  SUBCASE("GTC rests as before") {
+    book.add(std::make_shared<Order>(USER_2, BUY, 102, 8));
+    CHECK(book.best_bid() == 102);
+    CHECK(book.best_bid_qty() == 3);
+  }
+
+  SUBCASE("FOK is rejected without matching") {
+    book.start_recording_callbacks();
+    book.add(std::make_shared<Order>(USER_2, BUY, 102, 6, 0, tif_fok));
+    book.add(std::make_shared<Order>(USER_2, BUY, 0, 11, 0, tif_fok));
+    book.add(std::make_shared<Order>(USER_2, BUY, 100, 1, 0, tif_fok));
+    auto cbs = book.get_recorded_callbacks();
+
+    REQUIRE(cbs.size() == 3);
+    for(auto it = cbs.begin(); it != cbs.end(); ++it) {
+      CHECK(it->type == Callback::cb_order_reject);
+      CHECK(it->reason == book::fill_or_kill_unfilled);
+    }
+
+    CHECK(book.asks().size() == 3);
+    CHECK(book.side_qty(SELL) == 10);
+  }
+
+  SUBCASE("FOK fills entirely") {
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 102, 5, 0, tif_fok));
+
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == 5);
+    CHECK(count(cbs, Callback::cb_order_cancel) == 0);
+    CHECK(book.best_ask() == 104);
+  }
+
+  SUBCASE("FOK by funds") {
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 0, 0, 10000, tif_fok));
+    CHECK(cbs[0].type == Callback::cb_order_reject);
+
+    cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 0, 0, 202 + 306, tif_fok));
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == doctest::Approx(5));
+  }
+
+  SUBCASE("minimum quantity") {
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 101, 4, 0, tif_gtc, 3));
+    CHECK(cbs[0].type == Callback::cb_order_reject);
+    CHECK(cbs[0].reason == book::min_qty_unfilled);
+    CHECK(book.side_qty(SELL) == 10);
+
+    /* the rest rests */
+    cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 102, 8, 0, tif_gtc, 4));
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == 5);
+    CHECK(book.best_bid_qty() == 3);
+  }
+
+  SUBCASE("minimum quantity and IOC") {
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 104, 20, 0, tif_ioc, 10));
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == 10);
+    CHECK(book.order_count() == 0);
+  }
+
+  SUBCASE("a FOK stopped short by another plugin is cancelled") {
+    book.add(std::make_shared<Order>(USER_2, SELL, 101, 1));
+
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 101, 3, 0, tif_fok));
+    CHECK(cbs[0].type == Callback::cb_order_accept);
+    CHECK(cbs[0].qty == 2);
+    CHECK(book.bids().size() == 0);
+  }
+}
+
+TEST_CASE("an IOC taker is routed before it is cancelled") {
+  RoutedBook book;
+  book.add(std::make_shared<Order>(MM_ID, SELL, 101, 1));
+
+  /* crosses the market maker, and would rest the rest */
+  OrderPtr taker = std::make_shared<Order>(USER_2, BUY, 101, 3, 0, tif_ioc);
+  auto cbs = book.add_and_get_cbs(taker);
+
+  /* nothing reaches the user until the venue answers */
+  REQUIRE(book.requests.size() == 1);
+  CHECK(count_external(cbs, Callback::cb_order_cancel) == 0);
+  CHECK(count_external(cbs, Callback::cb_trade) == 0);
+
+  /* and the taker is put aside for routing, not cancelled as IOC */
+  for(auto it = cbs.begin(); it != cbs.end(); ++it)
+    if(it->type == Callback::cb_order_cancel)
+      CHECK(it->reason == book::temporary_cancel);
+
+  /* once routed, the fill is replayed and the rest cancelled as IOC */
+  book.start_recording_callbacks();
+  book.respond(book.requests[0]);
+  cbs = book.get_recorded_callbacks();
+
+  CHECK(count_external(cbs, Callback::cb_trade) == 1);
+  REQUIRE(count_external(cbs, Callback::cb_order_cancel) == 1);
+
+  for(auto it = cbs.begin(); it != cbs.end(); ++it)
+    if(it->type == Callback::cb_order_cancel) {
+      CHECK(it->order == taker);
+      CHECK(it->reason == book::immediate_or_cancel);
+      CHECK(it->qty == 1);
+      CHECK(it->generic_1 == 2);
+    }
+
+  CHECK(book.pending_routing_requests() == 0);
+  CHECK(book.order_count() == 0);
+}
+
+TEST_CASE("minimum quantity is in order units") {
+  /* 0.01 price ticks, 0.001 qty lots */
+  FixedBook book(SYMBOL_ID_1, book::TickScale(0.01, 0.001));
+
+  book.add(std::make_shared<Order>(USER_1, SELL, 100.5, 0.25));
+
+  CHECK(book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 100.5, 1, 0, tif_ioc, 0.3))[0].type ==
+    FixedBook::TypedCallback::cb_order_reject);
+
+  auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 100.5, 1, 0, tif_ioc, 0.2));
+  CHECK(cbs[0].type == FixedBook::TypedCallback::cb_order_accept);
+  CHECK(cbs[0].qty == 250);
+  CHECK(book.order_count() == 0);
+
+  /* off the grid, rounded up rather than to the nearest lot */
+  book.add(std::make_shared<Order>(USER_1, SELL, 100.5, 0.25));
+
+  CHECK(book.add_and_get_cbs(std::make_shared<Order>(USER_2, BUY, 100.5, 1, 0, tif_ioc, 0.2502))[0].type ==
+    FixedBook::TypedCallback::cb_order_reject);
+}
+
+}
@@ -0,0 +1,144 @@
+#include <doctest/doctest.h>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <book/timer_wheel.h>
+
+namespace timer_wheel_test {
+
+typedef book::TimerWheel<int> Wheel;
+
+/* value and deadline of the timers fired by an advance */
+typedef std::vector<std::pair<int, uint64_t>> Fired;
+
+template <class W>
+Fired advance(W& wheel, uint64_t now) {
+  Fired fired;
+  wheel.advance(now, [&](int& value, uint64_t deadline) {
+    fired.push_back(std::make_pair(value, deadline));
+  });
+  return fired;
+}
+
+TEST_CASE("timer wheel") {
+  Wheel wheel;
+
+  wheel.insert(10, 1);
+  wheel.insert(5, 2);
+  Wheel::Handle h3 = wheel.insert(7, 3);
+  wheel.insert(100000, 4);
+
+  CHECK(wheel.size() == 4);
+
+  SUBCASE("timers fire in order of deadline") {
+    CHECK(advance(wheel, 4).empty());
+    CHECK(advance(wheel, 10) == Fired({ { 2, 5 }, { 3, 7 }, { 1, 10 } }));
+    CHECK(wheel.now() == 10);
+    CHECK(wheel.size() == 1);
+
+    CHECK(advance(wheel, 99999).empty());
+    CHECK(advance(wheel, 1 << 30) == Fired({ { 4, 100000 } }));
+    CHECK(wheel.empty());
+    CHECK(wheel.now() == 1 << 30);
+  }
+
+  SUBCASE("erased timers do not fire") {
+    wheel.erase(h3);
+    CHECK(advance(wheel, 10) == Fired({ { 2, 5 }, { 1, 10 } }));
+  }
+
+  SUBCASE("timers already due fire at the next advance") {
+    advance(wheel, 20);
+    wheel.insert(15, 5);
+    wheel.insert(20, 6);
+    CHECK(advance(wheel, 20).empty());
+    CHECK(advance(wheel, 21) == Fired({ { 5, 15 }, { 6, 20 } }));
+  }
+
+  SUBCASE("handles are reused") {
+    advance(wheel, 10);
+    Wheel::Handle h5 = wheel.insert(11, 5);
+    CHECK(h5 < 4);
+    CHECK(wheel.value(h5) == 5);
+    CHECK(wheel.deadline(h5) == 11);
+  }
+
+  SUBCASE("time does not go back") {
+    advance(wheel, 6);
+    CHECK(advance(wheel, 3).empty());
+    CHECK(wheel.now() == 6);
+  }
+}
+
+/* deadlines near and far, beyond the range of a small wheel, against a
+  multimap of the timers pending */
+template <class W>
+void check_against_multimap(unsigned seed) {
+  W wheel;
+  std::multimap<uint64_t, int> expected;
+  std::vector<std::pair<typename W::Handle, std::multimap<uint64_t, int>::iterator>> live;
+
+  std::mt19937_64 rng(seed);
+  std::uniform_int_distribution<int> action(0, 9);
+  std::uniform_int_distribution<int> shift(0, 24);
+
+  uint64_t now = 0;
+
+  for(int i = 0; i < 20000; ++i) {
+    int a = action(rng);
+    uint64_t span = (uint64_t) 1 << shift(rng);
+
+    if(a < 5) {
+      uint64_t deadline = now + 1 + rng() % span;
+      live.push_back(std::make_pair(wheel.insert(deadline, i), expected.emplace(deadline, i)));
+    }
+
+    else if(a < 7 && !live.empty()) {
+      size_t at = rng() % live.size();
+      wheel.erase(live[at].first);
+      expected.erase(live[at].second);
+      live[at] = live.back();
+      live.pop_back();
+    }
+
+    else {
+      now += rng() % span;
+      Fired fired = advance(wheel, now);
+
+      /* handles of the timers due are gone */
+      std::vector<std::pair<typename W::Handle, std::multimap<uint64_t, int>::iterator>> left;
+      for(auto it = live.begin(); it != live.end(); ++it)
+        if(it->second->first > now) left.push_back(*it);
+      live.swap(left);
+
+      /* everything due, earliest first */
+      for(size_t f = 0; f < fired.size(); ++f) {
+        REQUIRE(!expected.empty());
+        CHECK(fired[f].second <= now);
+        CHECK(fired[f].second == expected.begin()->first);
+        if(f > 0) CHECK(fired[f - 1].second <= fired[f].second);
+
+        auto it = expected.equal_range(fired[f].second);
+        for(; it.first != it.second; ++it.first)
+          if(it.first->second == fired[f].first) break;
+
+        REQUIRE(it.first != it.second);
+        expected.erase(it.first);
+      }
+
+      CHECK((expected.empty() || expected.begin()->first > now));
+    }
+
+    REQUIRE(wheel.size() == expected.size());
+  }
+}
+
+TEST_CASE("timer wheels fire like a sorted multimap") {
+  check_against_multimap<book::TimerWheel<int>>(1);
+  check_against_multimap<book::TimerWheel<int, 3>>(2);
+  check_against_multimap<book::TimerWheel<int, 2>>(3);
+}
+
+}
@@ -60,6 +60,13 @@ typedef fixtures::ME<
   book::plugins::TrailingStopOrdersPlugin<Tracker>
 > Book;
 
+typedef book::FlatTracker<OrderPtr, book::TrackerState<>, book::FixedPoint> FixedTracker;
+
+typedef fixtures::LadderME<
+  FixedTracker,
+  book::plugins::TrailingStopOrdersPlugin<FixedTracker>
+> FixedBook;
+
 using Callbacks = Book::Callbacks;
 using TypedCallback = Book::TypedCallback;
 
@@ -302,4 +309,32 @@ TEST_CASE("Trailing Stop Orders") {
     }
 }
 
-}
\ No newline at end of file
+TEST_CASE("trailing amounts of a fixed-point book are in ticks") {
+    /* 0.01 price ticks, whole lots */
+    FixedBook book(SYMBOL_ID_1, book::TickScale(0.01, 1));
+    book.set_market_price(10000);
+
+    /* trails 0.10 behind the market */
+    auto t_sell = std::make_shared<Order>(USER_1, SELL, 99.5, 10, 0, 0.1);
+    book.add(t_sell);
+
+    /* off the tick grid */
+    auto cbs = book.add_and_get_cbs(std::make_shared<Order>(USER_1, SELL, 99.5, 10, 0, 0.105));
+    CHECK(cbs[0].type == FixedBook::TypedCallback::cb_order_reject);
+    CHECK(cbs[0].reason == book::off_grid);
+
+    const double prices[] = { 100.05, 100.1, 100.02 };
+    for(double price : prices) {
+      book.add(std::make_shared<Order>(USER_1, BUY, price, 1, 0, 0));
+      book.add(std::make_shared<Order>(USER_2, SELL, price, 1, 0, 0));
+      CHECK(book.asks().size() == 0);
+    }
+
+    /* 0.10 below the high */
+    book.add(std::make_shared<Order>(USER_1, BUY, 100, 1, 0, 0));
+    book.add(std::make_shared<Order>(USER_2, SELL, 100, 1, 0, 0));
+    REQUIRE(book.asks().size() == 1);
+    CHECK(book.asks().begin()->second.ptr() == t_sell);
+}
+
+}
@@ -1061,3 +1061,27 @@ TEST_CASE("TestReplaceAsk")
   cc.reset();
 }
 
+
+TEST_CASE("TestFixedPointLevels")
+{
+  typedef Depth<5, int64_t, int64_t> FixedDepth;
+
+  FixedDepth depth;
+  depth.add_order(100001, 100, true);
+  depth.add_order(100001, 200, true);
+  depth.add_order(99999, 300, true);
+  depth.fill_order(100001, 150, false, true);
+  depth.change_qty_order(99999, -100, true);
+
+  const FixedDepth::DepthLevel* bid = depth.bids();
+  CHECK(bid->price() == 100001);
+  CHECK(bid->order_count() == 2);
+  CHECK(bid->aggregate_qty() == 150);
+
+  ++bid;
+  CHECK(bid->price() == 99999);
+  CHECK(bid->aggregate_qty() == 200);
+
+  CHECK(depth.close_order(99999, 200, true));
+  CHECK(depth.bids()[1].price() == 0);
+}
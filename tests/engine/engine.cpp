@@ -0,0 +1,266 @@
+#include <doctest/doctest.h>
+#include <atomic>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/tracker.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <engine/engine.h>
+#include <flow/generator.h>
+#include <flow/replay.h>
+
+namespace engine_test {
+
+struct Tracker :
+  public virtual book::BaseTracker<flow::OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<flow::OrderPtr>
+{
+  Tracker(const flow::OrderPtr& order) :
+    book::BaseTracker<flow::OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<flow::OrderPtr>(order) {}
+};
+
+typedef book::LadderOB<Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>> OB;
+
+typedef engine::Engine<OB> Engine;
+typedef OB::TypedCallback Callback;
+
+/* single-threaded reference */
+class Book : public OB {
+public:
+  Book(uint32_t symbol_id) : OB(symbol_id) {}
+
+  std::vector<Callback> callbacks;
+
+protected:
+  void on_callbacks(const Callbacks& cbs) {
+    callbacks.insert(callbacks.end(), cbs.begin(), cbs.end());
+  }
+};
+
+/* the orders of each event of a stream, built once for both books */
+std::vector<flow::OrderPtr> orders_of(const std::vector<flow::Event>& events) {
+  std::vector<flow::OrderPtr> orders;
+  for(auto it = events.begin(); it != events.end(); ++it)
+    if(it->type == flow::event_add)
+      orders.push_back(std::make_shared<flow::Order>(*it));
+  return orders;
+}
+
+TEST_CASE("symbols are spread over the shards") {
+  engine::EngineConfig config;
+  config.shards = 3;
+  Engine engine(config);
+
+  for(uint32_t symbol = 10; symbol < 17; ++symbol)
+    engine.add_symbol(symbol);
+
+  CHECK(engine.shard_of(10) == 0);
+  CHECK(engine.shard_of(12) == 2);
+  CHECK(engine.shard_of(13) == 0);
+  CHECK(engine.shard_of(99) == -1);
+  CHECK_THROWS_AS(engine.add_symbol(10), std::invalid_argument);
+
+
+  engine.start();
+  CHECK_THROWS_AS(engine.add_symbol(20), std::logic_error);
+  CHECK(!engine.add(99, std::make_shared<flow::Order>(flow::Event())));
+  engine.stop();
+}
+
+/* streams of `symbols` symbols through `shards` shards, moving a random
+  symbol to a random shard every `migrate_every` events, if not 0. each
+  symbol must run and publish as a book of its own would */
+void check_streams(size_t shards, size_t migrate_every) {
+  const uint32_t symbols = 6;
+  const size_t events_per_symbol = 5000;
+
+  engine::EngineConfig config;
+  config.shards = shards;
+  config.command_capacity = 256;
+  config.callback_capacity = 1024;
+  Engine engine(config);
+
+  flow::Model model;
+  std::vector<std::vector<flow::Event>> events(symbols);
+  std::vector<std::vector<flow::OrderPtr>> orders(symbols);
+
+  for(uint32_t s = 0; s < symbols; ++s) {
+    events[s] = flow::Generator(model, 100 + s).generate(events_per_symbol);
+    orders[s] = orders_of(events[s]);
+    engine.add_symbol(s, events_per_symbol);
+  }
+
+  /* callbacks of each symbol, as published */
+  std::vector<std::vector<Callback>> published(symbols);
+  std::atomic<bool> done(false);
+
+  std::thread drain([&]() {
+    for(;;) {
+      bool stopped = done.load();
+      size_t n = 0;
+
+      for(size_t shard = 0; shard < engine.shard_count(); ++shard)
+        n += engine.poll(shard, [&](const Engine::Output& out) {
+          published[out.symbol_id].push_back(out.callback);
+        });
+
+      if(stopped && n == 0) break;
+      if(n == 0) std::this_thread::yield();
+    }
+  });
+
+  engine.start();
+
+  /* interleaves the streams, as a gateway would */
+  std::mt19937 rng(7);
+  std::vector<size_t> next_add(symbols, 0);
+  size_t migrations = 0;
+
+  for(size_t i = 0; i < events_per_symbol; ++i) {
+    for(uint32_t s = 0; s < symbols; ++s) {
+      if(migrate_every && (i * symbols + s) % migrate_every == 0)
+        migrations += engine.migrate(rng() % symbols, rng() % shards);
+
+      const flow::Event& event = events[s][i];
+
+      switch(event.type) {
+        case flow::event_add: engine.add(s, orders[s][next_add[s]++]); break;
+        case flow::event_cancel: engine.cancel(s, orders[s][event.order_id]); break;
+        default: engine.replace(s, orders[s][event.order_id], event.qty);
+      }
+    }
+  }
+
+  engine.stop();
+  done = true;
+  drain.join();
+
+  uint64_t processed = 0;
+  for(size_t shard = 0; shard < engine.shard_count(); ++shard)
+    processed += engine.shard(shard).processed();
+
+  uint64_t migrated = 0;
+  for(size_t shard = 0; shard < engine.shard_count(); ++shard)
+    migrated += engine.shard(shard).migrations();
+
+  CHECK(migrated == migrations);
+  CHECK(processed == symbols * events_per_symbol + 2 * migrations);
+
+  uint64_t seqs = 0;
+  for(uint32_t s = 0; s < symbols; ++s)
+    seqs += engine.book(s).seq();
+
+  CHECK(seqs == processed);
+
+  for(uint32_t s = 0; s < symbols; ++s) {
+    Book reference(s);
+    size_t next = 0;
+
+    for(auto it = events[s].begin(); it != events[s].end(); ++it) {
+      switch(it->type) {
+        case flow::event_add: reference.add(orders[s][next++]); break;
+        case flow::event_cancel: reference.cancel(orders[s][it->order_id], book::user_cancel); break;
+        default: reference.replace(orders[s][it->order_id], it->qty);
+      }
+    }
+
+    REQUIRE(published[s].size() == reference.callbacks.size());
+
+    bool same = true;
+    for(size_t i = 0; i < published[s].size(); ++i) {
+      const Callback& a = published[s][i];
+      const Callback& b = reference.callbacks[i];
+      same &= a.type == b.type && a.reason == b.reason && a.order == b.order &&
+        a.maker_order == b.maker_order && a.qty == b.qty && a.price == b.price;
+    }
+
+    CHECK(same);
+    CHECK(engine.book(s).bids().size() == reference.bids().size());
+    CHECK(engine.book(s).asks().size() == reference.asks().size());
+  }
+}
+
+TEST_CASE("shards run each symbol like a book of its own") {
+  check_streams(3, 0);
+}
+
+TEST_CASE("symbols migrate without losing or reordering events") {
+  SUBCASE("often") { check_streams(3, 97); }
+  SUBCASE("back and forth") { check_streams(2, 11); }
+}
+
+TEST_CASE("rebalance moves hot symbols to idle shards") {
+  engine::EngineConfig config;
+  config.shards = 2;
+  config.publish = false;
+  Engine engine(config);
+
+  /* 0 and 2 on shard 0, 1 and 3 on shard 1 */
+  for(uint32_t s = 0; s < 4; ++s)
+    engine.add_symbol(s);
+
+  CHECK(engine.rebalance() == 0);
+
+  flow::Model model;
+  std::vector<flow::Event> events = flow::Generator(model, 3).generate(4000);
+
+  engine.start();
+  for(uint32_t s = 0; s <= 2; s += 2) {
+    std::vector<flow::OrderPtr> orders = orders_of(events);
+    size_t next = 0;
+    for(auto it = events.begin(); it != events.end(); ++it) {
+      switch(it->type) {
+        case flow::event_add: engine.add(s, orders[next++]); break;
+        case flow::event_cancel: engine.cancel(s, orders[it->order_id]); break;
+        default: engine.replace(s, orders[it->order_id], it->qty);
+      }
+    }
+  }
+  engine.stop();
+
+  CHECK(engine.book(0).busy() > 0);
+  CHECK(engine.book(1).busy() == 0);
+
+  /* one of the hot symbols moves, the other stays */
+  CHECK(engine.rebalance(4) == 1);
+  CHECK(engine.shard_of(0) + engine.shard_of(2) == 1);
+  CHECK(engine.shard_of(1) == 1);
+  CHECK(engine.shard_of(3) == 1);
+
+  /* nothing ran since */
+  CHECK(engine.rebalance() == 0);
+
+  engine.start();
+  engine.stop();
+  CHECK(engine.shard(1).migrations() == 1);
+}
+
+TEST_CASE("stopped engines restart") {
+  engine::EngineConfig config;
+  config.publish = false;
+  Engine engine(config);
+  engine.add_symbol(1);
+
+  flow::Event event = flow::Event();
+  event.price = 1000;
+  event.qty = 1;
+
+  for(int round = 0; round < 2; ++round) {
+    engine.start();
+    engine.add(1, std::make_shared<flow::Order>(event));
+    engine.stop();
+  }
+
+  CHECK(engine.shard(0).processed() == 2);
+  CHECK(engine.shard(0).published() > 0);
+  CHECK(engine.book(1).asks().size() == 2);
+}
+
+}
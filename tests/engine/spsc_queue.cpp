@@ -0,0 +1,83 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <engine/spsc_queue.h>
+
+namespace spsc_queue_test {
+
+TEST_CASE("spsc queue") {
+  engine::SpscQueue<int> queue(3);
+  int value;
+
+  CHECK(queue.capacity() == 4);
+  CHECK(queue.empty());
+  CHECK(!queue.try_pop(value));
+
+  for(int i = 0; i < 4; ++i)
+    CHECK(queue.try_push(i));
+
+  CHECK(!queue.try_push(4));
+  CHECK(queue.size() == 4);
+
+  SUBCASE("pops in order and wraps around") {
+    for(int round = 0; round < 3; ++round) {
+      CHECK(queue.try_pop(value));
+      CHECK(value == round);
+      CHECK(queue.try_push(4 + round));
+    }
+
+    std::vector<int> rest;
+    while(queue.try_pop(value))
+      rest.push_back(value);
+
+    CHECK(rest == std::vector<int>({ 3, 4, 5, 6 }));
+    CHECK(queue.empty());
+  }
+}
+
+TEST_CASE("spsc queue releases what it pops") {
+  engine::SpscQueue<std::shared_ptr<int>> queue(2);
+  std::shared_ptr<int> p = std::make_shared<int>(1);
+
+  CHECK(queue.try_push(p));
+  CHECK(p.use_count() == 2);
+
+  std::shared_ptr<int> out;
+  CHECK(queue.try_pop(out));
+  CHECK((out == p));
+  out.reset();
+  CHECK(p.use_count() == 1);
+}
+
+TEST_CASE("spsc queue across threads keeps every value in order") {
+  const uint64_t n = 200000;
+  engine::SpscQueue<uint64_t> queue(64);
+
+  std::thread producer([&]() {
+    for(uint64_t i = 0; i < n; ++i)
+      while(!queue.try_push(i))
+        std::this_thread::yield();
+  });
+
+  uint64_t expected = 0, value;
+  bool ordered = true;
+
+  while(expected < n) {
+    if(!queue.try_pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    ordered &= value == expected;
+    ++expected;
+  }
+
+  producer.join();
+
+  CHECK(ordered);
+  CHECK(queue.empty());
+}
+
+}
@@ -0,0 +1,288 @@
+#include <doctest/doctest.h>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/order.h>
+#include <book/tracker.h>
+#include <book/plugins/expiry.h>
+#include <engine/engine.h>
+#include <engine/clock.h>
+#include <engine/timer_service.h>
+
+namespace timers_test {
+
+#define BUY true
+#define SELL false
+
+class Order : public book::Order, public book::plugins::ExpiryOrder {
+public:
+  Order(bool is_bid, double price, double qty, uint64_t expire_time) :
+    is_bid_(is_bid), price_(price), qty_(qty), expire_time_(expire_time) {}
+
+  bool is_bid() const { return is_bid_; }
+  double qty() const { return qty_; }
+  double price() const { return price_; }
+  double funds() const { return 0; }
+  uint64_t expire_time() const { return expire_time_; }
+
+private:
+  bool is_bid_;
+  double price_;
+  double qty_;
+  uint64_t expire_time_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::ExpiryTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::ExpiryTracker<OrderPtr>(order) {}
+};
+
+typedef book::LadderOB<Tracker, book::plugins::ExpiryPlugin<Tracker>> OB;
+typedef OB::TypedCallback Callback;
+
+TEST_CASE("clocks") {
+  engine::MonotonicClock monotonic;
+  engine::TscClock tsc;
+  engine::SimulatedClock simulated;
+
+  uint64_t m = monotonic.now(), t = tsc.now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+  CHECK(monotonic.now() - m >= 2000000);
+  CHECK(tsc.now() - t >= 1000000);
+
+  CHECK(simulated.now() == 0);
+  simulated.set(100);
+  simulated.set(50);
+  CHECK(simulated.now() == 100);
+}
+
+/* what TimerService needs of a book */
+struct Sleeper {
+  typedef engine::TimerService<Sleeper> Service;
+
+  Sleeper() : wake_time_(Service::never), wake_timer_(Service::Wheel::npos) {}
+
+  void advance_time(uint64_t now) { woken.push_back(now); }
+
+  std::vector<uint64_t> woken;
+  uint64_t wake_time_;
+  Service::Handle wake_timer_;
+};
+
+TEST_CASE("timer service keeps the earliest time of each book") {
+  Sleeper::Service timers(0);
+  Sleeper a, b;
+
+  timers.schedule(a, 100);
+  timers.schedule(a, 50);
+  timers.schedule(a, 200);
+  timers.schedule(b, 70);
+  CHECK(timers.size() == 2);
+
+  CHECK(timers.fire(49) == 0);
+  CHECK(timers.fire(80) == 2);
+  CHECK(a.woken == std::vector<uint64_t>({ 80 }));
+  CHECK(b.woken == std::vector<uint64_t>({ 80 }));
+  CHECK(timers.empty());
+
+  SUBCASE("and books move with their timer") {
+    Sleeper::Service other(80);
+
+    timers.schedule(a, 300);
+    timers.remove(a);
+    CHECK(timers.empty());
+
+    other.restore(a);
+    CHECK(other.fire(300) == 1);
+    CHECK(a.woken == std::vector<uint64_t>({ 80, 300 }));
+  }
+}
+
+/* expired cancels polled from every shard, by symbol, until `count` */
+template <class E>
+size_t poll_expired(E& engine, std::vector<size_t>& by_symbol, size_t count) {
+  std::chrono::steady_clock::time_point give_up =
+    std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  size_t n = 0;
+
+  while(n < count && std::chrono::steady_clock::now() < give_up) {
+    for(size_t s = 0; s < engine.shard_count(); ++s)
+      engine.poll(s, [&](const typename E::Output& out) {
+        if(out.callback.type == Callback::cb_order_cancel && out.callback.reason == book::expired) {
+          ++by_symbol[out.symbol_id];
+          ++n;
+        }
+      });
+
+    std::this_thread::yield();
+  }
+
+  return n;
+}
+
+TEST_CASE("shards expire orders on a simulated clock") {
+  typedef engine::Engine<OB, engine::SimulatedClock> Engine;
+
+  engine::EngineConfig config;
+  config.shards = 2;
+  Engine engine(config);
+
+  for(uint32_t symbol = 0; symbol < 4; ++symbol)
+    engine.add_symbol(symbol);
+
+  engine.start();
+
+  /* symbol s rests orders expiring at 1000 * (1 + i) for i < 10 */
+  for(uint32_t symbol = 0; symbol < 4; ++symbol)
+    for(int i = 0; i < 10; ++i)
+      engine.add(symbol, std::make_shared<Order>(SELL, 100 + i, 1, 1000 * (1 + i)));
+
+  engine.advance_time(999);
+  engine.advance_time(3000);
+
+  /* symbols moving keep their timer */
+  engine.migrate(0, 1);
+  engine.migrate(1, 0);
+
+  engine.advance_time(5500);
+
+  /* polled while the engine runs, the adopting shards wait for it */
+  std::vector<size_t> expired(4, 0);
+  CHECK(poll_expired(engine, expired, 4 * 5) == 4 * 5);
+  engine.stop();
+
+  CHECK(expired == std::vector<size_t>({ 5, 5, 5, 5 }));
+
+  for(uint32_t symbol = 0; symbol < 4; ++symbol) {
+    CHECK(engine.book(symbol).order_count() == 5);
+    CHECK(engine.book(symbol).now() == 5500);
+    CHECK(engine.book(symbol).best_ask() == 105);
+  }
+
+  /* one wake per symbol and time reached, not per order */
+  CHECK(engine.shard(0).wakes() + engine.shard(1).wakes() <= 4 * 3);
+
+  engine.start();
+  engine.advance_time(1000000);
+  CHECK(poll_expired(engine, expired, 4 * 5) == 4 * 5);
+  engine.stop();
+
+  for(uint32_t symbol = 0; symbol < 4; ++symbol)
+    CHECK(engine.book(symbol).order_count() == 0);
+}
+
+TEST_CASE("books without anything due keep their time") {
+  typedef engine::Engine<OB, engine::SimulatedClock> Engine;
+
+  Engine engine;
+  engine.add_symbol(1);
+  engine.start();
+
+  engine.add(1, std::make_shared<Order>(SELL, 100, 1, 0));
+  engine.advance_time(500);
+  engine.add(1, std::make_shared<Order>(SELL, 101, 1, 2000));
+  engine.advance_time(1000);
+  engine.cancel(1, std::make_shared<Order>(SELL, 102, 1, 0));
+  engine.stop();
+
+  CHECK(engine.book(1).order_count() == 2);
+  CHECK(engine.book(1).now() == 0);
+  CHECK(engine.shard(0).wakes() == 0);
+
+  engine.start();
+  engine.advance_time(2500);
+  std::vector<size_t> expired(2, 0);
+  CHECK(poll_expired(engine, expired, 1) == 1);
+  engine.stop();
+
+  CHECK(engine.book(1).now() == 2500);
+  CHECK(engine.book(1).order_count() == 1);
+}
+
+/* throws on orders at a price of 13, and when woken at 666 */
+template <class Tracker, class Book = book::UnboundBook>
+class FaultyPlugin :
+public book::Plugin<Tracker, Book, FaultyPlugin<Tracker, Book>>
+{
+public:
+  void should_add(const Tracker& taker, book::InsertRejectReasons&) {
+    if(taker.price() == 13) throw std::runtime_error("faulty order");
+  }
+
+  void on_time(uint64_t now) {
+    if(now == 666) throw std::runtime_error("faulty wake");
+  }
+};
+
+typedef book::LadderOB<Tracker, book::plugins::ExpiryPlugin<Tracker>, FaultyPlugin<Tracker>> FaultyOB;
+
+TEST_CASE("shards fail the symbol of a command that throws") {
+  typedef engine::Engine<FaultyOB, engine::SimulatedClock> Engine;
+
+  engine::EngineConfig config;
+  config.shards = 1;
+  Engine engine(config);
+  engine.add_symbol(1);
+  engine.add_symbol(2, 0, book::TickScale(0.5));
+  engine.add_symbol(3);
+  engine.start();
+
+  engine.add(1, std::make_shared<Order>(SELL, 100, 1, 0));
+  engine.add(2, std::make_shared<Order>(SELL, 100.5, 1, 0));
+  engine.add(1, std::make_shared<Order>(SELL, 13, 1, 0));
+  engine.add(1, std::make_shared<Order>(SELL, 101, 1, 0));
+  engine.add(3, std::make_shared<Order>(SELL, 101, 1, 600));
+  engine.advance_time(666);
+  engine.add(2, std::make_shared<Order>(SELL, 101, 1, 0));
+  engine.add(3, std::make_shared<Order>(SELL, 102, 1, 0));
+  engine.stop();
+
+  CHECK(engine.shard(0).failures() == 2);
+  CHECK(engine.shard(0).processed() == 8);
+
+  /* the order after the one that threw is not run */
+  CHECK(engine.book(1).failed());
+  CHECK(engine.book(1).order_count() == 1);
+  CHECK(!engine.book(2).failed());
+  CHECK(engine.book(2).order_count() == 2);
+  CHECK(engine.book(2).scale().tick_size() == 0.5);
+  CHECK(engine.book(1).scale().tick_size() == 1);
+
+  /* expired before the wake threw, and took no order after */
+  CHECK(engine.book(3).failed());
+  CHECK(engine.book(3).order_count() == 0);
+  CHECK(engine.book(3).now() == 666);
+}
+
+TEST_CASE("shards expire orders on a real clock") {
+  typedef engine::Engine<OB, engine::MonotonicClock> Engine;
+
+  Engine engine;
+  engine.add_symbol(1);
+  engine.start();
+
+  uint64_t now = engine::MonotonicClock().now();
+  engine.add(1, std::make_shared<Order>(BUY, 100, 1, now + 2000000));
+  engine.add(1, std::make_shared<Order>(BUY, 99, 1, now + 3600000000000ull));
+
+  std::vector<size_t> expired(2, 0);
+  CHECK(poll_expired(engine, expired, 1) == 1);
+  engine.stop();
+
+  CHECK(engine::MonotonicClock().now() >= now + 2000000);
+  CHECK(engine.book(1).order_count() == 1);
+  CHECK(engine.book(1).best_bid() == 99);
+}
+
+}
@@ -0,0 +1,355 @@
+#include <doctest/doctest.h>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/order.h>
+#include <book/tracker.h>
+#include <book/plugins/routable.h>
+#include <engine/venue.h>
+#include <utils/uint128.h>
+
+namespace venue_test {
+
+#define BUY true
+#define SELL false
+
+#define USER_1 1
+#define MM_ID 100
+#define MM_EXCHANGE 7
+#define MM2_ID 101
+#define MM2_EXCHANGE 8
+
+class Order : public book::Order {
+public:
+  Order(uint32_t user_id, bool is_bid, double price, double qty) :
+    user_id_(user_id), is_bid_(is_bid), price_(price), qty_(qty) {}
+
+  utils::uint128 order_id() const { return order_id_; }
+  void order_id(const utils::uint128& order_id) { order_id_ = order_id; }
+
+  uint32_t user_id() const { return user_id_; }
+  bool is_bid() const { return is_bid_; }
+  double qty() const { return qty_; }
+  double price() const { return price_; }
+  double funds() const { return 0; }
+
+private:
+  utils::uint128 order_id_;
+  uint32_t user_id_;
+  bool is_bid_;
+  double price_;
+  double qty_;
+};
+
+typedef std::shared_ptr<Order> OrderPtr;
+
+struct Tracker :
+  public virtual book::BaseTracker<OrderPtr>,
+  public book::plugins::RoutableTracker<OrderPtr>
+{
+  Tracker(const OrderPtr& order) :
+    book::BaseTracker<OrderPtr>(order),
+    book::plugins::RoutableTracker<OrderPtr>(order) {}
+};
+
+typedef book::plugins::RoutablePlugin<Tracker>::RoutingRequest RoutingRequest;
+typedef book::LadderOB<Tracker> VenueOB;
+
+template <class Clock>
+class Venue : public engine::SimulatedVenue<VenueOB, RoutingRequest, Clock> {
+public:
+  typedef engine::SimulatedVenue<VenueOB, RoutingRequest, Clock> Base;
+
+  explicit Venue(const engine::VenueConfig& config) : Base(config) {}
+
+protected:
+  OrderPtr make_order(const RoutingRequest& request) {
+    return std::make_shared<Order>(0, request.is_bid, request.price, request.qty);
+  }
+};
+
+typedef Venue<engine::SimulatedClock> SimulatedVenue;
+
+/* routes to a venue, answered as its responses are polled */
+template <class V>
+class RoutingBook : public book::LadderOB<Tracker, book::plugins::RoutablePlugin<Tracker>> {
+public:
+  typedef book::LadderOB<Tracker, book::plugins::RoutablePlugin<Tracker>> Base;
+
+  explicit RoutingBook(V& venue) : Base(1), venue_(venue) {
+    register_market_maker(MM_ID, MM_EXCHANGE);
+  }
+
+  size_t poll() {
+    return venue_.poll([this](const typename V::Response& response) {
+      if(response.succeeded()) this->on_routing_success(response.request_id);
+      else if(response.failed()) this->on_routing_failure(response.request_id);
+      else this->on_routing_partial_success(response.request_id, response.filled_qty);
+    });
+  }
+
+  std::vector<TypedCallback> callbacks;
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    REQUIRE(venue_.submit(request));
+  }
+
+  void on_callbacks(const typename Base::Callbacks& cbs) {
+    callbacks.insert(callbacks.end(), cbs.begin(), cbs.end());
+  }
+
+private:
+  V& venue_;
+};
+
+/* routes to one of two venues by exchange */
+class TwoVenueBook : public book::LadderOB<Tracker, book::plugins::RoutablePlugin<Tracker>> {
+public:
+  typedef book::LadderOB<Tracker, book::plugins::RoutablePlugin<Tracker>> Base;
+
+  TwoVenueBook(SimulatedVenue& venue1, SimulatedVenue& venue2) : Base(1),
+    venue1_(venue1), venue2_(venue2) {
+    register_market_maker(MM_ID, MM_EXCHANGE);
+    register_market_maker(MM2_ID, MM2_EXCHANGE);
+  }
+
+  void poll() {
+    auto respond = [this](const SimulatedVenue::Response& response) {
+      if(response.succeeded()) this->on_routing_success(response.request_id);
+      else if(response.failed()) this->on_routing_failure(response.request_id);
+      else this->on_routing_partial_success(response.request_id, response.filled_qty);
+    };
+
+    venue1_.poll(respond);
+    venue2_.poll(respond);
+  }
+
+protected:
+  void on_routing_request(const RoutingRequest& request) {
+    SimulatedVenue& venue = request.exchange_id == MM_EXCHANGE ? venue1_ : venue2_;
+    REQUIRE(venue.submit(request));
+  }
+
+  void on_callbacks(const typename Base::Callbacks&) {}
+
+private:
+  SimulatedVenue& venue1_;
+  SimulatedVenue& venue2_;
+};
+
+OrderPtr make_order(uint32_t user_id, bool is_bid, double price, double qty, uint64_t id) {
+  OrderPtr order = std::make_shared<Order>(user_id, is_bid, price, qty);
+  order->order_id(utils::uint128(0, id));
+  return order;
+}
+
+RoutingRequest make_request(uint64_t request_id, double qty, double price) {
+  RoutingRequest request;
+  request.request_id = request_id;
+  request.is_bid = BUY;
+  request.qty = qty;
+  request.price = price;
+  return request;
+}
+
+TEST_CASE("simulated venue matches requests on its book") {
+  engine::VenueConfig config;
+  config.latency = 1000;
+
+  SimulatedVenue venue(config);
+  venue.book().add(make_order(0, SELL, 100, 2, 1));
+  venue.book().add(make_order(0, SELL, 101, 2, 2));
+
+  std::vector<SimulatedVenue::Response> responses;
+  auto collect = [&](const SimulatedVenue::Response& r) { responses.push_back(r); };
+
+  REQUIRE(venue.submit(make_request(1, 1, 100)));
+  REQUIRE(venue.submit(make_request(2, 3, 100)));
+  REQUIRE(venue.submit(make_request(3, 1, 100)));
+
+  SUBCASE("after its latency") {
+    CHECK(venue.run(0) == 0);
+    CHECK(venue.matched() == 3);
+    CHECK(venue.in_flight() == 3);
+
+    CHECK(venue.run(999) == 0);
+    CHECK(venue.poll(collect) == 0);
+
+    CHECK(venue.run(1000) == 3);
+    CHECK(venue.poll(collect) == 3);
+    CHECK(venue.in_flight() == 0);
+
+    REQUIRE(responses.size() == 3);
+    CHECK(responses[0].request_id == 1);
+    CHECK(responses[0].succeeded());
+
+    /* partly filled, what is left does not rest */
+    CHECK(responses[1].filled_qty == 1);
+    CHECK(!responses[1].succeeded());
+    CHECK(!responses[1].failed());
+
+    CHECK(responses[2].failed());
+
+    CHECK(venue.book().asks().size() == 1);
+    CHECK(venue.book().bids().size() == 0);
+  }
+
+  SUBCASE("when the time of the caller starts late") {
+    /* past the range of the wheel from 0 */
+    const uint64_t start = UINT64_C(1) << 52;
+
+    CHECK(venue.run(start) == 0);
+    CHECK(venue.run(start + 999) == 0);
+    CHECK(venue.run(start + 1000) == 3);
+    CHECK(venue.in_flight() == 0);
+  }
+
+  SUBCASE("responses wait for room in the queue") {
+    engine::VenueConfig small;
+    small.latency = 0;
+    small.queue_capacity = 2;
+
+    SimulatedVenue tight(small);
+    for(uint64_t id = 1; id <= 2; ++id)
+      REQUIRE(tight.submit(make_request(id, 1, 100)));
+
+    CHECK(tight.run(1) == 2);
+    REQUIRE(tight.submit(make_request(3, 1, 100)));
+    CHECK(tight.run(2) == 0);
+    CHECK(tight.in_flight() == 1);
+
+    CHECK(tight.poll(collect) == 2);
+    CHECK(tight.run(3) == 1);
+  }
+}
+
+TEST_CASE("simulated venue draws its delays and rejects") {
+  engine::VenueConfig config;
+  config.latency = 100;
+  config.jitter = 50;
+  config.reject_rate = 0.25;
+  config.seed = 7;
+
+  SimulatedVenue venue(config);
+  venue.book().add(make_order(0, SELL, 100, 1000000, 1));
+
+  const int n = 4000;
+  for(int i = 0; i < n; ++i)
+    REQUIRE(venue.submit(make_request(i + 1, 1, 100)));
+
+  venue.run(0);
+  CHECK(venue.run(99) == 0);
+
+  size_t sent = 0, rejected = 0;
+  auto count = [&](const SimulatedVenue::Response& r) { rejected += r.failed(); };
+
+  /* most within a few means of the jitter, all eventually */
+  sent += venue.run(100 + 4 * 50);
+  CHECK(sent > n * 9 / 10);
+  sent += venue.run(1000000);
+  CHECK(sent == n);
+
+  venue.poll(count);
+  CHECK(rejected > n / 5);
+  CHECK(rejected < n * 3 / 10);
+}
+
+TEST_CASE("routing to a simulated venue") {
+  engine::VenueConfig config;
+  config.latency = 500;
+
+  SimulatedVenue venue(config);
+  RoutingBook<SimulatedVenue> book(venue);
+
+  /* the venue has 2 of the 3 the market maker shows */
+  venue.book().add(make_order(0, SELL, 1000, 2, 1));
+
+  book.add(make_order(MM_ID, SELL, 1000, 3, 2));
+  book.add(make_order(USER_1, BUY, 1000, 3, 3));
+  CHECK(book.pending_routing_requests() == 1);
+
+  venue.run(0);
+  venue.run(500);
+  book.callbacks.clear();
+  CHECK(book.poll() == 1);
+  CHECK(book.pending_routing_requests() == 0);
+
+  /* 2 filled, the rest of the user order cancelled */
+  REQUIRE(book.callbacks.size() == 2);
+  CHECK(book.callbacks[0].type == VenueOB::TypedCallback::cb_trade);
+  CHECK(book.callbacks[0].qty == 2);
+  CHECK(book.callbacks[1].type == VenueOB::TypedCallback::cb_order_cancel);
+  CHECK(book.callbacks[1].reason == book::routing_failure);
+  CHECK(book.callbacks[1].generic_1 == 1);
+}
+
+/* time at which a taker crossing both venues is settled */
+uint64_t settle_sweep(bool parallel) {
+  engine::VenueConfig config1, config2;
+  config1.latency = 500;
+  config2.latency = 800;
+
+  SimulatedVenue venue1(config1), venue2(config2);
+  venue1.book().add(make_order(0, SELL, 1000, 10, 1));
+  venue2.book().add(make_order(0, SELL, 1000, 10, 2));
+
+  TwoVenueBook book(venue1, venue2);
+  book.set_parallel_routing(parallel);
+
+  book.add(make_order(MM_ID, SELL, 1000, 1, 3));
+  book.add(make_order(MM2_ID, SELL, 1001, 1, 4));
+  book.add(make_order(USER_1, BUY, 1001, 2, 5));
+
+  uint64_t now = 0;
+  for(; book.pending_routing_requests() > 0 && now < 10000; now += 100) {
+    venue1.run(now);
+    venue2.run(now);
+    book.poll();
+  }
+
+  CHECK(venue1.matched() == 1);
+  CHECK(venue2.matched() == 1);
+  return now - 100;
+}
+
+TEST_CASE("routing to venues in parallel waits for the slowest only") {
+  /* one venue after the other, the second request is sent on the next
+    run of the venues */
+  CHECK(settle_sweep(false) >= 500 + 800);
+  CHECK(settle_sweep(true) == 800);
+}
+
+TEST_CASE("simulated venue runs on a thread of its own") {
+  engine::VenueConfig config;
+  config.latency = 100000;
+
+  Venue<engine::MonotonicClock> venue(config);
+  RoutingBook<Venue<engine::MonotonicClock>> book(venue);
+  venue.book().add(make_order(0, SELL, 1000, 100, 1));
+
+  venue.start();
+
+  for(int i = 0; i < 10; ++i) {
+    book.add(make_order(MM_ID, SELL, 1000, 1, 10 + 2 * i));
+    book.add(make_order(USER_1, BUY, 1000, 1, 11 + 2 * i));
+  }
+
+  std::chrono::steady_clock::time_point give_up =
+    std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+  while(book.pending_routing_requests() > 0 && std::chrono::steady_clock::now() < give_up) {
+    if(book.poll() == 0)
+      std::this_thread::yield();
+  }
+
+  venue.stop();
+
+  CHECK(book.pending_routing_requests() == 0);
+  CHECK(venue.matched() == 10);
+}
+
+}
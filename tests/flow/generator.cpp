@@ -0,0 +1,189 @@
+#include <doctest/doctest.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <flow/generator.h>
+
+namespace generator_test {
+
+bool same(const std::vector<flow::Event>& a, const std::vector<flow::Event>& b) {
+  if(a.size() != b.size()) return false;
+
+  for(size_t i = 0; i < a.size(); ++i) {
+    if(a[i].type != b[i].type || a[i].is_bid != b[i].is_bid ||
+      a[i].reduce_only != b[i].reduce_only || a[i].user_id != b[i].user_id ||
+      a[i].order_id != b[i].order_id || a[i].ts != b[i].ts ||
+      a[i].price != b[i].price || a[i].qty != b[i].qty ||
+      a[i].stop_price != b[i].stop_price)
+      return false;
+  }
+
+  return true;
+}
+
+struct Mix {
+  size_t adds = 0, cancels = 0, replaces = 0;
+  size_t market = 0, stops = 0, reduce_only = 0;
+};
+
+Mix mix_of(const std::vector<flow::Event>& events) {
+  Mix mix;
+  for(auto it = events.begin(); it != events.end(); ++it) {
+    if(it->type == flow::event_cancel) ++mix.cancels;
+    else if(it->type == flow::event_replace) ++mix.replaces;
+    else {
+      ++mix.adds;
+      if(it->stop_price > 0) ++mix.stops;
+      else if(it->price == 0) ++mix.market;
+      if(it->reduce_only) ++mix.reduce_only;
+    }
+  }
+  return mix;
+}
+
+TEST_CASE("random integers are the same everywhere") {
+  /* xoshiro256** from splitmix64(0), pinned so that a seed replays the
+    same integers across platforms and standard libraries */
+  flow::Random random(0);
+  CHECK(random.next() == UINT64_C(11091344671253066420));
+  CHECK(random.next() == UINT64_C(13793997310169335082));
+  CHECK(random.next() == UINT64_C(1900383378846508768));
+
+  for(int i = 0; i < 1000; ++i) {
+    double u = random.uniform();
+    CHECK(u >= 0);
+    CHECK(u < 1);
+  }
+}
+
+TEST_CASE("the same seed gives the same stream") {
+  flow::Model model;
+
+  std::vector<flow::Event> a = flow::Generator(model, 7).generate(20000);
+  std::vector<flow::Event> b = flow::Generator(model, 7).generate(20000);
+  std::vector<flow::Event> c = flow::Generator(model, 8).generate(20000);
+
+  CHECK(same(a, b));
+  CHECK(!same(a, c));
+
+  SUBCASE("with hawkes arrivals") {
+    model.arrivals = flow::Model::hawkes;
+    CHECK(same(flow::Generator(model, 7).generate(5000),
+      flow::Generator(model, 7).generate(5000)));
+  }
+}
+
+TEST_CASE("streams follow the model") {
+  flow::Model model;
+  std::vector<flow::Event> events = flow::Generator(model, 1).generate(200000);
+  Mix mix = mix_of(events);
+
+  /* cancels per new order */
+  CHECK((double) mix.cancels / mix.adds == doctest::Approx(model.cancel_ratio).epsilon(0.03));
+  CHECK((double) mix.replaces / mix.adds == doctest::Approx(model.replace_ratio).epsilon(0.1));
+
+  CHECK((double) mix.stops / mix.adds == doctest::Approx(model.stop_share).epsilon(0.1));
+  CHECK((double) mix.market / mix.adds ==
+    doctest::Approx((1 - model.stop_share) * model.market_share).epsilon(0.1));
+  CHECK(mix.reduce_only > 0);
+
+  /* poisson arrivals at `rate` */
+  double seconds = events.back().ts / 1e9;
+  CHECK(events.size() / seconds == doctest::Approx(model.rate).epsilon(0.02));
+
+  uint64_t next_id = 0;
+  double distance = 0;
+  size_t limits = 0;
+
+  for(auto it = events.begin(); it != events.end(); ++it) {
+    if(it != events.begin())
+      REQUIRE(it->ts >= (it - 1)->ts);
+
+    if(it->type == flow::event_add) {
+      REQUIRE(it->order_id == next_id++);
+      REQUIRE(it->qty >= model.lot);
+      REQUIRE(it->qty <= model.lot * model.max_lots);
+
+      if(it->price > 0 && it->stop_price == 0) {
+        distance += std::fabs(it->price - model.mid) / model.tick;
+        ++limits;
+      }
+    }
+
+    else REQUIRE(it->order_id < next_id);
+  }
+
+  /* the mid walks a little, so this is loose */
+  CHECK(distance / limits == doctest::Approx(model.mean_distance).epsilon(0.3));
+}
+
+TEST_CASE("cancels only target live orders") {
+  flow::Model model;
+  model.cancel_ratio = 0.98;
+  model.market_share = 0;
+  model.stop_share = 0;
+
+  std::vector<flow::Event> events = flow::Generator(model, 3).generate(50000);
+  std::vector<bool> cancelled;
+
+  for(auto it = events.begin(); it != events.end(); ++it) {
+    if(it->type == flow::event_add)
+      cancelled.push_back(false);
+    else {
+      REQUIRE(!cancelled[it->order_id]);
+      if(it->type == flow::event_cancel) cancelled[it->order_id] = true;
+    }
+  }
+}
+
+TEST_CASE("hawkes arrivals cluster") {
+  flow::Model model;
+  model.arrivals = flow::Model::hawkes;
+
+  std::vector<flow::Event> events = flow::Generator(model, 5).generate(100000);
+
+  /* the stationary rate is rate / (1 - alpha / beta) */
+  double seconds = events.back().ts / 1e9;
+  double expected = model.rate / (1 - model.hawkes_alpha / model.hawkes_beta);
+  CHECK(events.size() / seconds == doctest::Approx(expected).epsilon(0.1));
+
+  /* inter-arrival times are more dispersed than exponential ones */
+  double sum = 0, sum2 = 0;
+  for(size_t i = 1; i < events.size(); ++i) {
+    double gap = (double) (events[i].ts - events[i - 1].ts);
+    sum += gap;
+    sum2 += gap * gap;
+  }
+
+  double n = events.size() - 1;
+  double mean = sum / n;
+  double cv = std::sqrt(sum2 / n - mean * mean) / mean;
+  CHECK(cv > 1.2);
+}
+
+TEST_CASE("price distances") {
+  flow::Model model;
+  model.mid_move_chance = 0;
+  model.market_share = 0;
+  model.stop_share = 0;
+
+  SUBCASE("uniform distances stay below twice the mean") {
+    model.distance = flow::Model::uniform_distance;
+    std::vector<flow::Event> events = flow::Generator(model, 2).generate(10000);
+    for(auto it = events.begin(); it != events.end(); ++it)
+      if(it->type == flow::event_add)
+        REQUIRE(std::fabs(it->price - model.mid) <= 2 * model.mean_distance * model.tick + 1e-9);
+  }
+
+  SUBCASE("power law distances are capped") {
+    model.distance = flow::Model::power_law_distance;
+    model.max_distance = 50;
+    std::vector<flow::Event> events = flow::Generator(model, 2).generate(10000);
+    for(auto it = events.begin(); it != events.end(); ++it)
+      if(it->type == flow::event_add)
+        REQUIRE(std::fabs(it->price - model.mid) <= 50 * model.tick + 1e-9);
+  }
+}
+
+}
@@ -0,0 +1,94 @@
+#include <doctest/doctest.h>
+#include <memory>
+#include <vector>
+
+#include <book/ob.h>
+#include <book/tracker.h>
+#include <book/plugins/self_trade_policy.h>
+#include <book/plugins/stop_orders.h>
+#include <flow/generator.h>
+#include <flow/replay.h>
+
+namespace replay_test {
+
+struct Tracker :
+  public virtual book::BaseTracker<flow::OrderPtr>,
+  public book::plugins::SelfTradePolicyTracker<flow::OrderPtr>
+{
+  Tracker(const flow::OrderPtr& order) :
+    book::BaseTracker<flow::OrderPtr>(order),
+    book::plugins::SelfTradePolicyTracker<flow::OrderPtr>(order) {}
+};
+
+/* counts callbacks by type */
+template <class Storage>
+class Book : public book::BasicOB<Storage, Tracker,
+  book::plugins::SelfTradePolicyPlugin<Tracker>,
+  book::plugins::StopOrdersPlugin<Tracker>>
+{
+public:
+  typedef book::BasicOB<Storage, Tracker,
+    book::plugins::SelfTradePolicyPlugin<Tracker>,
+    book::plugins::StopOrdersPlugin<Tracker>> Base;
+
+  Book() : Base(1) {}
+
+  std::vector<size_t> seen = std::vector<size_t>(32, 0);
+
+protected:
+  void on_callbacks(const typename Base::Callbacks& callbacks) {
+    for(auto it = callbacks.begin(); it != callbacks.end(); ++it)
+      ++seen[it->type];
+  }
+};
+
+TEST_CASE("replay drives any book with the same stream") {
+  flow::Model model;
+  std::vector<flow::Event> events = flow::Generator(model, 42).generate(20000);
+
+  Book<book::MapStorage> map_book;
+  Book<book::LadderStorage> ladder_book;
+
+  flow::ReplayStats map_stats, ladder_stats;
+  flow::replay(map_book, events, map_stats);
+  flow::replay(ladder_book, events, ladder_stats);
+
+  size_t adds = 0, cancels = 0, replaces = 0;
+  for(auto it = events.begin(); it != events.end(); ++it) {
+    if(it->type == flow::event_add) ++adds;
+    else if(it->type == flow::event_cancel) ++cancels;
+    else ++replaces;
+  }
+
+  CHECK(map_stats.events == events.size());
+  CHECK(map_stats.count(flow::event_add) == adds);
+  CHECK(map_stats.count(flow::event_cancel) == cancels);
+  CHECK(map_stats.count(flow::event_replace) == replaces);
+  CHECK(map_stats.events_per_second() > 0);
+  CHECK(map_stats.latency[flow::event_add].percentile(99) > 0);
+
+  /* storage engines match alike */
+  CHECK(map_book.seen == ladder_book.seen);
+  CHECK(map_book.order_count() == ladder_book.order_count());
+  CHECK(map_book.order_count() > 0);
+  CHECK(map_book.seen[Book<book::MapStorage>::TypedCallback::cb_trade] > 0);
+}
+
+TEST_CASE("replay with an order factory") {
+  flow::Model model;
+  model.stop_share = 0;
+  std::vector<flow::Event> events = flow::Generator(model, 9).generate(1000);
+
+  Book<book::LadderStorage> book;
+  flow::ReplayStats stats;
+  size_t made = 0;
+
+  flow::replay(book, events, stats, [&](const flow::Event& event) {
+    ++made;
+    return std::make_shared<flow::Order>(event);
+  });
+
+  CHECK(made == stats.count(flow::event_add));
+}
+
+}